@@ -0,0 +1,602 @@
+/*******************************************************************************
+ * Program:    AES-256-GCM pre zabezpeceny prenos suborov
+ * Subor:      aes_gcm.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia AES-256-GCM pomocou instrukcii AES-NI a PCLMULQDQ:
+ *     - AES-CTR sifruje 8 blokov naraz, aby sa prekryli latencie AESENC
+ *     - GHASH spracuje 8 blokov s mocninami H^8..H^1 a jednou redukciou
+ *     - S VAES a VPCLMULQDQ (AVX-512) sa spracuje 16 blokov v 4 registroch
+ *     - Funkcie su kompilovane s atributom target, takze predvolene
+ *       prepinace kompilatora ostavaju prenosne a podpora sa overi za behu
+ *     - Jadra sa vyberaju podla urovne jadier Monocypher (crypto_cpu_select),
+ *       uroven portable AES-256-GCM vypne; vybrane jadra overi znamy vysledok
+ *
+ * Zavislosti:
+ *     - aes_gcm.h (deklaracie funkcii)
+ *     - Monocypher 4.0.2 (porovnanie tagov v konstantnom case, mazanie)
+ ******************************************************************************/
+
+#include <string.h> // Kniznica pre pracu s pamatou (memcpy, memset)
+
+#include "aes_gcm.h"    // Deklaracie funkcii AES-256-GCM
+#include "monocypher.h" // Pre crypto_verify16 a crypto_wipe
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h> // Intrinsics pre AES-NI, PCLMULQDQ a SSSE3
+
+#define AES_GCM_TARGET __attribute__((target("aes,pclmul,ssse3")))
+#define AES_GCM_TARGET_VAES __attribute__((target("aes,pclmul,ssse3,avx512f,avx512bw,vaes,vpclmulqdq")))
+
+// Obrati poradie bajtov v bloku - GHASH potom pracuje s bezne usporiadanymi bitmi
+#define BSWAP_MASK _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+
+#define AES_GCM_BATCH 8       // Pocet blokov spracovanych v jednom kroku
+#define AES_GCM_WIDE_BATCH 16 // Pocet blokov v jednom kroku s VAES (4 bloky v registri)
+
+// Jadra AES-256-GCM
+#define AES_GCM_KERNEL_AUTO -1 // Este nevybrane - pouzije sa najrychlejsie, ktore procesor podporuje
+#define AES_GCM_KERNEL_NONE 0  // Bez jadier, AES-256-GCM sa neponuka
+#define AES_GCM_KERNEL_AESNI 1 // AES-NI a PCLMULQDQ, 8 blokov naraz
+#define AES_GCM_KERNEL_VAES 2  // VAES a VPCLMULQDQ, 16 blokov naraz
+
+static int aes_gcm_kernel = AES_GCM_KERNEL_AUTO; // Vybrane jadra (aes_gcm_select)
+
+// Najrychlejsie jadra, ktore procesor podporuje
+static int aes_gcm_cpu_kernel(void)
+{
+    if (!__builtin_cpu_supports("aes") || !__builtin_cpu_supports("pclmul") || !__builtin_cpu_supports("ssse3"))
+    {
+        return AES_GCM_KERNEL_NONE;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("vaes") && __builtin_cpu_supports("vpclmulqdq"))
+    {
+        return AES_GCM_KERNEL_VAES;
+    }
+    return AES_GCM_KERNEL_AESNI;
+}
+
+// Aktualne jadra (bez volania aes_gcm_select najrychlejsie)
+static int aes_gcm_selected(void)
+{
+    if (aes_gcm_kernel == AES_GCM_KERNEL_AUTO)
+    {
+        aes_gcm_kernel = aes_gcm_cpu_kernel();
+    }
+    return aes_gcm_kernel;
+}
+
+// Vyber jadier podla urovne z crypto_cpu_impl(): portable vypne AES-256-GCM,
+// sse a avx2 pouziju AES-NI, avx512 aj VAES (ak ich procesor ma)
+void aes_gcm_select(const char *impl)
+{
+    int cpu = aes_gcm_cpu_kernel();
+    if (strcmp(impl, "portable") == 0)
+    {
+        aes_gcm_kernel = AES_GCM_KERNEL_NONE;
+    }
+    else if (strcmp(impl, "avx512") == 0)
+    {
+        aes_gcm_kernel = cpu;
+    }
+    else
+    {
+        aes_gcm_kernel = (cpu < AES_GCM_KERNEL_AESNI) ? cpu : AES_GCM_KERNEL_AESNI;
+    }
+}
+
+int aes_gcm_supported(void)
+{
+    return aes_gcm_selected() != AES_GCM_KERNEL_NONE;
+}
+
+// Jeden krok rozvinutia kluca: key ^ (key << 32) ^ (key << 64) ^ (key << 96) ^ assist
+AES_GCM_TARGET
+static __m128i aes_expand_step(__m128i key, __m128i assist)
+{
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+// Parne kluce kol pouzivaju RotWord+SubWord a rcon, neparne iba SubWord
+#define AES_EXPAND_EVEN(rk, i, rcon) \
+    rk[i] = aes_expand_step(rk[i - 2], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[i - 1], rcon), 0xff))
+#define AES_EXPAND_ODD(rk, i) \
+    rk[i] = aes_expand_step(rk[i - 2], _mm_shuffle_epi32(_mm_aeskeygenassist_si128(rk[i - 1], 0x00), 0xaa))
+
+// Zasifruje jeden blok rozvinutym klucom
+AES_GCM_TARGET
+static __m128i aes_encrypt_block(const __m128i rk[AES_GCM_ROUNDS + 1], __m128i block)
+{
+    block = _mm_xor_si128(block, rk[0]);
+#pragma GCC unroll 13
+    for (int r = 1; r < AES_GCM_ROUNDS; r++)
+    {
+        block = _mm_aesenc_si128(block, rk[r]);
+    }
+    return _mm_aesenclast_si128(block, rk[AES_GCM_ROUNDS]);
+}
+
+// Pripocita nezredukovany 256-bitovy sucin a * b k (lo, mid, hi)
+// Stredna cast sa k lo a hi prida az pri redukcii, takze sa da scitat cez viac blokov
+AES_GCM_TARGET
+static void ghash_mul_acc(__m128i *lo, __m128i *mid, __m128i *hi, __m128i a, __m128i b)
+{
+    *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(a, b, 0x00));
+    *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(a, b, 0x11));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x01));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x10));
+}
+
+// Zredukuje sucet sucinov modulo x^128 + x^7 + x^2 + x + 1
+// Bity GCM su v obratenom poradi, preto sa sucin najprv posunie o 1 bit dolava
+// Vzdy inline - volanie z VAES kodu by inak miesalo SSE a AVX-512 instrukcie
+AES_GCM_TARGET __attribute__((always_inline))
+static inline __m128i ghash_reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    // Posun 256-bitoveho cisla (hi:lo) o 1 bit dolava
+    __m128i carry_lo = _mm_srli_epi32(lo, 31);
+    __m128i carry_hi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    hi = _mm_or_si128(hi, _mm_srli_si128(carry_lo, 12));
+    hi = _mm_or_si128(hi, _mm_slli_si128(carry_hi, 4));
+    lo = _mm_or_si128(lo, _mm_slli_si128(carry_lo, 4));
+
+    // Redukcia dolnej polovice do hornej
+    __m128i t = _mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30));
+    t = _mm_xor_si128(t, _mm_slli_epi32(lo, 25));
+    __m128i t_hi = _mm_srli_si128(t, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+
+    __m128i u = _mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2));
+    u = _mm_xor_si128(u, _mm_srli_epi32(lo, 7));
+    u = _mm_xor_si128(u, t_hi);
+    lo = _mm_xor_si128(lo, u);
+    return _mm_xor_si128(hi, lo);
+}
+
+// Sucin dvoch prvkov GF(2^128)
+AES_GCM_TARGET
+static __m128i ghash_mul(__m128i a, __m128i b)
+{
+    __m128i lo = _mm_setzero_si128();
+    __m128i mid = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    ghash_mul_acc(&lo, &mid, &hi, a, b);
+    return ghash_reduce(lo, mid, hi);
+}
+
+// Prida cele 16-bajtove bloky do stavu GHASH x
+// Po 8 blokoch: x = (x ^ B0) * H^8 ^ B1 * H^7 ^ ... ^ B7 * H, s jedinou redukciou
+AES_GCM_TARGET
+static __m128i ghash_blocks(const aes_gcm_ctx_t *ctx, __m128i x, const uint8_t *in, size_t nb_blocks)
+{
+    const __m128i bswap = BSWAP_MASK;
+    __m128i h[AES_GCM_BATCH];
+    for (int i = 0; i < AES_GCM_BATCH; i++)
+    {
+        h[i] = _mm_loadu_si128((const __m128i *)ctx->h_powers[i]);
+    }
+
+    while (nb_blocks >= AES_GCM_BATCH)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i mid = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+#pragma GCC unroll 8
+        for (int i = 0; i < AES_GCM_BATCH; i++)
+        {
+            __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + 16 * i)), bswap);
+            if (i == 0)
+            {
+                b = _mm_xor_si128(b, x);
+            }
+            ghash_mul_acc(&lo, &mid, &hi, b, h[AES_GCM_BATCH - 1 - i]);
+        }
+        x = ghash_reduce(lo, mid, hi);
+        in += 16 * AES_GCM_BATCH;
+        nb_blocks -= AES_GCM_BATCH;
+    }
+
+    while (nb_blocks > 0)
+    {
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), bswap);
+        x = ghash_mul(_mm_xor_si128(x, b), h[0]);
+        in += 16;
+        nb_blocks--;
+    }
+    return x;
+}
+
+// Prida lubovolne dlhe data do stavu GHASH, posledny blok doplni nulami
+AES_GCM_TARGET
+static __m128i ghash_bytes(const aes_gcm_ctx_t *ctx, __m128i x, const uint8_t *in, size_t size)
+{
+    x = ghash_blocks(ctx, x, in, size / 16);
+    size_t rest = size % 16;
+    if (rest > 0)
+    {
+        uint8_t block[16] = {0};
+        memcpy(block, in + size - rest, rest);
+        x = ghash_blocks(ctx, x, block, 1);
+    }
+    return x;
+}
+
+AES_GCM_TARGET
+void aes_gcm_init(aes_gcm_ctx_t *ctx, const uint8_t key[AES_GCM_KEY_SIZE])
+{
+    __m128i rk[AES_GCM_ROUNDS + 1];
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    rk[1] = _mm_loadu_si128((const __m128i *)(key + 16));
+    AES_EXPAND_EVEN(rk, 2, 0x01);
+    AES_EXPAND_ODD(rk, 3);
+    AES_EXPAND_EVEN(rk, 4, 0x02);
+    AES_EXPAND_ODD(rk, 5);
+    AES_EXPAND_EVEN(rk, 6, 0x04);
+    AES_EXPAND_ODD(rk, 7);
+    AES_EXPAND_EVEN(rk, 8, 0x08);
+    AES_EXPAND_ODD(rk, 9);
+    AES_EXPAND_EVEN(rk, 10, 0x10);
+    AES_EXPAND_ODD(rk, 11);
+    AES_EXPAND_EVEN(rk, 12, 0x20);
+    AES_EXPAND_ODD(rk, 13);
+    AES_EXPAND_EVEN(rk, 14, 0x40);
+    for (int r = 0; r <= AES_GCM_ROUNDS; r++)
+    {
+        _mm_storeu_si128((__m128i *)ctx->round_keys[r], rk[r]);
+    }
+
+    // H = AES(K, 0), mocniny H^1..H^16 pre spracovanie viacerych blokov naraz
+    __m128i h = _mm_shuffle_epi8(aes_encrypt_block(rk, _mm_setzero_si128()), BSWAP_MASK);
+    __m128i power = h;
+    for (int i = 0; i < AES_GCM_H_POWERS; i++)
+    {
+        _mm_storeu_si128((__m128i *)ctx->h_powers[i], power);
+        power = ghash_mul(power, h);
+    }
+
+    ctx->wide = (aes_gcm_selected() == AES_GCM_KERNEL_VAES);
+
+    crypto_wipe(rk, sizeof(rk));
+    crypto_wipe(&h, sizeof(h));
+    crypto_wipe(&power, sizeof(power));
+}
+
+// Vrati 128-bitovy XOR styroch 128-bitovych casti registra
+AES_GCM_TARGET_VAES
+static __m128i fold_lanes(__m512i v)
+{
+    __m128i a = _mm_xor_si128(_mm512_extracti32x4_epi32(v, 0), _mm512_extracti32x4_epi32(v, 1));
+    __m128i b = _mm_xor_si128(_mm512_extracti32x4_epi32(v, 2), _mm512_extracti32x4_epi32(v, 3));
+    return _mm_xor_si128(a, b);
+}
+
+// Hlavna cast textu po 16 blokoch s VAES a VPCLMULQDQ
+// Pokracuje v citaci a stave GHASH z aes_gcm_crypt a vrati pocet spracovanych bajtov
+AES_GCM_TARGET_VAES
+static size_t aes_gcm_crypt_wide(const aes_gcm_ctx_t *ctx, uint8_t *out, const uint8_t *in, size_t text_size,
+                                 __m128i *counter, __m128i *x, int decrypt)
+{
+    const __m512i bswap = _mm512_broadcast_i32x4(BSWAP_MASK);
+    const __m512i four = _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4, 0, 0, 0, 4);
+    __m512i rk[AES_GCM_ROUNDS + 1];
+    for (int r = 0; r <= AES_GCM_ROUNDS; r++)
+    {
+        rk[r] = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)ctx->round_keys[r]));
+    }
+
+    // Register k obsahuje bloky 4k..4k+3, ktore sa nasobia H^(16-4k)..H^(13-4k)
+    __m512i h[AES_GCM_WIDE_BATCH / 4];
+#pragma GCC unroll 4
+    for (int k = 0; k < AES_GCM_WIDE_BATCH / 4; k++)
+    {
+        h[k] = _mm512_setzero_si512();
+        h[k] = _mm512_inserti32x4(h[k], _mm_loadu_si128((const __m128i *)ctx->h_powers[15 - 4 * k]), 0);
+        h[k] = _mm512_inserti32x4(h[k], _mm_loadu_si128((const __m128i *)ctx->h_powers[14 - 4 * k]), 1);
+        h[k] = _mm512_inserti32x4(h[k], _mm_loadu_si128((const __m128i *)ctx->h_powers[13 - 4 * k]), 2);
+        h[k] = _mm512_inserti32x4(h[k], _mm_loadu_si128((const __m128i *)ctx->h_powers[12 - 4 * k]), 3);
+    }
+
+    // Casti registra maju citace counter+1..counter+4
+    __m512i ctr = _mm512_add_epi32(_mm512_broadcast_i32x4(*counter),
+                                   _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 1));
+    __m128i acc = *x;
+    size_t offset = 0;
+    while (text_size - offset >= 16 * AES_GCM_WIDE_BATCH)
+    {
+        __m512i b[AES_GCM_WIDE_BATCH / 4];
+        __m512i d[AES_GCM_WIDE_BATCH / 4];
+#pragma GCC unroll 4
+        for (int k = 0; k < AES_GCM_WIDE_BATCH / 4; k++)
+        {
+            b[k] = _mm512_xor_si512(_mm512_shuffle_epi8(ctr, bswap), rk[0]);
+            ctr = _mm512_add_epi32(ctr, four);
+            d[k] = _mm512_loadu_si512((const void *)(in + offset + 64 * k));
+        }
+#pragma GCC unroll 13
+        for (int r = 1; r < AES_GCM_ROUNDS; r++)
+        {
+#pragma GCC unroll 4
+            for (int k = 0; k < AES_GCM_WIDE_BATCH / 4; k++)
+            {
+                b[k] = _mm512_aesenc_epi128(b[k], rk[r]);
+            }
+        }
+#pragma GCC unroll 4
+        for (int k = 0; k < AES_GCM_WIDE_BATCH / 4; k++)
+        {
+            b[k] = _mm512_xor_si512(_mm512_aesenclast_epi128(b[k], rk[AES_GCM_ROUNDS]), d[k]);
+            _mm512_storeu_si512((void *)(out + offset + 64 * k), b[k]);
+        }
+
+        // GHASH zo zasifrovanych blokov - pri desifrovani su to vstupy d, pri sifrovani vystupy b
+        __m512i lo = _mm512_setzero_si512();
+        __m512i mid = _mm512_setzero_si512();
+        __m512i hi = _mm512_setzero_si512();
+#pragma GCC unroll 4
+        for (int k = 0; k < AES_GCM_WIDE_BATCH / 4; k++)
+        {
+            __m512i c = _mm512_shuffle_epi8(decrypt ? d[k] : b[k], bswap);
+            if (k == 0)
+            {
+                c = _mm512_xor_si512(c, _mm512_inserti32x4(_mm512_setzero_si512(), acc, 0));
+            }
+            lo = _mm512_xor_si512(lo, _mm512_clmulepi64_epi128(c, h[k], 0x00));
+            hi = _mm512_xor_si512(hi, _mm512_clmulepi64_epi128(c, h[k], 0x11));
+            mid = _mm512_xor_si512(mid, _mm512_clmulepi64_epi128(c, h[k], 0x01));
+            mid = _mm512_xor_si512(mid, _mm512_clmulepi64_epi128(c, h[k], 0x10));
+        }
+        acc = ghash_reduce(fold_lanes(lo), fold_lanes(mid), fold_lanes(hi));
+        offset += 16 * AES_GCM_WIDE_BATCH;
+    }
+
+    // Posledny pouzity citac je o 1 mensi nez najnizsia cast registra
+    *counter = _mm_sub_epi32(_mm512_castsi512_si128(ctr), _mm_set_epi32(0, 0, 0, 1));
+    *x = acc;
+    crypto_wipe(rk, sizeof(rk));
+    return offset;
+}
+
+// Spolocna cast sifrovania a desifrovania - CTR a GHASH v jednom prechode
+// Pri desifrovani sa GHASH pocita zo vstupu skor, nez sa prepise, takze funguje aj in-place
+AES_GCM_TARGET
+static void aes_gcm_crypt(const aes_gcm_ctx_t *ctx, uint8_t *out, uint8_t tag[AES_GCM_TAG_SIZE],
+                          const uint8_t nonce[AES_GCM_NONCE_SIZE], const uint8_t *ad, size_t ad_size,
+                          const uint8_t *in, size_t text_size, int decrypt)
+{
+    const __m128i bswap = BSWAP_MASK;
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    __m128i rk[AES_GCM_ROUNDS + 1];
+    for (int r = 0; r <= AES_GCM_ROUNDS; r++)
+    {
+        rk[r] = _mm_loadu_si128((const __m128i *)ctx->round_keys[r]);
+    }
+
+    // J0 = nonce || 0x00000001, data sa sifruju od hodnoty citaca 2
+    uint8_t j0_bytes[16] = {0};
+    memcpy(j0_bytes, nonce, AES_GCM_NONCE_SIZE);
+    j0_bytes[15] = 1;
+    __m128i j0 = _mm_loadu_si128((const __m128i *)j0_bytes);
+    __m128i counter = _mm_shuffle_epi8(j0, bswap); // 32-bitovy citac v najnizsom slove
+
+    __m128i x = ghash_bytes(ctx, _mm_setzero_si128(), ad, ad_size);
+
+    size_t offset = 0;
+    if (ctx->wide && text_size >= 16 * AES_GCM_WIDE_BATCH)
+    {
+        offset = aes_gcm_crypt_wide(ctx, out, in, text_size, &counter, &x, decrypt);
+    }
+    while (text_size - offset >= 16 * AES_GCM_BATCH)
+    {
+        __m128i b[AES_GCM_BATCH];
+#pragma GCC unroll 8
+        for (int i = 0; i < AES_GCM_BATCH; i++)
+        {
+            counter = _mm_add_epi32(counter, one);
+            b[i] = _mm_xor_si128(_mm_shuffle_epi8(counter, bswap), rk[0]);
+        }
+#pragma GCC unroll 13
+        for (int r = 1; r < AES_GCM_ROUNDS; r++)
+        {
+#pragma GCC unroll 8
+            for (int i = 0; i < AES_GCM_BATCH; i++)
+            {
+                b[i] = _mm_aesenc_si128(b[i], rk[r]);
+            }
+        }
+        if (decrypt)
+        {
+            x = ghash_blocks(ctx, x, in + offset, AES_GCM_BATCH);
+        }
+#pragma GCC unroll 8
+        for (int i = 0; i < AES_GCM_BATCH; i++)
+        {
+            __m128i data = _mm_loadu_si128((const __m128i *)(in + offset + 16 * i));
+            b[i] = _mm_xor_si128(_mm_aesenclast_si128(b[i], rk[AES_GCM_ROUNDS]), data);
+            _mm_storeu_si128((__m128i *)(out + offset + 16 * i), b[i]);
+        }
+        if (!decrypt)
+        {
+            x = ghash_blocks(ctx, x, out + offset, AES_GCM_BATCH);
+        }
+        offset += 16 * AES_GCM_BATCH;
+    }
+
+    // Zvysne bloky po jednom, posledny moze byt neuplny
+    uint8_t block[16];
+    while (offset < text_size)
+    {
+        size_t n = (text_size - offset < 16) ? text_size - offset : 16;
+        counter = _mm_add_epi32(counter, one);
+        __m128i keystream = aes_encrypt_block(rk, _mm_shuffle_epi8(counter, bswap));
+
+        memset(block, 0, sizeof(block));
+        memcpy(block, in + offset, n);
+        if (decrypt)
+        {
+            x = ghash_blocks(ctx, x, block, 1);
+        }
+        __m128i data = _mm_xor_si128(_mm_loadu_si128((const __m128i *)block), keystream);
+        _mm_storeu_si128((__m128i *)block, data);
+        memset(block + n, 0, sizeof(block) - n);
+        if (!decrypt)
+        {
+            x = ghash_blocks(ctx, x, block, 1);
+        }
+        memcpy(out + offset, block, n);
+        offset += n;
+    }
+
+    // Posledny blok GHASH: dlzky AD a textu v bitoch (po obrateni bajtov AD v hornej polovici)
+    __m128i lengths = _mm_set_epi64x((long long)((uint64_t)ad_size * 8), (long long)((uint64_t)text_size * 8));
+    x = ghash_mul(_mm_xor_si128(x, lengths), _mm_loadu_si128((const __m128i *)ctx->h_powers[0]));
+
+    __m128i t = _mm_xor_si128(_mm_shuffle_epi8(x, bswap), aes_encrypt_block(rk, j0));
+    _mm_storeu_si128((__m128i *)tag, t);
+
+    crypto_wipe(rk, sizeof(rk));
+    crypto_wipe(block, sizeof(block));
+}
+
+void aes_gcm_encrypt(const aes_gcm_ctx_t *ctx, uint8_t *cipher_text, uint8_t tag[AES_GCM_TAG_SIZE],
+                     const uint8_t nonce[AES_GCM_NONCE_SIZE], const uint8_t *ad, size_t ad_size,
+                     const uint8_t *plain_text, size_t text_size)
+{
+    aes_gcm_crypt(ctx, cipher_text, tag, nonce, ad, ad_size, plain_text, text_size, 0);
+}
+
+int aes_gcm_decrypt(const aes_gcm_ctx_t *ctx, uint8_t *plain_text, const uint8_t tag[AES_GCM_TAG_SIZE],
+                    const uint8_t nonce[AES_GCM_NONCE_SIZE], const uint8_t *ad, size_t ad_size,
+                    const uint8_t *cipher_text, size_t text_size)
+{
+    uint8_t real_tag[AES_GCM_TAG_SIZE];
+    aes_gcm_crypt(ctx, plain_text, real_tag, nonce, ad, ad_size, cipher_text, text_size, 1);
+    int mismatch = crypto_verify16(tag, real_tag);
+    if (mismatch)
+    {
+        // Neovereny otvoreny text sa nikdy nevrati volajucemu
+        crypto_wipe(plain_text, text_size);
+    }
+    crypto_wipe(real_tag, sizeof(real_tag));
+    return mismatch;
+}
+
+// Vstupy testu: dlzka pokryje 16-blokove aj 8-blokove kroky a neuplny posledny blok
+#define AES_GCM_TEST_SIZE (3 * 1024 + 512 + 77)
+#define AES_GCM_TEST_AD_SIZE 13
+
+// Porovnanie vybranych jadier so znamym vysledkom (tag z nezavislej implementacie)
+// Pri VAES sa overi aj cesta s AES-NI, ktora spracuje zvysok textu
+// Navratova hodnota: 0 ak sa zhoduju (alebo AES-256-GCM nie je vybrane), -1 inak
+int aes_gcm_self_test(void)
+{
+    static const uint8_t expected_tag[AES_GCM_TAG_SIZE] = {
+        0x55, 0xad, 0x52, 0x0c, 0x75, 0xdd, 0xdb, 0x7d, 0x87, 0xfa, 0x0f, 0x2e, 0xc8, 0xa9, 0xc3, 0x4f};
+    static const uint8_t expected_start[16] = {
+        0x56, 0xda, 0xe9, 0x5a, 0xd9, 0xf7, 0xdb, 0xce, 0x92, 0xe4, 0x0d, 0x09, 0x56, 0xee, 0xb3, 0x67};
+    int kernel = aes_gcm_selected();
+    if (kernel == AES_GCM_KERNEL_NONE)
+    {
+        return 0;
+    }
+
+    uint8_t text[AES_GCM_TEST_SIZE];
+    uint8_t out[AES_GCM_TEST_SIZE];
+    uint8_t key[AES_GCM_KEY_SIZE];
+    uint8_t nonce[AES_GCM_NONCE_SIZE];
+    uint8_t tag[AES_GCM_TAG_SIZE];
+    for (size_t i = 0; i < sizeof(text); i++)
+    {
+        text[i] = (uint8_t)(i * 131 + 7);
+    }
+    for (size_t i = 0; i < sizeof(key); i++)
+    {
+        key[i] = (uint8_t)(i * 17 + 3);
+    }
+    for (size_t i = 0; i < sizeof(nonce); i++)
+    {
+        nonce[i] = (uint8_t)(i * 29 + 5);
+    }
+
+    aes_gcm_ctx_t ctx;
+    aes_gcm_init(&ctx, key);
+    int result = 0;
+    for (int wide = 0; wide <= (kernel == AES_GCM_KERNEL_VAES); wide++)
+    {
+        ctx.wide = wide;
+        aes_gcm_encrypt(&ctx, out, tag, nonce, text, AES_GCM_TEST_AD_SIZE, text, sizeof(text));
+        result |= crypto_verify16(tag, expected_tag) | crypto_verify16(out, expected_start);
+        result |= aes_gcm_decrypt(&ctx, out, tag, nonce, text, AES_GCM_TEST_AD_SIZE, out, sizeof(out));
+        result |= (memcmp(out, text, sizeof(text)) != 0) ? -1 : 0;
+    }
+    aes_gcm_wipe(&ctx);
+    return result;
+}
+
+#else // Bez AES-NI - sada AES-256-GCM sa nikdy nedohodne
+
+void aes_gcm_select(const char *impl)
+{
+    (void)impl;
+}
+
+int aes_gcm_supported(void)
+{
+    return 0;
+}
+
+int aes_gcm_self_test(void)
+{
+    return 0;
+}
+
+void aes_gcm_init(aes_gcm_ctx_t *ctx, const uint8_t key[AES_GCM_KEY_SIZE])
+{
+    (void)key;
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void aes_gcm_encrypt(const aes_gcm_ctx_t *ctx, uint8_t *cipher_text, uint8_t tag[AES_GCM_TAG_SIZE],
+                     const uint8_t nonce[AES_GCM_NONCE_SIZE], const uint8_t *ad, size_t ad_size,
+                     const uint8_t *plain_text, size_t text_size)
+{
+    (void)ctx;
+    (void)nonce;
+    (void)ad;
+    (void)ad_size;
+    (void)plain_text;
+    memset(cipher_text, 0, text_size);
+    memset(tag, 0, AES_GCM_TAG_SIZE);
+}
+
+int aes_gcm_decrypt(const aes_gcm_ctx_t *ctx, uint8_t *plain_text, const uint8_t tag[AES_GCM_TAG_SIZE],
+                    const uint8_t nonce[AES_GCM_NONCE_SIZE], const uint8_t *ad, size_t ad_size,
+                    const uint8_t *cipher_text, size_t text_size)
+{
+    (void)ctx;
+    (void)tag;
+    (void)nonce;
+    (void)ad;
+    (void)ad_size;
+    (void)cipher_text;
+    memset(plain_text, 0, text_size);
+    return -1;
+}
+
+#endif
+
+void aes_gcm_wipe(aes_gcm_ctx_t *ctx)
+{
+    crypto_wipe(ctx, sizeof(*ctx));
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Program:    AES-256-GCM pre zabezpeceny prenos suborov
+ * Subor:      aes_gcm.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre sifrovanie s autentizaciou AES-256-GCM:
+ *     - Zistenie podpory instrukcii AES-NI a PCLMULQDQ (pripadne VAES) za behu
+ *     - Rozvinutie kluca a predvypocet mocnin H pre GHASH
+ *     - Sifrovanie a desifrovanie s overenim autentizacneho tagu
+ *
+ * Zavislosti:
+ *     - Standardne C kniznice
+ *     - Procesor x86 s AES-NI a PCLMULQDQ (inak aes_gcm_supported() vrati 0)
+ ******************************************************************************/
+
+#ifndef AES_GCM_H
+#define AES_GCM_H
+
+#include <stddef.h> // Kniznica pre typ size_t
+#include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t)
+
+#define AES_GCM_KEY_SIZE 32   // Velkost kluca AES-256 v bajtoch
+#define AES_GCM_NONCE_SIZE 12 // Velkost nonce (IV) v bajtoch (96 bitov)
+#define AES_GCM_TAG_SIZE 16   // Velkost autentizacneho tagu v bajtoch
+#define AES_GCM_ROUNDS 14     // Pocet kol AES-256
+#define AES_GCM_H_POWERS 16   // Kolko blokov GHASH spracuje naraz (H^1..H^16)
+
+// Kontext pre jeden kluc - staci ho pripravit raz a pouzit pre vsetky bloky
+typedef struct
+{
+    uint8_t round_keys[AES_GCM_ROUNDS + 1][16]; // Rozvinuty kluc AES-256
+    uint8_t h_powers[AES_GCM_H_POWERS][16];     // Mocniny H^1..H^16 pre GHASH (s obratenym poradim bajtov)
+    int wide;                                   // 1 ak procesor ma VAES a VPCLMULQDQ (16 blokov naraz)
+} aes_gcm_ctx_t;
+
+void aes_gcm_select(const char *impl); // Vyberie jadra podla urovne z crypto_cpu_impl() (portable = vypnute)
+int aes_gcm_supported(void);           // Vrati 1, ak su vybrane jadra (procesor ma AES-NI a PCLMULQDQ)
+int aes_gcm_self_test(void);           // Overi vybrane jadra na znamom vysledku, -1 pri chybe
+
+// Funkcie su dostupne iba ak aes_gcm_supported() vrati 1
+void aes_gcm_init(aes_gcm_ctx_t *ctx, const uint8_t key[AES_GCM_KEY_SIZE]); // Pripravi kontext pre kluc
+void aes_gcm_wipe(aes_gcm_ctx_t *ctx);                                     // Bezpecne vymaze kontext
+
+void aes_gcm_encrypt(const aes_gcm_ctx_t *ctx, uint8_t *cipher_text, // Zasifruje a vypocita tag
+                     uint8_t tag[AES_GCM_TAG_SIZE],
+                     const uint8_t nonce[AES_GCM_NONCE_SIZE],
+                     const uint8_t *ad, size_t ad_size,
+                     const uint8_t *plain_text, size_t text_size);
+
+int aes_gcm_decrypt(const aes_gcm_ctx_t *ctx, uint8_t *plain_text, // Overi tag a desifruje (-1 pri zlom tagu)
+                    const uint8_t tag[AES_GCM_TAG_SIZE],
+                    const uint8_t nonce[AES_GCM_NONCE_SIZE],
+                    const uint8_t *ad, size_t ad_size,
+                    const uint8_t *cipher_text, size_t text_size);
+
+#endif // AES_GCM_H
@@ -1,10 +1,10 @@
 @echo off
 echo Building server...
-gcc -Wall -Wextra -O2 -o server.exe server.c monocypher.c siete.c crypto_utils.c sake.c platform.c -lws2_32 -lbcrypt
+gcc -Wall -Wextra -O2 -o server.exe server.c reactor.c kdf_scheduler.c credentials.c monocypher.c aes_gcm.c siete.c crypto_utils.c sake.c platform.c pipeline.c io_ring.c task_pool.c -lws2_32 -lbcrypt
 if %ERRORLEVEL% neq 0 goto error
 
 echo Building client...
-gcc -Wall -Wextra -O2 -o client.exe client.c monocypher.c siete.c crypto_utils.c sake.c platform.c -lws2_32 -lbcrypt
+gcc -Wall -Wextra -O2 -o client.exe client.c monocypher.c aes_gcm.c siete.c crypto_utils.c sake.c platform.c pipeline.c io_ring.c task_pool.c -lws2_32 -lbcrypt
 if %ERRORLEVEL% neq 0 goto error
 
 echo Build successful!
@@ -10,7 +10,7 @@
  *     - Vytvorenie TCP spojenia so serverom
  *     - Autentizaciu pomocou SAKE protokolu (Symmetric Authenticated Key Exchange)
  *     - Generovanie a odoslanie kryptografickych materialov pre ustanovenie relacie
- *     - Sifrovanie a odosielanie suborov pomocou ChaCha20-Poly1305
+ *     - Sifrovanie a odosielanie suborov dohodnutou sadou (AES-256-GCM alebo XChaCha20-Poly1305)
  *     - Automaticku rotaciu klucov pocas prenosu pre zvysenu bezpecnost
  *     - Doprednu ochranu pomocou jednosmernej evolucii klucov
  *
@@ -34,15 +34,35 @@
 #include "crypto_utils.h" // Pre kryptograficke funkcie
 #include "sake.h"         // Pre SAKE protokol
 #include "platform.h"     // Pre funkcie specificke pre operacny system
+#include "pipeline.h"     // Pre viacvlaknove odosielanie suboru
 
 // Globalne premenne pre kryptograficke operacie
 // Tieto premenne sa pouzivaju v celom programe pre sifrovacie operacie
 uint8_t key[KEY_SIZE];      // Hlavny sifrovaci kluc
-uint8_t nonce[NONCE_SIZE];  // Jednorazova hodnota pre kazdy blok
 uint8_t salt[SALT_SIZE];    // Sol pre derivaciu kluca
 sake_key_chain_t key_chain; // Struktura retazca klucov pre SAKE
 
-int main()
+// Stav zobrazenia progresu prenosu
+typedef struct
+{
+    uint64_t total_bytes;          // Pocet odoslanych bajtov
+    uint64_t last_progress_update; // Pocet bajtov pri poslednom vypise
+} transfer_progress_t;
+
+// Aktualizacia zobrazenia progresu prenosu po odoslani bloku
+static void print_transfer_progress(void *arg, size_t bytes)
+{
+    transfer_progress_t *progress = (transfer_progress_t *)arg;
+    progress->total_bytes += bytes;
+    if (progress->total_bytes - progress->last_progress_update >= PROGRESS_UPDATE_INTERVAL)
+    {
+        printf(LOG_PROGRESS_FORMAT, "Sent", (float)progress->total_bytes / PROGRESS_UPDATE_INTERVAL);
+        fflush(stdout);
+        progress->last_progress_update = progress->total_bytes;
+    }
+}
+
+int main(int argc, char *argv[])
 {
     // KROK 1: Inicializacia spojenia so serverom
     // - Vytvorenie TCP socketu
@@ -52,6 +72,26 @@ int main()
     int port;
     char port_str[6]; // Max 5 digits + null terminator
 
+    // Vyber a overenie kryptografickych jadier este pred pripojenim
+    if (select_crypto_impl(argc, argv) != 0)
+    {
+        return -1;
+    }
+
+    // Vyber I/O enginu (blokujuce volania alebo io_uring) z prepinaca alebo premennej prostredia
+    int io_engine = io_engine_select(argc, argv);
+    if (io_engine < 0)
+    {
+        return -1;
+    }
+
+    // Pravidla rotacie kluca (predvolene alebo z prepinacov --rotate-*), navrhnu sa serveru
+    rotation_policy_t rotation;
+    if (rotation_policy_from_args(&rotation, argc, argv) != 0)
+    {
+        return -1;
+    }
+
     // Inicializacia sietovej kniznice pre Windows
     initialize_network();
 
@@ -127,23 +167,75 @@ int main()
     }
 
     // KROK 2: Priprava kryptografickych materialov
+    // - Dohodnutie parametrov relacie (pocet liniek Argon2, sifrovacia sada)
     // - Generovanie nahodnej soli (32 bajtov)
     // - Nacitanie hesla od uzivatela
     // - Odvodenie kluca pomocou Argon2
     // - Odoslanie soli serveru
 
+    // Navrhneme tolko liniek, kolko zvladne tento pocitac, server moze navrh znizit
+    // Ponukneme vsetky sifrovacie sady, ktore tento pocitac podporuje, server vyberie jednu
+    // Navrhneme velkost bloku dat, server ju moze iba znizit
+    // Navrhneme pravidla rotacie kluca, server ich moze iba sprisnit
+    session_params_t params;
+    uint8_t transcript[SESSION_TRANSCRIPT_SIZE]; // Navrh a odpoved, ako isli po sieti - potvrdi ich SAKE
+    params.argon2_lanes = argon2_preferred_lanes();
+    params.cipher_suites = aead_supported_suites();
+    params.frame_size = FRAME_SIZE_PREFERRED;
+    params.rotation = rotation;
+    if (negotiate_session_params_client(sock, &params, transcript) < 0)
+    {
+        fprintf(stderr, ERR_HANDSHAKE);
+        cleanup_socket(sock);
+        return -1;
+    }
+    printf(MSG_ARGON2_LANES, params.argon2_lanes);
+    printf(MSG_CIPHER_SUITE, aead_suite_name(params.cipher_suites));
+    printf(MSG_FRAME_SIZE, params.frame_size);
+    printf(MSG_ROTATION_POLICY, params.rotation.frames, params.rotation.mib, params.rotation.ms);
+
+    // Sol servera pre PSK z hesla (rovnaka ako v jeho ulozisti)
+    uint8_t psk_salt[SALT_SIZE];
+    if (receive_psk_salt(sock, psk_salt) < 0)
+    {
+        fprintf(stderr, ERR_HANDSHAKE);
+        cleanup_socket(sock);
+        return -1;
+    }
+
+    // Nacitanie identifikatora klienta - server podla neho najde PSK klienta
+    char client_id[CLIENT_ID_SIZE + 2]; // Identifikator + '\n' + null terminator
+    uint8_t client_id_wire[CLIENT_ID_SIZE];
+    printf(CLIENT_ID_PROMPT);
+    if (fgets(client_id, sizeof(client_id), stdin) == NULL)
+    {
+        fprintf(stderr, ERR_CLIENT_ID_INVALID);
+        cleanup_socket(sock);
+        return -1;
+    }
+    client_id[strcspn(client_id, "\r\n")] = '\0';
+    if (client_id_encode(client_id, client_id_wire) != 0)
+    {
+        fprintf(stderr, ERR_CLIENT_ID_INVALID);
+        cleanup_socket(sock);
+        return -1;
+    }
+
     // Nacitanie hesla od uzivatela a odvodenie hlavneho kluca pomocou Argon2
-    // Heslo sa pouzije na generovanie kluca, ktory sa pouzije na sifrovanie dat
+    // Z hesla, identifikatora a soli servera vznikne PSK (rovnake ako v ulozisti servera), z neho hlavny kluc
+    uint8_t psk[PSK_SIZE];
     char *password = platform_getpass(PASSWORD_PROMPT);
-    if (derive_key_client(password, key, salt) != 0)
+    int psk_result = derive_client_psk(psk, client_id_wire, password, psk_salt, NULL);
+    secure_wipe(password, strlen(password));
+    if (psk_result != 0 || derive_key_client(psk, key, salt, params.argon2_lanes) != 0)
     {
         fprintf(stderr, ERR_KEY_DERIVATION);
         cleanup_socket(sock);
         return -1;
     }
 
-    // Posle salt serveru, aby mohol odvodi rovnaky kluc
-    if (send_salt_to_server(sock, salt) < 0)
+    // Posle identifikator a salt serveru, aby mohol odvodit rovnaky kluc
+    if (send_salt_to_server(sock, client_id_wire, salt) < 0)
     {
         fprintf(stderr, ERR_SALT_SEND);
         cleanup_socket(sock);
@@ -166,6 +258,7 @@ int main()
     uint8_t challenge[SAKE_CHALLENGE_SIZE];       // VYzva prijata od servera
     uint8_t response[SAKE_RESPONSE_SIZE];         // Odpoved vypocitana na vyzvu
     uint8_t session_key[SESSION_KEY_SIZE];        // Kluc relacie
+    key_ratchet_t keys;                           // Kluce epoch relacie pre dohodnutu sifrovaciu sadu
 
     // Inicializacia SAKE key chain pre klienta (iniciator)
     // Odvodi authentication key z master key
@@ -190,7 +283,7 @@ int main()
     }
 
     // Vypocet odpovede na vyzvu - pouziva sa aktualny autentizacny kluc
-    if (compute_response(response, key_chain.auth_key_curr, challenge, server_nonce) != 0)
+    if (compute_response(response, key_chain.auth_key_curr, challenge, server_nonce, transcript) != 0)
     {
         fprintf(stderr, ERR_COMPUTE_RESPONSE);
         cleanup_socket(sock);
@@ -224,7 +317,10 @@ int main()
     }
 
     // Odvodenie kluca relacie z hlavneho kluca a nonce hodnot
-    derive_session_key(session_key, key_chain.master_key, client_nonce, server_nonce);
+    // Kluc relacie je kluc epochy 0, dalej ho drzi uz iba retazec epoch
+    derive_session_key(session_key, key_chain.master_key, client_nonce, server_nonce, transcript);
+    key_ratchet_init(&keys, params.cipher_suites, session_key, key_chain.master_key, client_nonce, server_nonce, 1);
+    secure_wipe(session_key, KEY_SIZE);
 
     // Evolucia klucov po uspesnej autentizacii
     sake_update_key_chain(&key_chain);
@@ -305,7 +401,13 @@ int main()
         return -1;
     }
 
-    if (send_file_name(sock, file_name) < 0)
+    // Server dostane aj velkost suboru, aby mohol vyhradit miesto pre cely subor naraz
+    uint64_t file_size;
+    if (platform_file_size(file, &file_size) != 0)
+    {
+        file_size = FILE_SIZE_UNKNOWN; // Rura alebo zariadenie - velkost sa zisti az na konci
+    }
+    if (send_file_name(sock, file_name, file_size) < 0)
     {
         fprintf(stderr, ERR_FILENAME_SEND, strerror(errno));
         cleanup_socket(sock);
@@ -313,154 +415,51 @@ int main()
     }
 
     // KROK 4: Hlavny cyklus prenosu dat
-    // - Citanie suboru po blokoch (max TRANSFER_BUFFER_SIZE)
-    // - Generovanie noveho nonce pre kazdy blok
-    // - Sifrovanie dat pomocou ChaCha20-Poly1305
+    // - Citanie suboru po blokoch (max dohodnuta velkost bloku params.frame_size)
+    // - Sifrovanie dat dohodnutou sadou (AES-256-GCM alebo XChaCha20-Poly1305)
+    // - Nonce kazdeho bloku je dane jeho poradim v epoche kluca, neposiela sa
     // - Odoslanie zasifrovanych dat na server
-    uint64_t total_bytes = 0;
-    uint64_t block_count = 0;
+    // Citanie, sifrovanie (vo viacerych vlaknach) a odosielanie bezia sucasne v pipeline.c
+    int transfer_failed = 0;
+    transfer_progress_t progress = {0, 0};
     printf(LOG_TRANSFER_START);
 
-    // Vytvorenie bufferov pre prenos - docasne ulozisko pre data
-    uint8_t buffer[TRANSFER_BUFFER_SIZE];     // Buffer pre necifrovane data
-    uint8_t ciphertext[TRANSFER_BUFFER_SIZE]; // Buffer pre zasifrovane data
-    uint8_t tag[TAG_SIZE];                    // Buffer pre overovaci kod (ako digitalny podpis)
-
-    // Premenna pre sledovanie progresu
-    uint64_t last_progress_update = 0;
-
-    // Citanie suboru po blokoch (chunk) a ich sifrovanie
-    // Kazdy blok je sifrovany samostatne, aby sa zabranilo preteceniu pamate pri velkych suboroch
-    size_t bytes_read;
-    while ((bytes_read = fread(buffer, 1, TRANSFER_BUFFER_SIZE, file)) > 0)
+    // Buffery pre bloky v retazci - velkost bloku je dohodnuta pri nadviazani spojenia
+    pipeline_t sender;
+    if (pipeline_init(&sender, params.frame_size, pipeline_worker_count()) != 0)
     {
-        // Rotacia kluca po kazdych KEY_ROTATION_BLOCKS blokoch
-        // Rotacia kluca zvysuje bezpecnost komunikacie tym, ze obmedzuje mnozstvo dat sifrovanych jednym klucom
-        if (block_count > 0 && block_count % KEY_ROTATION_BLOCKS == 0)
-        {
-            printf(MSG_KEY_ROTATION, (unsigned long long)block_count);
-
-            // Signalizacia rotacie kluca serveru
-            if (send_chunk_size_reliable(sock, KEY_ROTATION_MARKER) < 0)
-            {
-                fprintf(stderr, ERR_KEY_ROTATION_ACK);
-                break;
-            }
-
-            // Cakanie na potvrdenie od servera
-            uint32_t ack;
-            if (receive_chunk_size_reliable(sock, &ack) < 0 || ack != KEY_ROTATION_ACK)
-            {
-                fprintf(stderr, ERR_KEY_ROTATION_ACK);
-                break;
-            }
-
-            // Generovanie novych nonce pre odvodenie session key
-            uint8_t new_client_nonce[SAKE_NONCE_CLIENT_SIZE];
-            generate_random_bytes(new_client_nonce, SAKE_NONCE_CLIENT_SIZE);
-
-            // Odosielanie noveho client nonce
-            if (send_all(sock, new_client_nonce, SAKE_NONCE_CLIENT_SIZE) != SAKE_NONCE_CLIENT_SIZE)
-            {
-                fprintf(stderr, "Error: Failed to send new client nonce\n");
-                break;
-            }
-
-            // Prijatie noveho server nonce
-            uint8_t new_server_nonce[SAKE_NONCE_SERVER_SIZE];
-            if (recv_all(sock, new_server_nonce, SAKE_NONCE_SERVER_SIZE) != SAKE_NONCE_SERVER_SIZE)
-            {
-                fprintf(stderr, "Error: Failed to receive new server nonce\n");
-                break;
-            }
-
-            // Odoslanie validacneho signalu
-            if (send_chunk_size_reliable(sock, KEY_ROTATION_VALIDATE) < 0)
-            {
-                fprintf(stderr, ERR_KEY_VALIDATE_SIGNAL);
-                break;
-            }
-
-            // Vykonanie rotacie kluca pomcou SAKE key chain
-            uint8_t previous_session_key[KEY_SIZE];
-            memcpy(previous_session_key, session_key, KEY_SIZE);
-
-            // Pre session key pouzivame aktualizovany master key a nove nonce hodnoty
-            derive_session_key(session_key, key_chain.master_key, new_client_nonce, new_server_nonce);
-
-            // Aktualizacia client_nonce a server_nonce pre ďalsie pouzitie
-            memcpy(client_nonce, new_client_nonce, SAKE_NONCE_CLIENT_SIZE);
-            memcpy(server_nonce, new_server_nonce, SAKE_NONCE_SERVER_SIZE);
-
-            // Generovanie a odoslanie validacie kluca
-            uint8_t validation[VALIDATION_SIZE];
-            generate_key_validation(validation, session_key);
-            if (send_all(sock, validation, VALIDATION_SIZE) != VALIDATION_SIZE)
-            {
-                fprintf(stderr, ERR_KEY_VALIDATE_SIGNAL);
-                break;
-            }
-
-            // Cakanie na signal pripravenosti od servera
-            if (receive_chunk_size_reliable(sock, &ack) < 0 || ack != KEY_ROTATION_READY)
-            {
-                fprintf(stderr, ERR_KEY_ROTATION_READY);
-                break;
-            }
-
-            secure_wipe(previous_session_key, KEY_SIZE);
-            wait();
-        }
-
-        // Spracovanie bloku s aktualnym klucom
-        generate_random_bytes(nonce, NONCE_SIZE);
-
-        // Sifrovanie dat pomocou algoritmu ChaCha20-Poly1305
-        // ciphertext: Zasifrovane data
-        // tag: Overovaci kod pre integritu dat
-        // session_key: Kluc pouzity na sifrovanie
-        // nonce: Jednorazova hodnota pre zabezpecenie jedinecnosti sifrovania
-        crypto_aead_lock(ciphertext, tag, session_key, nonce, NULL, 0, buffer, bytes_read);
-
-        // Odoslanie velkosti bloku a zasifrovanych dat
-        int retry_count = MAX_RETRIES;
-        while (retry_count > 0)
-        {
-            if (send_chunk_size_reliable(sock, (uint32_t)bytes_read) == 0 &&
-                send_encrypted_chunk(sock, nonce, tag, ciphertext, bytes_read) == 0)
-            {
-                break; // Uspesne odoslanie
-            }
-            retry_count--;
-            if (retry_count > 0)
-            {
-                fprintf(stderr, MSG_RETRY_FAILED, retry_count);
-                usleep(RETRY_DELAY_MS * 1000);
-            }
-        }
-
-        // Ak sa nepodari odoslat blok dat po maximalnom pocte pokusov, program sa ukonci
-        if (retry_count == 0)
-        {
-            fprintf(stderr, MSG_CHUNK_FAILED);
-            break;
-        }
+        fprintf(stderr, ERR_FRAME_ALLOC);
+        fclose(file);
+        key_ratchet_wipe(&keys);
+        cleanup_socket(sock);
+        return -1;
+    }
 
-        total_bytes += bytes_read;
-        block_count++;
+    // io_uring pre socket aj subor, ak bol vybrany - inak (alebo ak ho jadro nepodporuje) blokujuce volania
+    if (io_engine == IO_ENGINE_URING && pipeline_use_io_ring(&sender) != 0)
+    {
+        fprintf(stderr, ERR_IO_RING_UNAVAILABLE);
+    }
+    printf(MSG_IO_ENGINE, (sender.net_ring.fd >= 0) ? IO_ENGINE_NAME_URING : IO_ENGINE_NAME_BLOCKING);
 
-        // Aktualizacia zobrazenia progresu prenosu
-        if (total_bytes - last_progress_update >= PROGRESS_UPDATE_INTERVAL)
-        {
-            printf(LOG_PROGRESS_FORMAT, "Sent", (float)total_bytes / PROGRESS_UPDATE_INTERVAL);
-            fflush(stdout);
-            last_progress_update = total_bytes;
-        }
+    // Rotacia kluca podla dohodnutych pravidiel (pocet blokov, objem dat alebo cas epochy)
+    // Rotacia kluca zvysuje bezpecnost komunikacie tym, ze obmedzuje mnozstvo dat sifrovanych jednym klucom
+    // Prebieha v ramci prudu blokov (epocha v hlavicke bloku), prenos sa pri nej nezastavi
+    if (pipeline_send(&sender, sock, file, &keys, &params.rotation,
+                      print_transfer_progress, &progress) != 0)
+    {
+        transfer_failed = 1;
     }
+    uint64_t total_bytes = progress.total_bytes;
     printf("\n"); // Novy riadok po vypise progresu
 
     // Odoslanie EOF markera a upratanie
-    if (send_chunk_size_reliable(sock, 0) < 0)
+    // Po chybe sa EOF neposiela, server by inak ulozil neuplny subor
+    if (transfer_failed)
+    {
+        total_bytes = 0; // Označuje neuspesny prenos
+    }
+    else if (send_end_of_frames(sock) < 0)
     {
         fprintf(stderr, MSG_EOF_FAILED);
         // Neuspesny prenos, cize zlyhanie pri odosielani EOF
@@ -502,9 +501,8 @@ int main()
     // Zabranuje utoku typu "memory dump", kedy by utocnik mohol ziskat citlive informacie z pamate
     secure_wipe(key, KEY_SIZE);
     secure_wipe(session_key, KEY_SIZE);
-    secure_wipe(buffer, TRANSFER_BUFFER_SIZE);
-    secure_wipe(ciphertext, TRANSFER_BUFFER_SIZE);
-    secure_wipe(tag, TAG_SIZE);
+    key_ratchet_wipe(&keys);
+    pipeline_free(&sender);
 
     // Vymazanie key chain
     secure_wipe(&key_chain, sizeof(key_chain));
@@ -25,7 +25,7 @@
 
 // Sietove nastavenia
 // #define PORT 8080                          // Cislo portu pre komunikaciu medzi klientom a serverom
-#define MAX_PENDING_CONNECTIONS 3 // Maximalny pocet cakajucich spojeni v rade
+#define MAX_PENDING_CONNECTIONS 128 // Maximalny pocet cakajucich spojeni v rade
 
 // Casove nastavenia
 #define SOCKET_SHUTDOWN_DELAY_MS 1000 // Cas cakania pred ukoncenim socketu v milisekundach
@@ -46,14 +46,22 @@
 #define SALT_SIZE 16             // Velkost soli pre derivaciu kluca (128 bitov)
 #define VALIDATION_SIZE 16       // Velkost overovacich dat v bajtoch
 #define SESSION_KEY_SIZE 32      // Velkost kluca pre jedno spojenie
+#define PSK_SIZE 32              // Velkost PSK klienta (vstup Argon2 namiesto hesla)
+#define CLIENT_ID_SIZE 32        // Velkost identifikatora klienta v sprave (doplneny nulami)
 #define WORK_AREA_SIZE (1 << 16) // Velkost pracovnej pamate pre Argon2
 
 // Parametre rotacie klucov
-#define KEY_ROTATION_BLOCKS 1024         // Po kolkych blokoch sa ma kluc zmenit
-#define KEY_ROTATION_MARKER 0xFFFFFFFF   // Specialna hodnota oznacujuca rotaciu kluca
-#define KEY_ROTATION_ACK 0xFFFFFFFE      // Potvrdenie prijatia noveho kluca
-#define KEY_ROTATION_READY 0xFFFFFFFD    // Signal pripravenosti na novy kluc
-#define KEY_ROTATION_VALIDATE 0xFFFFFFFB // Kontrola spravnosti noveho kluca
+// Kluc sa meni v ramci prudu blokov: odosielatel zvysi epochu v hlavicke bloku,
+// obe strany odvodia kluc novej epochy z hlavneho kluca a nonce relacie (bez vymeny sprav)
+// Pravidla rotacie dohodnu strany pri nadviazani spojenia (plati prisnejsie), 0 = pravidlo sa nepouziva
+#define KEY_ROTATION_BLOCKS 1024                      // Predvolene: po kolkych blokoch sa ma kluc zmenit
+#define KEY_ROTATION_MIB 1024                         // Predvolene: po kolkych MiB dat sa ma kluc zmenit
+#define KEY_ROTATION_MS 0                             // Predvolene: po kolkych milisekundach sa ma kluc zmenit
+#define KEY_ROTATION_FRAMES_OPTION "--rotate-frames=" // Prepinac pre pocet blokov
+#define KEY_ROTATION_MIB_OPTION "--rotate-mib="       // Prepinac pre objem dat v MiB
+#define KEY_ROTATION_MS_OPTION "--rotate-ms="         // Prepinac pre cas v milisekundach
+#define KEY_RATCHET_AHEAD 2                           // Kolko epoch pripravi vlakno na pozadi vopred (z hlavneho kluca)
+#define KEY_RATCHET_SLOTS (KEY_RATCHET_AHEAD + 2)     // Prudy epoch v pamati: pripravene, aktualna a predchadzajuca
 
 // Priznaky nastavenia spojenia
 #define SESSION_SETUP_START 0xFFFFFFF0 // Zaciatok vytvarania spojenia
@@ -70,24 +78,83 @@
 #define PASSWORD_BUFFER_SIZE 128               // Maximalna dlzka hesla
 #define FILE_NAME_BUFFER_SIZE 240              // Maximalna dlzka nazvu suboru
 #define NEW_FILE_NAME_BUFFER_SIZE 256          // Maximalna dlzka noveho nazvu suboru
-#define TRANSFER_BUFFER_SIZE 4096              // Velkost bloku pre prenos dat
+#define PART_FILE_NAME_BUFFER_SIZE 280         // Maximalna dlzka nazvu docasneho suboru (novy nazov, cislo spojenia, pripona)
 #define SIGNAL_SIZE 5                          // Velkost kontrolnych sprav
 #define PROGRESS_UPDATE_INTERVAL (1024 * 1024) // Interval aktualizacie priebehu
 
+// Velkost bloku dat (frame) - dohodnu ju strany pri nadviazani spojenia
+#define FRAME_SIZE_MIN (16 * 1024)         // Najmensia povolena velkost bloku
+#define FRAME_SIZE_MAX (4 * 1024 * 1024)   // Najvacsia povolena velkost bloku
+#define FRAME_SIZE_PREFERRED (1024 * 1024) // Velkost bloku, ktoru navrhne tato strana
+
+// Ramcovanie blokov na sieti (siete.c)
+#define FRAME_HEADER_SIZE 8                   // Velkost hlavicky bloku (velkost dat a epocha kluca v sietovom poradi)
+#define FRAME_SEND_BATCH 16                   // Najviac blokov odoslanych jednym volanim systemu
+#define FRAME_READER_BUFFER_SIZE (256 * 1024) // Velkost buffera pre citanie blokov zo siete
+
+// Viacvlaknove spracovanie blokov (pipeline.c)
+#define PIPELINE_MAX_WORKERS 16     // Najvacsi pocet vlakien pre sifrovanie
+#define PIPELINE_SLOTS_PER_WORKER 2 // Kolko blokov moze cakat na kazdeho pracovnika
+
+// Server s reaktorom (reactor.c) - jedno vlakno obsluhuje vsetky spojenia, vypocty robia spolocne vlakna
+#define TASK_POOL_MAX_THREADS 64                                  // Najvacsi pocet vlakien spolocnej skupiny
+#define REACTOR_TICK_MS 1000                                      // Ako casto reaktor kontroluje casove limity spojeni
+#define REACTOR_CONNECTION_WORKERS 3                              // Kolko blokov jedneho spojenia sa desifruje naraz (urcuje velkost zasobnika)
+#define REACTOR_HANDSHAKE_BUFFER_SIZE (FILE_NAME_BUFFER_SIZE + 8) // Buffer pre spravy pri nadviazani spojenia (najdlhsia je nazov suboru)
+#define REACTOR_RECV_BUFFER_SIZE (64 * 1024)                      // Buffer spojenia pre prijimanie hlaviciek, tagov a malych blokov naraz
+#define SERVER_SHARDS_OPTION "--shards="                          // Prepinac pre pocet reaktorov (kazdy s vlastnym socketom a vlaknami)
+#define SERVER_SHARDS_AUTO "auto"                                 // Hodnota prepinaca: jeden reaktor na procesor
+#define SERVER_MAX_SHARDS 64                                      // Najvacsi pocet reaktorov
+#define MSG_SERVER_SHARDS "Reactors: %u (%u crypto threads each)\n" // Informacia o reaktoroch servera
+#define MSG_CLIENT_PREFIX "[client %u] "                          // Predpona sprav o konkretnom spojeni
+#define MSG_SERVER_STOP "Server stopped\n"                        // Sprava po ukonceni servera
+
+// Uloziste prihlasovacich udajov na serveri (credentials.c)
+#define CREDENTIALS_MAGIC "SAKECRD2"                                    // Znacka na zaciatku suboru (8 bajtov)
+#define CREDENTIALS_HEADER_SIZE 64                                      // Velkost hlavicky suboru
+#define CREDENTIALS_RECORD_SIZE (CLIENT_ID_SIZE + PSK_SIZE)             // Velkost jednej pozicie tabulky
+#define CREDENTIALS_MAX_CLIENTS (1u << 24)                              // Najviac klientov v jednom ulozisti
+#define CREDENTIALS_LINE_SIZE 512                                       // Najdlhsi riadok zoznamu id:heslo
+#define CREDENTIALS_OPTION "--credentials="                             // Prepinac pre subor s ulozistom
+#define CREDENTIALS_BUILD_OPTION "--build-credentials="                 // Prepinac pre vytvorenie uloziska zo zoznamu
+#define MSG_CREDENTIALS_LOADED "Credentials: %u clients in %s\n"        // Sprava o nacitani uloziska
+#define MSG_CREDENTIALS_BUILT "Credentials: %u clients written to %s\n" // Sprava o vytvoreni uloziska
+#define MSG_CLIENT_ID "Client ID: %s\n"                                 // Identifikator klienta spojenia
+
 // Konfiguracia Argon2 (funkcia pre odvodzovanie klucov)
-#define ARGON2_MEMORY_BLOCKS 65536 // Kolko pamate pouzit (v 1KB blokoch)
-#define ARGON2_ITERATIONS 3        // Kolko krat sa ma heslo prehashovat
-#define ARGON2_LANES 1             // Kolko paralelnych vypoctov povolit
+#define ARGON2_MEMORY_BLOCKS 65536                                          // Kolko pamate pouzit (v 1KB blokoch)
+#define ARGON2_ITERATIONS 3                                                 // Kolko krat sa ma heslo prehashovat
+#define ARGON2_MIN_LANES 1                                                  // Najmensi pocet paralelnych vypoctov (liniek)
+#define ARGON2_MAX_LANES 8                                                  // Najvacsi pocet liniek, ktory strany mozu dohodnut
+#define ARGON2_WORK_AREA_SIZE ((size_t)ARGON2_MEMORY_BLOCKS * 1024)         // Pracovna pamat jedneho odvodenia (64 MiB)
+#define PSK_ARGON2_MEMORY_BLOCKS 8192                                       // Pamat pre PSK z hesla (v 1KB blokoch, mensia ako pracovna pamat)
+#define PSK_ARGON2_ITERATIONS 3                                             // Kolko krat sa heslo prehashuje pri odvodeni PSK
+#define PSK_ARGON2_WORK_AREA_SIZE ((size_t)PSK_ARGON2_MEMORY_BLOCKS * 1024) // Pracovna pamat PSK z hesla (8 MiB)
+
+// Planovac odvodenia klucov na serveri (kdf_scheduler.c) - spolocny pre vsetky reaktory
+#define KDF_MEMORY_MIB 256                          // Predvoleny rozpocet pamate pre Argon2 (4 pracovne pamate)
+#define KDF_MAX_MEMORY_MIB 65536                    // Najvacsi rozpocet pamate
+#define KDF_CONCURRENCY 4                           // Predvolene najviac sucasnych odvodeni
+#define KDF_QUEUE_LIMIT 1024                        // Najviac cakajucich odvodeni, dalsie spojenia sa odmietnu
+#define KDF_MEMORY_OPTION "--kdf-memory-mib="       // Prepinac pre rozpocet pamate
+#define KDF_CONCURRENCY_OPTION "--kdf-concurrency=" // Prepinac pre pocet sucasnych odvodeni
+#define MSG_KDF_SCHEDULER "Key derivation: %u at once in %u MiB of work memory (%s), up to %u queued\n" // Nastavenie planovaca
+#define MSG_KDF_QUEUED "Key derivation queued, %d ahead\n"        // Odvodenie caka na pracovnu pamat
+#define MSG_KDF_WAITED "Key derivation waited %llu ms in queue\n" // Doba cakania odvodenia
+#define MSG_KDF_STATS "Key derivations: %llu done, %llu refused, average wait %llu ms, longest %llu ms, deepest queue %u\n" // Statistika planovaca pri ukonceni
 
 // Operacie so subormi
-#define FILE_PREFIX "received_" // Predpona pre nazvy prijatych suborov
-#define FILE_MODE_READ "rb"     // Mod otvarania suboru pre citanie (binarny)
-#define FILE_MODE_WRITE "wb"    // Mod otvarania suboru pre zapis (binarny)
+#define FILE_PREFIX "received_"      // Predpona pre nazvy prijatych suborov
+#define FILE_MODE_READ "rb"          // Mod otvarania suboru pre citanie (binarny)
+#define FILE_MODE_CREATE "w+bx"      // Mod vytvorenia noveho suboru (binarny, citanie pre mapovanie, zlyha ak subor existuje)
+#define FILE_PART_SUFFIX ".part"     // Pripona docasneho suboru, kym prijimanie neskonci
+#define FILE_SIZE_UNKNOWN UINT64_MAX // Ohlasena velkost suboru, ktoru odosielatel nepozna (rura, zariadenie)
 
 // Nastavenia klienta
 #define DEFAULT_SERVER_ADDRESS "127.0.0.1"                         // Predvolena IP adresa servera (localhost)
 #define IP_ADDRESS_PROMPT "Enter server IP address (default %s): " // Vyzva na zadanie IP adresy servera
 #define PORT_PROMPT "Enter port number (1-65535): "                // Vyzva na zadanie cisla portu
+#define CLIENT_ID_PROMPT "Enter client ID: "                        // Vyzva na zadanie identifikatora klienta
 
 // Texty pouzivatelskeho rozhrania
 #define PASSWORD_PROMPT "Enter password: "                       // Vyzva na zadanie hesla pre klienta
@@ -105,8 +172,6 @@
 // Spravy o stave spojenia
 #define MSG_CONNECTION_ACCEPTED "Connection accepted from %s:%d\n"                                           // Informacia o prijatom spojeni
 #define MSG_KEY_ACK_RECEIVED "Received key acknowledgment from server\n"                                     // Potvrdenie prijatia kluca
-#define MSG_ACK_SENDING "Sending acknowledgment (attempt %d/%d)...\n"                                        // Odosielanie potvrdenia
-#define MSG_ACK_RETRY "Failed to send acknowledgment, retrying in %d ms...\n"                                // Opakovanie odoslania potvrdenia
 #define MSG_ACK_WAITING "Waiting for acknowledgment (attempt %d/%d)...\n"                                    // Cakanie na potvrdenie
 #define MSG_ACK_RETRY_RECEIVE "Failed to receive acknowledgment (received %d bytes), retrying in %d ms...\n" // Opakovanie prijatia potvrdenia
 
@@ -114,7 +179,7 @@
 #define MSG_FILE_LIST "Files in the project directory:\n"                  // Zobrazenie zoznamu suborov
 #define MSG_ENTER_FILENAME "Enter filename to send (max 239 characters): " // Vyzva na zadanie nazvu suboru
 #define MSG_ACK_RECEIVED "Received acknowledgment from server.\n"          // Potvrdenie prijatia spravy
-#define MSG_KEY_ROTATION "Initiating key rotation at block %llu\n"         // Informacia o zmene kluca
+#define MSG_KEY_ROTATION "Key rotation to epoch %u at block %llu\n"        // Informacia o zmene kluca
 #define MSG_RETRY_FAILED "Send failed, retrying... (%d attempts left)\n"   // Nepodarilo sa odoslat, opakovanie
 #define MSG_CHUNK_FAILED "Error: Failed to send chunk after all retries\n" // Chyba pri odosielani bloku po vsetkych opakovaniach
 #define MSG_EOF_FAILED "Error: Failed to send EOF marker\n"                // Chyba pri odosielani EOF markera
@@ -130,9 +195,11 @@
 #define SAKE_DERIV_KEY_TAG "SAKE_K"           // Tag pre odvodzovanie hlavneho kluca K
 #define SAKE_DERIV_AUTH_TAG "SAKE_K_AUTH"     // Tag pre odvodzovanie autentizacneho kluca K'
 #define SAKE_DERIV_SESSION_TAG "SAKE_SESSION" // Tag pre odvodzovanie kluca relacie
+#define SAKE_DERIV_EPOCH_TAG "SAKE_EPOCH"     // Tag pre odvodzovanie klucov epoch
 #define SAKE_KEY_COUNTER_SIZE 8               // Velkost citaca verzie kluca
 #define SAKE_NONCE_CLIENT_SIZE 16             // Velkost nonce klienta
 #define SAKE_NONCE_SERVER_SIZE 16             // Velkost nonce servera
+#define SAKE_NONCES_SIZE 32                   // Nonce klienta a servera spolu (kluce epoch)
 
 // Hodnoty pre vysledok auntentizacie
 #define AUTH_SUCCESS 0x01 // Kod pre uspesnu autentizaciu
@@ -142,4 +209,33 @@
 #define MSG_SAKE_AUTH_SUCCESS "SAKE response verified successfully\n" // Uspesna autentizacia
 #define MSG_SAKE_AUTH_FAILED "SAKE response verification failed\n"    // Neuspesna autentizacia
 
+// Vyber implementacie kryptografickych jadier
+#define CRYPTO_IMPL_ENV "SAKE_CRYPTO_IMPL"     // Premenna prostredia pre vynutenie implementacie
+#define CRYPTO_IMPL_OPTION "--crypto-impl="    // Prepinac prikazoveho riadku (ma prednost pred premennou)
+#define CRYPTO_IMPL_FALLBACK "portable"        // Implementacia pouzita, ak vybrana neprejde samotestom
+#define MSG_CRYPTO_IMPL "Crypto kernels: %s\n" // Informacia o pouzitych jadrach
+
+// Vyber I/O enginu (io_ring.c)
+#define IO_ENGINE_ENV "SAKE_IO_ENGINE"     // Premenna prostredia pre vyber enginu
+#define IO_ENGINE_OPTION "--io-engine="    // Prepinac prikazoveho riadku (ma prednost pred premennou)
+#define IO_ENGINE_NAME_BLOCKING "blocking" // Blokujuce volania (predvolene)
+#define IO_ENGINE_NAME_URING "io_uring"    // io_uring (iba Linux)
+#define IO_RING_ENTRIES 8                  // Velkost kruhu (poziadavky spolu s ich casovymi limitmi)
+#define IO_RING_SEND_DEPTH 2               // Najviac davok blokov odosielanych naraz na pozadi
+#define MSG_IO_ENGINE "I/O engine: %s\n"   // Informacia o pouzitom engine
+
+// Sifrovacie sady - bitova maska, klient posle podporovane sady, server vyberie jednu
+#define CIPHER_SUITE_XCHACHA20_POLY1305 0x00000001 // XChaCha20-Poly1305 (Monocypher, dostupna vzdy)
+#define CIPHER_SUITE_AES256_GCM 0x00000002         // AES-256-GCM (iba s AES-NI a PCLMULQDQ)
+#define CIPHER_SUITES_KNOWN (CIPHER_SUITE_XCHACHA20_POLY1305 | CIPHER_SUITE_AES256_GCM)
+#define AEAD_STREAM_NONCE_TAG "SAKE_STREAM"        // Tag pre odvodenie zakladneho nonce prudu z kluca relacie
+
+// Spravy o dohodnutych parametroch relacie
+#define SESSION_PARAMS_WIRE_SIZE 24                                                             // Velkost parametrov relacie na sieti v bajtoch
+#define SESSION_TRANSCRIPT_SIZE (2 * SESSION_PARAMS_WIRE_SIZE)                                  // Navrh klienta a odpoved servera, ktore potvrdi SAKE
+#define MSG_ARGON2_LANES "Argon2 lanes agreed: %u\n"                                            // Pocet liniek Argon2 dohodnuty oboma stranami
+#define MSG_CIPHER_SUITE "Cipher suite agreed: %s\n"                                            // Sifrovacia sada dohodnuta oboma stranami
+#define MSG_FRAME_SIZE "Frame size agreed: %u bytes\n"                                          // Najvacsia velkost bloku dat dohodnuta oboma stranami
+#define MSG_ROTATION_POLICY "Key rotation agreed: every %u frames / %u MiB / %u ms (0 = off)\n" // Pravidla rotacie kluca
+
 #endif // CONSTANTS_H
@@ -0,0 +1,307 @@
+/********************************************************************************
+ * Program:    Uloziste prihlasovacich udajov pre zabezpeceny prenos suborov
+ * Subor:      credentials.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia uloziska prihlasovacich udajov:
+ *     - Otvorenie: subor sa namapuje iba na citanie a nacita sa cely vopred,
+ *       vyhladanie v reaktore tak nikdy neceka na disk
+ *     - Vyhladanie: FNV-1a hash identifikatora urci poziciu, pri kolizii sa
+ *       pokracuje na dalsiu poziciu (tabulka je zaplnena najviac do polovice)
+ *     - Vytvorenie: zo zoznamu riadkov id:heslo sa vypocitaju PSK a zapise sa tabulka
+ *
+ * Zavislosti:
+ *     - credentials.h (deklaracie funkcii)
+ *     - siete.h (identifikator klienta, sietove poradie cisel)
+ *     - crypto_utils.h (PSK klienta, mazanie citlivych dat)
+ *     - errors.h (chybove spravy)
+ *******************************************************************************/
+
+#include <stdio.h>  // Kniznica pre pracu so subormi
+#include <stdlib.h> // Kniznica pre spravu pamate
+#include <string.h> // Kniznica pre pracu s pamatou a retazcami
+#include <errno.h>  // Kniznica pre systemove chyby
+
+#include "credentials.h"  // Deklaracie funkcii
+#include "siete.h"        // Pre identifikator klienta a sietove poradie cisel
+#include "crypto_utils.h" // Pre PSK klienta a mazanie citlivych dat
+#include "errors.h"       // Chybove spravy
+
+// Hlavicka suboru (CREDENTIALS_HEADER_SIZE bajtov, zvysok su nuly)
+typedef struct
+{
+    char magic[8];               // CREDENTIALS_MAGIC
+    uint32_t slots;              // Pocet pozicii (sietove poradie)
+    uint32_t count;              // Pocet klientov (sietove poradie)
+    uint8_t psk_salt[SALT_SIZE]; // Sol pre PSK z hesiel (server ju posiela klientom)
+} credentials_header_t;
+
+// Prva pozicia pre identifikator (FNV-1a cez celych CLIENT_ID_SIZE bajtov)
+static uint32_t credentials_slot(const uint8_t *client_id, uint32_t slots)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < CLIENT_ID_SIZE; i++)
+    {
+        hash = (hash ^ client_id[i]) * 0x100000001b3ULL;
+    }
+    return (uint32_t)(hash ^ (hash >> 32)) & (slots - 1);
+}
+
+// Namapovanie uloziska a kontrola hlavicky a velkosti
+// Navratova hodnota: 0 pri uspechu, -1 pri chybe (vypise ju)
+int credentials_open(credential_store_t *store, const char *path)
+{
+    memset(store, 0, sizeof(*store));
+    FILE *file = fopen(path, FILE_MODE_READ);
+    if (file == NULL)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_OPEN, path, strerror(errno));
+        return -1;
+    }
+
+    // PSK v ulozisti staci na prihlasenie za klienta - uloziste citatelne pre inych sa nepouzije
+    if (!platform_file_private(file))
+    {
+        fprintf(stderr, ERR_CREDENTIALS_PERMISSIONS, path);
+        fclose(file);
+        return -1;
+    }
+    int mapped = platform_file_map(&store->map, file);
+    fclose(file); // Mapovanie plati aj po zatvoreni suboru
+    if (mapped != 0)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_OPEN, path, "cannot map file");
+        return -1;
+    }
+
+    credentials_header_t header;
+    if (store->map.size >= CREDENTIALS_HEADER_SIZE)
+    {
+        memcpy(&header, store->map.data, sizeof(header));
+        store->slots = ntohl(header.slots);
+        store->count = ntohl(header.count);
+        memcpy(store->psk_salt, header.psk_salt, SALT_SIZE);
+    }
+    if (store->map.size < CREDENTIALS_HEADER_SIZE || memcmp(header.magic, CREDENTIALS_MAGIC, 8) != 0 ||
+        store->slots == 0 || (store->slots & (store->slots - 1)) != 0 || store->count > store->slots / 2 ||
+        store->map.size != CREDENTIALS_HEADER_SIZE + (uint64_t)store->slots * CREDENTIALS_RECORD_SIZE)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_FORMAT, path);
+        credentials_close(store);
+        return -1;
+    }
+
+    // Cela tabulka sa nacita hned, vyhladanie v reaktore nesmie cakat na disk
+    platform_file_map_prefetch(&store->map, 0, store->map.size);
+    store->records = store->map.data + CREDENTIALS_HEADER_SIZE;
+    return 0;
+}
+
+// Vyhladanie PSK klienta podla identifikatora (CLIENT_ID_SIZE bajtov z client_id_encode)
+// Navratova hodnota: ukazovatel na PSK_SIZE bajtov v ulozisti alebo NULL
+const uint8_t *credentials_lookup(const credential_store_t *store, const uint8_t *client_id)
+{
+    static const uint8_t empty[CLIENT_ID_SIZE] = {0};
+    uint32_t slot = credentials_slot(client_id, store->slots);
+    for (uint32_t probe = 0; probe < store->slots; probe++)
+    {
+        const uint8_t *record = store->records + (size_t)slot * CREDENTIALS_RECORD_SIZE;
+        if (memcmp(record, client_id, CLIENT_ID_SIZE) == 0)
+        {
+            return record + CLIENT_ID_SIZE;
+        }
+        if (memcmp(record, empty, CLIENT_ID_SIZE) == 0)
+        {
+            return NULL; // Prazdna pozicia - identifikator v tabulke nie je
+        }
+        slot = (slot + 1) & (store->slots - 1);
+    }
+    return NULL;
+}
+
+// Zrusenie mapovania uloziska
+void credentials_close(credential_store_t *store)
+{
+    platform_file_unmap(&store->map);
+    memset(store, 0, sizeof(*store));
+}
+
+// Rozdelenie riadku id:heslo (bez konca riadku), identifikator sa zakoduje do client_id
+// Navratova hodnota: heslo (ukazuje do riadku) alebo NULL pre neplatny riadok
+static const char *credentials_parse_line(char *line, uint8_t *client_id)
+{
+    line[strcspn(line, "\r\n")] = '\0';
+    char *separator = strchr(line, ':');
+    if (separator == NULL || separator[1] == '\0')
+    {
+        return NULL;
+    }
+    *separator = '\0';
+    return (client_id_encode(line, client_id) == 0) ? separator + 1 : NULL;
+}
+
+// Zapis hlavicky a tabulky do suboru
+static int credentials_write(const char *store_path, const uint8_t *records, uint32_t slots, uint32_t count,
+                             const uint8_t *psk_salt)
+{
+    uint8_t header_bytes[CREDENTIALS_HEADER_SIZE] = {0};
+    credentials_header_t header;
+    memcpy(header.magic, CREDENTIALS_MAGIC, 8);
+    header.slots = htonl(slots);
+    header.count = htonl(count);
+    memcpy(header.psk_salt, psk_salt, SALT_SIZE);
+    memcpy(header_bytes, &header, sizeof(header));
+
+    // Uloziste obsahuje PSK klientov - zapise sa do noveho suboru iba pre vlastnika
+    // a az cele sa presunie na miesto povodneho, server tak nikdy nenacita polovicne uloziste
+    size_t path_len = strlen(store_path);
+    char *temp_path = malloc(path_len + sizeof(FILE_PART_SUFFIX));
+    if (temp_path == NULL)
+    {
+        return -1;
+    }
+    memcpy(temp_path, store_path, path_len);
+    memcpy(temp_path + path_len, FILE_PART_SUFFIX, sizeof(FILE_PART_SUFFIX));
+
+    // Docasny subor, ktory zostal po prerusenom vytvarani, by inak zablokoval kazde dalsie
+    // Odstrani sa (aj ked je to symbolicky odkaz, ciel ostane) a novy sa vytvori vylucne
+    remove(temp_path);
+    FILE *file = platform_file_create_private(temp_path);
+    if (file == NULL)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_OPEN, temp_path, strerror(errno));
+        free(temp_path);
+        return -1;
+    }
+    int result = 0;
+    if (fwrite(header_bytes, 1, sizeof(header_bytes), file) != sizeof(header_bytes) ||
+        fwrite(records, CREDENTIALS_RECORD_SIZE, slots, file) != slots)
+    {
+        result = -1;
+    }
+    if (fclose(file) != 0)
+    {
+        result = -1;
+    }
+    if (result == 0 && platform_file_replace(temp_path, store_path) != 0)
+    {
+        result = -1;
+    }
+    if (result != 0)
+    {
+        remove(temp_path);
+    }
+    free(temp_path);
+    return result;
+}
+
+// Vytvorenie uloziska zo zoznamu riadkov id:heslo (prazdne riadky a riadky s # sa preskocia)
+// Heslo sa do uloziska neulozi, iba PSK z identifikatora a hesla (Argon2id s novou solou uloziska)
+// Navratova hodnota: 0 pri uspechu (count = pocet klientov), -1 pri chybe (vypise ju)
+int credentials_build(const char *list_path, const char *store_path, uint32_t *count)
+{
+    FILE *list = fopen(list_path, FILE_MODE_READ);
+    if (list == NULL)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_OPEN, list_path, strerror(errno));
+        return -1;
+    }
+
+    // Prvy prechod: pocet klientov urci velkost tabulky (najviac do polovice plna)
+    char line[CREDENTIALS_LINE_SIZE];
+    uint32_t entries = 0;
+    while (fgets(line, sizeof(line), list) != NULL)
+    {
+        entries += (line[0] != '\n' && line[0] != '\r' && line[0] != '#');
+    }
+    if (entries > CREDENTIALS_MAX_CLIENTS)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_FORMAT, list_path);
+        fclose(list);
+        return -1;
+    }
+    uint32_t slots = 16;
+    while (slots < entries * 2)
+    {
+        slots *= 2;
+    }
+    uint8_t *records = calloc(slots, CREDENTIALS_RECORD_SIZE);
+    if (records == NULL)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_WRITE, store_path);
+        fclose(list);
+        return -1;
+    }
+
+    // Jedna pracovna pamat Argon2id pre vsetkych klientov
+    int pages;
+    void *work_area = platform_large_alloc(PSK_ARGON2_WORK_AREA_SIZE, &pages);
+    if (work_area == NULL)
+    {
+        fprintf(stderr, ERR_KEY_DERIVE_MEMORY);
+        free(records);
+        fclose(list);
+        return -1;
+    }
+    uint8_t psk_salt[SALT_SIZE];
+    generate_random_bytes(psk_salt, SALT_SIZE);
+
+    // Druhy prechod: vypocet PSK a vlozenie do tabulky
+    rewind(list);
+    int result = 0;
+    unsigned line_number = 0;
+    *count = 0;
+    while (result == 0 && fgets(line, sizeof(line), list) != NULL)
+    {
+        line_number++;
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#')
+        {
+            continue;
+        }
+        uint8_t client_id[CLIENT_ID_SIZE];
+        int complete = (strchr(line, '\n') != NULL || feof(list));
+        const char *password = complete ? credentials_parse_line(line, client_id) : NULL;
+        if (password == NULL)
+        {
+            fprintf(stderr, ERR_CREDENTIALS_LINE, line_number, list_path);
+            result = -1;
+            break;
+        }
+
+        uint32_t slot = credentials_slot(client_id, slots);
+        uint8_t *record = records + (size_t)slot * CREDENTIALS_RECORD_SIZE;
+        while (record[0] != 0 && memcmp(record, client_id, CLIENT_ID_SIZE) != 0)
+        {
+            slot = (slot + 1) & (slots - 1);
+            record = records + (size_t)slot * CREDENTIALS_RECORD_SIZE;
+        }
+        if (record[0] != 0)
+        {
+            fprintf(stderr, ERR_CREDENTIALS_DUPLICATE, line_number, list_path);
+            result = -1;
+            break;
+        }
+        memcpy(record, client_id, CLIENT_ID_SIZE);
+        if (derive_client_psk(record + CLIENT_ID_SIZE, client_id, password, psk_salt, work_area) != 0)
+        {
+            result = -1;
+            break;
+        }
+        (*count)++;
+    }
+    secure_wipe(line, sizeof(line));
+    fclose(list);
+    platform_large_free(work_area, PSK_ARGON2_WORK_AREA_SIZE);
+
+    if (result == 0 && credentials_write(store_path, records, slots, *count, psk_salt) != 0)
+    {
+        fprintf(stderr, ERR_CREDENTIALS_WRITE, store_path);
+        result = -1;
+    }
+    secure_wipe(records, (size_t)slots * CREDENTIALS_RECORD_SIZE);
+    free(records);
+    return result;
+}
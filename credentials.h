@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * Program:    Uloziste prihlasovacich udajov pre zabezpeceny prenos suborov
+ * Subor:      credentials.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre uloziste prihlasovacich udajov servera:
+ *     - Tabulka identifikator klienta -> PSK (Argon2id hesla so solou uloziska a identifikatorom),
+ *       server tak hesla klientov nepozna a pri spusteni sa nepyta na ziadne
+ *     - Subor je priamo tabulka s otvorenym adresovanim (zaznamy pevnej velkosti),
+ *       server ho iba namapuje - vyhladanie je jeden hash a niekolko porovnani
+ *     - Subor sa vytvori zo zoznamu riadkov id:heslo (prepinac --build-credentials=)
+ *
+ *     Format suboru (cisla v sietovom poradi):
+ *     - Hlavicka (CREDENTIALS_HEADER_SIZE): znacka, pocet pozicii (mocnina 2), pocet klientov,
+ *       sol pre PSK (SALT_SIZE)
+ *     - Pozicie (CREDENTIALS_RECORD_SIZE): identifikator doplneny nulami a PSK,
+ *       prazdna pozicia ma identifikator zo samych nul
+ *
+ * Zavislosti:
+ *     - platform.h (mapovanie suborov)
+ *     - constants.h (konstanty programu)
+ ******************************************************************************/
+
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t)
+
+#include "platform.h"  // Pre mapovanie suborov
+#include "constants.h" // Definicie konstant pre program
+
+// Namapovane uloziste prihlasovacich udajov (iba na citanie, moze ho pouzivat viac vlakien)
+typedef struct
+{
+    platform_file_map_t map;     // Namapovany subor
+    const uint8_t *records;      // Prva pozicia tabulky
+    uint32_t slots;              // Pocet pozicii (mocnina 2)
+    uint32_t count;              // Pocet klientov
+    uint8_t psk_salt[SALT_SIZE]; // Sol pre PSK z hesiel (server ju posiela klientom)
+} credential_store_t;
+
+int credentials_open(credential_store_t *store, const char *path);  // Namapuje a overi subor s ulozistom
+const uint8_t *credentials_lookup(const credential_store_t *store,  // PSK klienta alebo NULL, ak ho uloziste nepozna
+                                  const uint8_t *client_id);
+void credentials_close(credential_store_t *store);                  // Zrusi mapovanie
+int credentials_build(const char *list_path, const char *store_path, // Vytvori uloziste zo zoznamu id:heslo
+                      uint32_t *count);
+
+#endif // CREDENTIALS_H
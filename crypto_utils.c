@@ -8,11 +8,14 @@
  * Popis:
  *     Implementacia kryptografickych operacii:
  *     - Bezpecne generovanie nahodnych cisel pre nonce a salt
- *     - Bezpecne odvodenie klucov pomocou Argon2
+ *     - Vyber kryptografickych jadier podla procesora a ich samotest
+ *     - Sifrovanie blokov dohodnutou sadou (XChaCha20-Poly1305 alebo AES-256-GCM)
+ *     - Bezpecne odvodenie klucov pomocou Argon2 s linkami vo vlaknach
  *     - Rotacia klucov a ich validaciu pre pravidelne obmeny pocas prenosu
  *
  * Zavislosti:
  *     - Monocypher 4.0.2 (sifrovacie algoritmy)
+ *     - aes_gcm.h (AES-256-GCM)
  *     - crypto_utils.h (deklaracie funkcii)
  *     - constants.h (konstanty programu)
  *     - sake.h (pre SAKE protokol)
@@ -23,6 +26,7 @@
 #include <stdio.h>  // Kniznica pre standardny vstup a vystup (nacitanie zo suborov, vypis na obrazovku)
 #include <stdlib.h> // Kniznica pre vseobecne funkcie (sprava pamate, konverzie, nahodne cisla)
 #include <string.h> // Kniznica pre pracu s retazcami (kopirovanie, porovnavanie, spajanie)
+#include <errno.h>  // Kniznica pre systemove chyby (kontrola prevodu cisel)
 
 #include "crypto_utils.h" // Pre kryptograficke funkcie
 #include "constants.h"    // Pre konstanty programu
@@ -52,25 +56,270 @@ void generate_random_bytes(uint8_t *buffer, size_t size)
     }
 }
 
+// Vyber implementacie kryptografickych jadier (portable, sse, avx2, avx512)
+// Monocypher pri starte vyberie najrychlejsie jadra, ktore procesor podporuje.
+// Prepinac --crypto-impl= alebo premenna SAKE_CRYPTO_IMPL ich moze vynutit (napr. pre meranie).
+// Vybrane jadra sa porovnaju s prenosnou implementaciou, aby chybne
+// skompilovana rychla cesta nemohla potichu poskodit prenasane data.
+int select_crypto_impl(int argc, char *argv[])
+{
+    const char *impl = getenv(CRYPTO_IMPL_ENV);
+    size_t option_len = strlen(CRYPTO_IMPL_OPTION);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], CRYPTO_IMPL_OPTION, option_len) == 0)
+        {
+            impl = argv[i] + option_len;
+        }
+    }
+
+    if (impl != NULL && crypto_cpu_select(impl) != 0)
+    {
+        fprintf(stderr, ERR_CRYPTO_IMPL, impl);
+        return -1;
+    }
+
+    // Jadra AES-256-GCM patria k rovnakej urovni (portable ich vypne) a overia sa spolu s nimi
+    aes_gcm_select(crypto_cpu_impl());
+    if (crypto_cpu_self_test() != 0 || aes_gcm_self_test() != 0)
+    {
+        fprintf(stderr, ERR_CRYPTO_SELF_TEST, crypto_cpu_impl(), CRYPTO_IMPL_FALLBACK);
+        crypto_cpu_select(CRYPTO_IMPL_FALLBACK);
+        aes_gcm_select(crypto_cpu_impl());
+        if (crypto_cpu_self_test() != 0)
+        {
+            fprintf(stderr, ERR_CRYPTO_SELF_TEST_FATAL);
+            return -1;
+        }
+    }
+
+    printf(MSG_CRYPTO_IMPL, crypto_cpu_impl());
+    return 0;
+}
+
+// Pocet liniek Argon2, ktore tento pocitac spracuje naraz
+// Kazda linka bezi vo vlastnom vlakne, preto viac liniek ako procesorov nepomoze
+uint32_t argon2_preferred_lanes(void)
+{
+    unsigned cpus = platform_cpu_count();
+    if (cpus < ARGON2_MIN_LANES)
+    {
+        return ARGON2_MIN_LANES;
+    }
+    return (cpus > ARGON2_MAX_LANES) ? ARGON2_MAX_LANES : (uint32_t)cpus;
+}
+
+struct argon2_lanes;
+
+// Jedno vlakno linky Argon2
+typedef struct
+{
+    struct argon2_lanes *lanes; // Skupina, do ktorej vlakno patri
+    uint32_t lane;              // Cislo linky, ktoru vlakno spracuje
+    platform_thread_t thread;   // Vlakno linky
+    int started;                // 1 ak vlakno bezi
+} argon2_lane_t;
+
+// Vlakna liniek 1 az n-1 pre jedno odvodenie - spustia sa raz a medzi rezmi (slices) cakaju,
+// takze 4 rezy v kazdom prechode nevytvaraju nove vlakna
+typedef struct argon2_lanes
+{
+    argon2_lane_t workers[ARGON2_MAX_LANES]; // Vlakna liniek (polozka 0 sa nepouziva)
+    uint32_t nb_lanes;                       // Pocet liniek odvodenia
+    uint32_t nb_started;                     // Pocet spustenych vlakien
+    void (*fill)(void *arg, uint32_t lane);  // Funkcia Monocypher pre vyplnenie segmentu
+    void *arg;                               // Stav aktualneho rezu
+    uint32_t generation;                     // Poradie aktualneho rezu
+    uint32_t pending;                        // Vlakna, ktore aktualny rez este nedokoncili
+    int stop;                                // 1 ak maju vlakna skoncit
+    platform_mutex_t lock;                   // Chrani rez, pending a stop
+    platform_cond_t slice_ready;             // Novy rez alebo stop
+    platform_cond_t slice_done;              // Vsetky vlakna dokoncili rez
+} argon2_lanes_t;
+
+// Vstupny bod vlakna - pre kazdy rez vyplni segment svojej linky
+static void argon2_lane_worker(void *param)
+{
+    argon2_lane_t *worker = (argon2_lane_t *)param;
+    argon2_lanes_t *lanes = worker->lanes;
+    uint32_t seen = 0;
+
+    platform_mutex_lock(&lanes->lock);
+    for (;;)
+    {
+        while (!lanes->stop && lanes->generation == seen)
+        {
+            platform_cond_wait(&lanes->slice_ready, &lanes->lock);
+        }
+        if (lanes->generation == seen)
+        {
+            break; // Stop a ziadny novy rez
+        }
+        seen = lanes->generation;
+        void (*fill)(void *arg, uint32_t lane) = lanes->fill;
+        void *arg = lanes->arg;
+        platform_mutex_unlock(&lanes->lock);
+
+        fill(arg, worker->lane);
+
+        platform_mutex_lock(&lanes->lock);
+        if (--lanes->pending == 0)
+        {
+            platform_cond_broadcast(&lanes->slice_done);
+        }
+    }
+    platform_mutex_unlock(&lanes->lock);
+}
+
+// Spustenie vlakien liniek 1 az n-1 (linka 0 bezi v aktualnom vlakne)
+// Ak sa vlakno nepodari vytvorit, jeho linku pocita aktualne vlakno (vysledok je rovnaky)
+static void argon2_lanes_start(argon2_lanes_t *lanes, uint32_t nb_lanes)
+{
+    memset(lanes, 0, sizeof(*lanes));
+    lanes->nb_lanes = nb_lanes;
+    platform_mutex_init(&lanes->lock);
+    platform_cond_init(&lanes->slice_ready);
+    platform_cond_init(&lanes->slice_done);
+    for (uint32_t lane = 1; lane < nb_lanes; lane++)
+    {
+        argon2_lane_t *worker = &lanes->workers[lane];
+        worker->lanes = lanes;
+        worker->lane = lane;
+        worker->started = (platform_thread_create(&worker->thread, argon2_lane_worker, worker) == 0);
+        lanes->nb_started += (uint32_t)worker->started;
+    }
+}
+
+// Ukoncenie vlakien liniek po odvodeni
+static void argon2_lanes_stop(argon2_lanes_t *lanes)
+{
+    platform_mutex_lock(&lanes->lock);
+    lanes->stop = 1;
+    platform_cond_broadcast(&lanes->slice_ready);
+    platform_mutex_unlock(&lanes->lock);
+    for (uint32_t lane = 1; lane < lanes->nb_lanes; lane++)
+    {
+        if (lanes->workers[lane].started)
+        {
+            platform_thread_join(&lanes->workers[lane].thread);
+        }
+    }
+    platform_cond_destroy(&lanes->slice_done);
+    platform_cond_destroy(&lanes->slice_ready);
+    platform_mutex_destroy(&lanes->lock);
+}
+
+// Vykonavac liniek pre crypto_argon2_parallel - jeden rez na vlaknach zo skupiny argon2_lanes_t
+// Linka 0 a linky bez vlakna sa pocitaju v aktualnom vlakne
+static void argon2_run_lanes(void *executor_ctx, void (*fill)(void *arg, uint32_t lane),
+                             void *arg, uint32_t nb_lanes)
+{
+    argon2_lanes_t *lanes = (argon2_lanes_t *)executor_ctx;
+
+    platform_mutex_lock(&lanes->lock);
+    lanes->fill = fill;
+    lanes->arg = arg;
+    lanes->pending = lanes->nb_started;
+    lanes->generation++;
+    platform_cond_broadcast(&lanes->slice_ready);
+    platform_mutex_unlock(&lanes->lock);
+
+    fill(arg, 0);
+    for (uint32_t lane = 1; lane < nb_lanes; lane++)
+    {
+        if (!lanes->workers[lane].started)
+        {
+            fill(arg, lane);
+        }
+    }
+
+    // Dalsi rez moze zacat az ked su vsetky segmenty hotove
+    platform_mutex_lock(&lanes->lock);
+    while (lanes->pending > 0)
+    {
+        platform_cond_wait(&lanes->slice_done, &lanes->lock);
+    }
+    platform_mutex_unlock(&lanes->lock);
+}
+
+// PSK klienta: Argon2id hesla so solou z BLAKE2b soli uloziska a identifikatora klienta
+// Server ma PSK v ulozisti prihlasovacich udajov, heslo klienta tak nepotrebuje
+// Uniknute uloziste neumozni rychle skusanie hesiel - kazdy pokus stoji jedno Argon2id,
+// sol uloziska zabrani pouzitiu vopred vypocitanych tabuliek pre rozne ulozista
+// Parametre:
+//   - client_id: identifikator klienta (CLIENT_ID_SIZE bajtov z client_id_encode)
+//   - psk_salt: sol uloziska (SALT_SIZE bajtov, server ju posle klientovi)
+//   - work_area: pracovna pamat aspon PSK_ARGON2_MEMORY_BLOCKS KB alebo NULL, ak sa ma namapovat
+int derive_client_psk(uint8_t *psk, const uint8_t *client_id, const char *password,
+                      const uint8_t *psk_salt, void *work_area)
+{
+    // Rovnake heslo dava pre rozne identifikatory rozne PSK
+    uint8_t salt[SALT_SIZE];
+    crypto_blake2b_ctx ctx;
+    crypto_blake2b_init(&ctx, SALT_SIZE);
+    crypto_blake2b_update(&ctx, psk_salt, SALT_SIZE);
+    crypto_blake2b_update(&ctx, client_id, CLIENT_ID_SIZE);
+    crypto_blake2b_final(&ctx, salt);
+
+    crypto_argon2_config config = {
+        .algorithm = CRYPTO_ARGON2_ID,
+        .nb_blocks = PSK_ARGON2_MEMORY_BLOCKS,
+        .nb_passes = PSK_ARGON2_ITERATIONS,
+        .nb_lanes = 1
+    };
+    crypto_argon2_inputs inputs = {
+        .pass = (const uint8_t *)password,
+        .pass_size = (uint32_t)strlen(password),
+        .salt = salt,
+        .salt_size = SALT_SIZE
+    };
+
+    void *allocated = NULL;
+    if (work_area == NULL)
+    {
+        int pages;
+        allocated = platform_large_alloc(PSK_ARGON2_WORK_AREA_SIZE, &pages);
+        if (!allocated)
+        {
+            fprintf(stderr, ERR_KEY_DERIVE_MEMORY);
+            return -1;
+        }
+        work_area = allocated;
+    }
+    crypto_argon2(psk, PSK_SIZE, work_area, config, inputs, crypto_argon2_no_extras);
+    platform_large_free(allocated, PSK_ARGON2_WORK_AREA_SIZE);
+    return 0;
+}
+
 // Interna implementacia derivacie kluca
 // Zdielana medzi klientom a serverom
 // Parametre:
-//   - password: heslo od uzivatela
+//   - psk: PSK klienta (PSK_SIZE bajtov, po odvodeni sa vymaze)
 //   - salt_input: existujuca sol (server) alebo NULL (klient)
 //   - key: vystupny buffer pre kluc
 //   - salt: vystupny buffer pre sol
 //   - generate_salt: true pre klienta, false pre server
-static int derive_key_internal(const char *password, const uint8_t *salt_input,
-                               uint8_t *key, uint8_t *salt, int generate_salt)
+//   - lanes: pocet liniek Argon2 dohodnuty s druhou stranou
+//   - work_area: pracovna pamat Argon2 (ARGON2_WORK_AREA_SIZE) alebo NULL, ak sa ma namapovat
+static int derive_key_internal(const uint8_t *psk, const uint8_t *salt_input,
+                               uint8_t *key, uint8_t *salt, int generate_salt,
+                               uint32_t lanes, void *work_area)
 {
     // Kontrola ci mame vsetky potrebne vstupy
-    // Ak chyba heslo, kluc alebo sol, funkcia nemoze pokracovat
-    if (!password || !key || !salt)
+    // Ak chyba PSK, kluc alebo sol, funkcia nemoze pokracovat
+    if (!psk || !key || !salt)
     {
         fprintf(stderr, ERR_KEY_DERIVE_PARAMS);
         return -1;
     }
 
+    // Pocet liniek meni vysledny kluc, preto musi byt na oboch stranach rovnaky
+    if (lanes < ARGON2_MIN_LANES || lanes > ARGON2_MAX_LANES)
+    {
+        fprintf(stderr, ERR_KEY_DERIVE_LANES, lanes);
+        return -1;
+    }
+
     // Bud vytvorime novu sol (pre klienta) alebo pouzijeme existujucu (pre server)
     // Sol pre heslo - robi ho tazsie uhadnutelnym
     if (generate_salt)
@@ -94,30 +343,45 @@ static int derive_key_internal(const char *password, const uint8_t *salt_input,
         .algorithm = CRYPTO_ARGON2_I,      // Vyberie verziu algoritmu (I = Argon2i, D = Argon2d)
         .nb_blocks = ARGON2_MEMORY_BLOCKS, // Kolko pamate sa pouzije (viac = bezpecnejsie)
         .nb_passes = ARGON2_ITERATIONS,    // Kolkokrat sa data prepocitaju (viac = bezpecnejsie)
-        .nb_lanes = ARGON2_LANES           // Kolko jadier procesora sa moze vyuzit
+        .nb_lanes = lanes                  // Kolko jadier procesora sa moze vyuzit
     };
 
     crypto_argon2_inputs inputs = {
-        .pass = (const uint8_t *)password,
-        .pass_size = strlen(password), // Dlzka hesla v bajtoch
+        .pass = psk,
+        .pass_size = PSK_SIZE, // Dlzka PSK v bajtoch
         .salt = salt,
         .salt_size = SALT_SIZE // Velkost soli (16 bajtov)
     };
 
-    void *work_area = malloc(config.nb_blocks * 1024); // Alokovanie pracovnej pamate (65536 * 1024 = 64 MB)
-    if (!work_area)
+    // Namapovanie pracovnej pamate (65536 * 1024 = 64 MB), ak ju nedodal volajuci (planovac servera)
+    // Stranky (velke, ak sa da) sa pridelia vopred, Argon2 tak nepocita s vypadkami stranok
+    void *allocated = NULL;
+    if (work_area == NULL)
     {
-        fprintf(stderr, ERR_KEY_DERIVE_MEMORY);
-        return -1;
+        int pages;
+        allocated = platform_large_alloc(ARGON2_WORK_AREA_SIZE, &pages);
+        if (!allocated)
+        {
+            fprintf(stderr, ERR_KEY_DERIVE_MEMORY);
+            return -1;
+        }
+        work_area = allocated;
     }
 
-    crypto_argon2(key, KEY_SIZE, work_area, config, inputs, crypto_argon2_no_extras);
+    // Segmenty jedneho rezu sa pocitaju paralelne, kazda linka vo vlastnom vlakne
+    // Vlakna sa spustia raz pre cele odvodenie, nie pre kazdy rez
+    // Monocypher na konci pracovnu pamat vymaze, planovac ju tak moze pouzit pre dalsie odvodenie
+    argon2_lanes_t lane_threads;
+    argon2_lanes_start(&lane_threads, lanes);
+    crypto_argon2_parallel(key, KEY_SIZE, work_area, config, inputs, crypto_argon2_no_extras,
+                           argon2_run_lanes, &lane_threads);
+    argon2_lanes_stop(&lane_threads);
 
-    // Po dokonceni vymazeme heslo z pamate
+    // Po dokonceni vymazeme PSK z pamate
     // Zabranuje to jeho odcitaniu z pamate po ukonceni programu
-    crypto_wipe((uint8_t *)password, strlen(password)); // Prepise pamat nulami
+    crypto_wipe((uint8_t *)psk, PSK_SIZE); // Prepise pamat nulami
 
-    free(work_area);
+    platform_large_free(allocated, ARGON2_WORK_AREA_SIZE);
 
     print_hex(generate_salt ? "Generated salt: " : "Using salt: ", salt, SALT_SIZE);
     print_hex("Derived key: ", key, KEY_SIZE);
@@ -126,38 +390,38 @@ static int derive_key_internal(const char *password, const uint8_t *salt_input,
 }
 
 // Serverova implementacia derivacie kluca
-// Pouziva prijatu sol od klienta
-int derive_key_server(const char *password, const uint8_t *received_salt,
-                      uint8_t *key, uint8_t *salt)
+// Pouziva prijatu sol od klienta a pracovnu pamat z planovaca odvodeni
+int derive_key_server(const uint8_t *psk, const uint8_t *received_salt,
+                      uint8_t *key, uint8_t *salt, uint32_t lanes, void *work_area)
 {
-    return derive_key_internal(password, received_salt, key, salt, 0);
+    return derive_key_internal(psk, received_salt, key, salt, 0, lanes, work_area);
 }
 
 // Klientska implementacia derivacie kluca
 // Generuje novu sol a odvodi kluc
-int derive_key_client(const char *password, uint8_t *key, uint8_t *salt)
+int derive_key_client(const uint8_t *psk, uint8_t *key, uint8_t *salt, uint32_t lanes)
 {
-    return derive_key_internal(password, NULL, key, salt, 1);
+    return derive_key_internal(psk, NULL, key, salt, 1, lanes, NULL);
 }
 
-// Rotacia aktualneho kluca pre vytvorenie noveho
-// Pouziva sa na pravidelnu obmenu klucov pre lepsiu bezpecnost
-void rotate_key(uint8_t *current_key, const uint8_t *previous_key)
+// Kluc epochy: BLAKE2b s hlavnym klucom ako klucom nad nonce relacie a cislom epochy
+// Kazda epocha sa odvodi priamo z hlavneho kluca, uniknuty kluc epochy tak neprezradi
+// kluce dalsich epoch (ani predchadzajucich)
+void rotate_key(uint8_t *epoch_key, const uint8_t *master_key, const uint8_t *nonces, uint32_t epoch)
 {
-    uint8_t nonce[NONCE_SIZE];
-    // Pouzitie fixnej hodnoty nonce pre deterministicku rotaciu
-    memset(nonce, 0xFF, NONCE_SIZE);
+    uint8_t counter[4];
+    counter[0] = (uint8_t)(epoch >> 24);
+    counter[1] = (uint8_t)(epoch >> 16);
+    counter[2] = (uint8_t)(epoch >> 8);
+    counter[3] = (uint8_t)epoch;
 
-    // Pouzitie BLAKE2b s pevnymi parametrami pre deterministicke odvodzovanie klucov
     crypto_blake2b_ctx ctx;
-    crypto_blake2b_init(&ctx, KEY_SIZE);
-    crypto_blake2b_update(&ctx, previous_key, KEY_SIZE);
-    crypto_blake2b_update(&ctx, nonce, NONCE_SIZE);
-    crypto_blake2b_final(&ctx, current_key);
-
-    // Bezpecne vymazanie citlivych dat z pamate
+    crypto_blake2b_keyed_init(&ctx, KEY_SIZE, master_key, KEY_SIZE);                                  // Hlavny kluc ako kluc BLAKE2b
+    crypto_blake2b_update(&ctx, nonces, SAKE_NONCES_SIZE);                                            // Nonce klienta a servera
+    crypto_blake2b_update(&ctx, counter, sizeof(counter));                                            // Cislo epochy
+    crypto_blake2b_update(&ctx, (const uint8_t *)SAKE_DERIV_EPOCH_TAG, strlen(SAKE_DERIV_EPOCH_TAG)); // Tag pre separaciu
+    crypto_blake2b_final(&ctx, epoch_key);
     crypto_wipe(&ctx, sizeof(ctx));
-    secure_wipe(nonce, NONCE_SIZE);
 }
 
 // Bezpecne vymazanie citlivych dat z pamate
@@ -180,4 +444,296 @@ void generate_key_validation(uint8_t *validation, const uint8_t *key)
     crypto_blake2b_update(&ctx, key, KEY_SIZE);
     crypto_blake2b_final(&ctx, validation);
     crypto_wipe(&ctx, sizeof(ctx));
-}
\ No newline at end of file
+}
+
+// Sifrovacie sady, ktore tento pocitac podporuje
+// XChaCha20-Poly1305 je dostupna vzdy, AES-256-GCM iba s AES-NI a PCLMULQDQ
+// a ak uroven jadier nie je vynutena na portable
+uint32_t aead_supported_suites(void)
+{
+    uint32_t suites = CIPHER_SUITE_XCHACHA20_POLY1305;
+    if (aes_gcm_supported())
+    {
+        suites |= CIPHER_SUITE_AES256_GCM;
+    }
+    return suites;
+}
+
+// Nazov sifrovacej sady pre vypis
+const char *aead_suite_name(uint32_t suite)
+{
+    switch (suite)
+    {
+    case CIPHER_SUITE_AES256_GCM:
+        return "AES-256-GCM";
+    case CIPHER_SUITE_XCHACHA20_POLY1305:
+        return "XChaCha20-Poly1305";
+    default:
+        return "unknown";
+    }
+}
+
+// Nonce AES-256-GCM pre blok: zakladny nonce XOR poradove cislo (big endian)
+static void aead_gcm_nonce(const aead_ctx_t *ctx, uint64_t sequence, uint8_t nonce[AES_GCM_NONCE_SIZE])
+{
+    memcpy(nonce, ctx->gcm_iv, AES_GCM_NONCE_SIZE);
+    for (int i = 0; i < 8; i++)
+    {
+        nonce[AES_GCM_NONCE_SIZE - 1 - i] ^= (uint8_t)(sequence >> (8 * i));
+    }
+}
+
+// Prud XChaCha20-Poly1305 pre jeden blok: kopia zakladneho prudu s nonce XOR poradove cislo
+static void aead_chacha_stream(const aead_ctx_t *ctx, uint64_t sequence, crypto_aead_ctx *stream)
+{
+    *stream = ctx->stream;
+    for (int i = 0; i < 8; i++)
+    {
+        stream->nonce[i] ^= (uint8_t)(sequence >> (8 * i));
+    }
+}
+
+// Zacne novy prud pre kluc relacie (pri nadviazani spojenia a po kazdej rotacii kluca)
+// Zakladny nonce sa odvodi z kluca, kluc relacie je pre kazdu rotaciu novy,
+// takze dvojica kluc a nonce sa nikdy nezopakuje
+void aead_init(aead_ctx_t *ctx, uint32_t suite, const uint8_t *key)
+{
+    uint8_t stream_nonce[NONCE_SIZE];
+    crypto_blake2b_keyed(stream_nonce, NONCE_SIZE, key, KEY_SIZE,
+                         (const uint8_t *)AEAD_STREAM_NONCE_TAG, strlen(AEAD_STREAM_NONCE_TAG));
+
+    ctx->suite = suite;
+    ctx->sequence = 0;
+    if (suite == CIPHER_SUITE_AES256_GCM)
+    {
+        aes_gcm_init(&ctx->gcm, key);
+        memcpy(ctx->gcm_iv, stream_nonce, AES_GCM_NONCE_SIZE);
+    }
+    else
+    {
+        // HChaCha20 sa vypocita iba tu, nie pre kazdy blok
+        crypto_aead_init_x(&ctx->stream, key, stream_nonce);
+    }
+    crypto_wipe(stream_nonce, sizeof(stream_nonce));
+}
+
+// Bezpecne vymazanie kontextu vratane rozvinuteho kluca
+void aead_wipe(aead_ctx_t *ctx)
+{
+    crypto_wipe(ctx, sizeof(*ctx));
+}
+
+// Zasifruje blok s poradovym cislom sequence
+// Nonce bloku je zakladny nonce XOR poradove cislo (ako v TLS 1.3):
+//   - AES-256-GCM: poslednych 8 bajtov 12-bajtoveho nonce (big endian)
+//   - XChaCha20-Poly1305: poslednych 8 bajtov 24-bajtoveho nonce (little endian),
+//     prvych 16 bajtov sa nemeni, takze HChaCha20 z aead_init plati pre vsetky bloky
+void aead_encrypt_at(const aead_ctx_t *ctx, uint64_t sequence, uint8_t *cipher_text,
+                     uint8_t *tag, const uint8_t *plain_text, size_t size)
+{
+    if (ctx->suite == CIPHER_SUITE_AES256_GCM)
+    {
+        uint8_t nonce[AES_GCM_NONCE_SIZE];
+        aead_gcm_nonce(ctx, sequence, nonce);
+        aes_gcm_encrypt(&ctx->gcm, cipher_text, tag, nonce, NULL, 0, plain_text, size);
+    }
+    else
+    {
+        crypto_aead_ctx stream;
+        aead_chacha_stream(ctx, sequence, &stream);
+        crypto_aead_write(&stream, cipher_text, tag, NULL, 0, plain_text, size);
+        crypto_wipe(&stream, sizeof(stream));
+    }
+}
+
+// Overi a desifruje blok s poradovym cislom sequence
+// Vrati 0 pri uspechu, -1 ak tag nesedi (plain_text potom neobsahuje neovereny text)
+int aead_decrypt_at(const aead_ctx_t *ctx, uint64_t sequence, uint8_t *plain_text,
+                    const uint8_t *tag, const uint8_t *cipher_text, size_t size)
+{
+    if (ctx->suite == CIPHER_SUITE_AES256_GCM)
+    {
+        uint8_t nonce[AES_GCM_NONCE_SIZE];
+        aead_gcm_nonce(ctx, sequence, nonce);
+        return aes_gcm_decrypt(&ctx->gcm, plain_text, tag, nonce, NULL, 0, cipher_text, size);
+    }
+    crypto_aead_ctx stream;
+    aead_chacha_stream(ctx, sequence, &stream);
+    int mismatch = crypto_aead_read(&stream, plain_text, tag, NULL, 0, cipher_text, size);
+    crypto_wipe(&stream, sizeof(stream));
+    return mismatch;
+}
+
+// Zasifruje dalsi blok prudu dohodnutou sadou
+void aead_encrypt(aead_ctx_t *ctx, uint8_t *cipher_text, uint8_t *tag,
+                  const uint8_t *plain_text, size_t size)
+{
+    aead_encrypt_at(ctx, ctx->sequence, cipher_text, tag, plain_text, size);
+    ctx->sequence++;
+}
+
+// Overi a desifruje dalsi blok prudu dohodnutou sadou
+// Vrati 0 pri uspechu, -1 ak tag nesedi (plain_text potom neobsahuje neovereny text a prud sa neposunie)
+int aead_decrypt(aead_ctx_t *ctx, uint8_t *plain_text, const uint8_t *tag,
+                 const uint8_t *cipher_text, size_t size)
+{
+    if (aead_decrypt_at(ctx, ctx->sequence, plain_text, tag, cipher_text, size) != 0)
+    {
+        return -1;
+    }
+    ctx->sequence++;
+    return 0;
+}
+
+// Nacitanie jedneho prepinaca pravidla rotacie v tvare <option><cislo>
+// Navratova hodnota: 0 ak prepinac chyba alebo je platny, -1 pri neplatnom cisle
+static int rotation_option(const char *arg, const char *option, uint32_t *value)
+{
+    size_t option_len = strlen(option);
+    if (strncmp(arg, option, option_len) != 0)
+    {
+        return 0;
+    }
+    char *end;
+    errno = 0;
+    unsigned long parsed = strtoul(arg + option_len, &end, 10);
+    if (errno != 0 || end == arg + option_len || *end != '\0' || parsed > UINT32_MAX)
+    {
+        fprintf(stderr, ERR_ROTATION_OPTION, arg);
+        return -1;
+    }
+    *value = (uint32_t)parsed;
+    return 0;
+}
+
+// Pravidla rotacie, ktore tato strana navrhne pri nadviazani spojenia
+// Predvolene hodnoty z constants.h sa daju zmenit prepinacmi prikazoveho riadku
+int rotation_policy_from_args(rotation_policy_t *policy, int argc, char *argv[])
+{
+    policy->frames = KEY_ROTATION_BLOCKS;
+    policy->mib = KEY_ROTATION_MIB;
+    policy->ms = KEY_ROTATION_MS;
+    for (int i = 1; i < argc; i++)
+    {
+        if (rotation_option(argv[i], KEY_ROTATION_FRAMES_OPTION, &policy->frames) != 0 ||
+            rotation_option(argv[i], KEY_ROTATION_MIB_OPTION, &policy->mib) != 0 ||
+            rotation_option(argv[i], KEY_ROTATION_MS_OPTION, &policy->ms) != 0)
+        {
+            return -1;
+        }
+    }
+    if (policy->frames == 0 && policy->mib == 0 && policy->ms == 0)
+    {
+        fprintf(stderr, ERR_ROTATION_DISABLED);
+        return -1;
+    }
+    return 0;
+}
+
+// Ma epocha, ktora uz obsahuje frames blokov a bytes bajtov a trva elapsed_ms, skoncit?
+// Vyhodnocuje sa pred pridanim dalsieho bloku, posledny blok epochy teda moze hranicu bajtov prekrocit
+int rotation_policy_due(const rotation_policy_t *policy, uint64_t frames,
+                        uint64_t bytes, uint64_t elapsed_ms)
+{
+    return (policy->frames != 0 && frames >= policy->frames) ||
+           (policy->mib != 0 && bytes >= (uint64_t)policy->mib * 1024 * 1024) ||
+           (policy->ms != 0 && elapsed_ms >= policy->ms);
+}
+
+// Priprava prudu epochy (okrem epochy 0) z kopie hlavneho kluca, kluc epochy sa hned vymaze
+// Vola ju vzdy iba jedno vlakno (vlakno na pozadi, alebo odovzdavajuce, ak vlakno nebezi)
+static void key_ratchet_prepare(key_ratchet_t *ratchet, uint32_t epoch)
+{
+    uint8_t key[KEY_SIZE];
+    rotate_key(key, ratchet->master_key, ratchet->nonces, epoch);
+    aead_wipe(&ratchet->slots[epoch % KEY_RATCHET_SLOTS]);
+    aead_init(&ratchet->slots[epoch % KEY_RATCHET_SLOTS], ratchet->suite, key);
+    secure_wipe(key, KEY_SIZE);
+}
+
+// Vlakno na pozadi - udrziava KEY_RATCHET_AHEAD epoch pred poslednou odovzdanou
+// Kazdu odvodi z kopie hlavneho kluca (nie z kluca predchadzajucej epochy), takze mimo
+// zamku pracuje iba s cislom epochy a jej miestom, ktore patrilo epoche, ktoru uz
+// volajuci nepouziva (drzi iba posledne dve). Prechod ostava odovzdanim ukazovatela
+static void key_ratchet_worker(void *arg)
+{
+    key_ratchet_t *ratchet = (key_ratchet_t *)arg;
+
+    platform_mutex_lock(&ratchet->lock);
+    while (!ratchet->stop)
+    {
+        if (ratchet->prepared >= ratchet->taken + KEY_RATCHET_AHEAD)
+        {
+            platform_cond_wait(&ratchet->changed, &ratchet->lock);
+            continue;
+        }
+        uint32_t epoch = ratchet->prepared;
+        platform_mutex_unlock(&ratchet->lock);
+        key_ratchet_prepare(ratchet, epoch);
+        platform_mutex_lock(&ratchet->lock);
+        ratchet->prepared++;
+        platform_cond_broadcast(&ratchet->changed);
+    }
+    platform_mutex_unlock(&ratchet->lock);
+}
+
+// Zaciatok retazca epoch a spustenie vlakna na pozadi (ak background nie je 0)
+// Epocha 0 sa pripravi hned z kluca relacie, ten si retazec nedrzi
+// Bez vlakna (alebo ak sa ho nepodari spustit) sa epochy pripravia az pri odovzdani -
+// to pouziva reaktor servera, kde by vlakno pre kazde spojenie stalo viac nez priprava epochy
+void key_ratchet_init(key_ratchet_t *ratchet, uint32_t suite, const uint8_t *session_key,
+                      const uint8_t *master_key, const uint8_t *client_nonce,
+                      const uint8_t *server_nonce, int background)
+{
+    memset(ratchet, 0, sizeof(*ratchet));
+    ratchet->suite = suite;
+    memcpy(ratchet->master_key, master_key, KEY_SIZE);
+    memcpy(ratchet->nonces, client_nonce, SAKE_NONCE_CLIENT_SIZE);
+    memcpy(ratchet->nonces + SAKE_NONCE_CLIENT_SIZE, server_nonce, SAKE_NONCE_SERVER_SIZE);
+    aead_init(&ratchet->slots[0], suite, session_key);
+    ratchet->prepared = 1;
+    platform_mutex_init(&ratchet->lock);
+    platform_cond_init(&ratchet->changed);
+    ratchet->threaded = background && platform_thread_create(&ratchet->thread, key_ratchet_worker, ratchet) == 0;
+}
+
+// Odovzda prud dalsej epochy a jej cislo
+// Prud ostava platny, kym volajuci neprevezme dalsie dve epochy - dovtedy moze
+// dokoncit bloky predchadzajucej epochy, zatial co uz spracuva bloky novej
+const aead_ctx_t *key_ratchet_next(key_ratchet_t *ratchet, uint32_t *epoch)
+{
+    platform_mutex_lock(&ratchet->lock);
+    while (ratchet->prepared <= ratchet->taken)
+    {
+        if (ratchet->threaded)
+        {
+            // Epocha este nie je pripravena - nastava iba pri velmi kratkych epochach
+            platform_cond_wait(&ratchet->changed, &ratchet->lock);
+        }
+        else
+        {
+            key_ratchet_prepare(ratchet, ratchet->prepared);
+            ratchet->prepared++;
+        }
+    }
+    *epoch = ratchet->taken++;
+    platform_cond_broadcast(&ratchet->changed);
+    platform_mutex_unlock(&ratchet->lock);
+    return &ratchet->slots[*epoch % KEY_RATCHET_SLOTS];
+}
+
+// Zastavenie vlakna na pozadi a bezpecne vymazanie kopie hlavneho kluca a pripravenych prudov
+void key_ratchet_wipe(key_ratchet_t *ratchet)
+{
+    platform_mutex_lock(&ratchet->lock);
+    ratchet->stop = 1;
+    platform_cond_broadcast(&ratchet->changed);
+    platform_mutex_unlock(&ratchet->lock);
+    if (ratchet->threaded)
+    {
+        platform_thread_join(&ratchet->thread);
+    }
+    platform_cond_destroy(&ratchet->changed);
+    platform_mutex_destroy(&ratchet->lock);
+    crypto_wipe(ratchet, sizeof(*ratchet));
+}
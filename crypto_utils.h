@@ -8,12 +8,15 @@
  * Popis:
  *     Tento subor obsahuje funkcie pre:
  *     - Bezpecne generovanie nahodnych cisel pre nonce a salt
- *     - Vytvaranie klucov z hesiel pomocou Argon2
+ *     - Vyber kryptografickych jadier podla procesora a ich samotest
+ *     - Vytvaranie klucov z hesiel pomocou Argon2 (linky paralelne vo vlaknach)
  *     - Bezpecne mazanie citlivych dat
- *     - Rotaciu klucov
+ *     - Rotaciu klucov (epochy klucov relacie s vopred pripravenym prudom)
+ *     - Sifrovanie blokov nezavisle od dohodnutej sifrovacej sady
  *
  * Zavislosti:
  *     - Monocypher 4.0.2 (sifrovacie algoritmy)
+ *     - aes_gcm.h (AES-256-GCM)
  *     - constants.h (konstanty programu)
  *     - sake.h (pre SAKE protokol)
  *     - platform.h (platform-specificke funkcie)
@@ -25,6 +28,7 @@
 #include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t)
 
 #include "monocypher.h" // Pre Monocypher kryptograficke funkcie
+#include "aes_gcm.h"    // Pre sifrovaciu sadu AES-256-GCM
 #include "constants.h"  // Definicie konstant pre program
 #include "sake.h"       // Pre SAKE protokol funkcie
 #include "platform.h"   // Pre funkcie specificke pre operacny system
@@ -34,16 +38,26 @@ void print_hex(const char *label, uint8_t *data, int len); // Vypise data v cita
 
 // Zakladne kryptograficke funkcie
 void generate_random_bytes(uint8_t *buffer, size_t size); // Vytvori bezpecne nahodne cisla
+int select_crypto_impl(int argc, char *argv[]);           // Vyberie jadra Monocypher (prepinac/premenna) a overi ich samotestom
 
 // Funkcie pre pracu s heslami
-int derive_key_server(const char *password, const uint8_t *received_salt, // Server: Vytvori kluc z hesla a prijatej soli
-                      uint8_t *key, uint8_t *salt);
+uint32_t argon2_preferred_lanes(void); // Pocet liniek Argon2, ktory vie tento pocitac spracovat paralelne
 
-int derive_key_client(const char *password, uint8_t *key, uint8_t *salt); // Klient: Vytvori kluc z hesla a novej soli
+int derive_client_psk(uint8_t *psk, const uint8_t *client_id, // PSK klienta z hesla (Argon2id, sol uloziska a identifikator)
+                      const char *password, const uint8_t *psk_salt, void *work_area);
+
+int derive_key_server(const uint8_t *psk, const uint8_t *received_salt, // Server: Vytvori kluc z PSK a prijatej soli
+                      uint8_t *key, uint8_t *salt, uint32_t lanes,      // (v dodanej pracovnej pamati, NULL = alokuje)
+                      void *work_area);
+
+int derive_key_client(const uint8_t *psk, uint8_t *key, uint8_t *salt, // Klient: Vytvori kluc z PSK a novej soli
+                      uint32_t lanes);
 
 // Funkcie pre bezpecnost spojenia
-void rotate_key(uint8_t *current_key, // Vytvori novy kluc z existujuceho pre lepsiu bezpecnost
-                const uint8_t *previous_key);
+void rotate_key(uint8_t *epoch_key, // Kluc epochy z hlavneho kluca, nonce klienta a servera (SAKE_NONCES_SIZE) a cisla epochy
+                const uint8_t *master_key,
+                const uint8_t *nonces,
+                uint32_t epoch);
 
 void secure_wipe(void *data, size_t size); // Bezpecne vymaze citlive data z pamate
 
@@ -51,4 +65,74 @@ void secure_wipe(void *data, size_t size); // Bezpecne vymaze citlive data z pam
 void generate_key_validation(uint8_t *validation, // Vytvori kontrolny kod pre overenie kluca
                              const uint8_t *key);
 
+// Sifrovanie s autentizaciou nezavisle od sifrovacej sady
+// Jeden prud (stream) na kluc relacie: nonce blokov sa odvodia z poradoveho cisla,
+// takze sa neposielaju a blok prijaty mimo poradia alebo opakovane neprejde overenim
+typedef struct
+{
+    uint32_t suite;                     // Dohodnuta sifrovacia sada (CIPHER_SUITE_*)
+    crypto_aead_ctx stream;             // XChaCha20-Poly1305: kluc po HChaCha20 a zakladny nonce
+    aes_gcm_ctx_t gcm;                  // Pripraveny kluc pre AES-256-GCM
+    uint8_t gcm_iv[AES_GCM_NONCE_SIZE]; // Zakladny nonce AES-256-GCM
+    uint64_t sequence;                  // Poradove cislo nasledujuceho bloku
+} aead_ctx_t;
+
+uint32_t aead_supported_suites(void);        // Maska sifrovacich sad, ktore zvladne tento pocitac
+const char *aead_suite_name(uint32_t suite); // Citatelny nazov sifrovacej sady
+
+void aead_init(aead_ctx_t *ctx, uint32_t suite, const uint8_t *key); // Zacne novy prud pre kluc relacie
+void aead_wipe(aead_ctx_t *ctx);                                     // Bezpecne vymaze kontext
+
+void aead_encrypt(aead_ctx_t *ctx, uint8_t *cipher_text, uint8_t *tag, // Zasifruje dalsi blok prudu a vytvori tag
+                  const uint8_t *plain_text, size_t size);
+
+int aead_decrypt(aead_ctx_t *ctx, uint8_t *plain_text, const uint8_t *tag, // Overi tag a desifruje dalsi blok prudu
+                 const uint8_t *cipher_text, size_t size);
+
+// Sifrovanie bloku s danym poradovym cislom - kontext sa nemeni,
+// takze viac vlakien moze naraz spracovat rozne bloky toho isteho prudu
+void aead_encrypt_at(const aead_ctx_t *ctx, uint64_t sequence, uint8_t *cipher_text, // Zasifruje blok s poradovym cislom
+                     uint8_t *tag, const uint8_t *plain_text, size_t size);
+
+int aead_decrypt_at(const aead_ctx_t *ctx, uint64_t sequence, uint8_t *plain_text, // Overi a desifruje blok s poradovym cislom
+                    const uint8_t *tag, const uint8_t *cipher_text, size_t size);
+
+// Pravidla rotacie kluca - kluc sa zmeni, ked plati prve z nich (0 = pravidlo sa nepouziva)
+typedef struct
+{
+    uint32_t frames; // Po kolkych blokoch
+    uint32_t mib;    // Po kolkych MiB otvoreneho textu
+    uint32_t ms;     // Po kolkych milisekundach
+} rotation_policy_t;
+
+int rotation_policy_from_args(rotation_policy_t *policy, int argc, char *argv[]); // Predvolene pravidla, upravene prepinacmi
+int rotation_policy_due(const rotation_policy_t *policy, uint64_t frames,       // 1 ak ma epocha s danym obsahom a vekom skoncit
+                        uint64_t bytes, uint64_t elapsed_ms);
+
+// Kluce epoch relacie pre rotaciu kluca bez prerusenia prenosu
+// Epocha 0 pouzije kluc relacie, kluc kazdej dalsej epochy sa odvodi z kopie hlavneho
+// kluca a nonce relacie (rotate_key) - uniknuty kluc epochy neprezradi ziadny iny.
+// Kopiu hlavneho kluca drzi iba retazec epoch. Vlakno na pozadi drzi KEY_RATCHET_AHEAD
+// epoch pripravenych vopred, prechod na dalsiu epochu je iba odovzdanie ukazovatela
+typedef struct
+{
+    uint32_t suite;                      // Dohodnuta sifrovacia sada (CIPHER_SUITE_*)
+    aead_ctx_t slots[KEY_RATCHET_SLOTS]; // Prud epochy e je v slots[e % KEY_RATCHET_SLOTS]
+    uint8_t master_key[KEY_SIZE];        // Kopia hlavneho kluca z nadviazania spojenia
+    uint8_t nonces[SAKE_NONCES_SIZE];    // Nonce klienta a servera z nadviazania spojenia
+    uint32_t prepared;                   // Pocet pripravenych epoch
+    uint32_t taken;                      // Pocet odovzdanych epoch
+    int stop;                            // 1 ak ma vlakno na pozadi skoncit
+    int threaded;                        // 1 ak bezi vlakno na pozadi (inak sa epochy pripravuju pri odovzdani)
+    platform_thread_t thread;            // Vlakno na pozadi
+    platform_mutex_t lock;               // Chrani prepared, taken a stop
+    platform_cond_t changed;             // Zmena prepared, taken alebo stop
+} key_ratchet_t;
+
+void key_ratchet_init(key_ratchet_t *ratchet, uint32_t suite, const uint8_t *session_key, // Epocha 0 pouzije kluc relacie,
+                      const uint8_t *master_key, const uint8_t *client_nonce,             // dalsie hlavny kluc a nonce
+                      const uint8_t *server_nonce, int background);                       // background: epochy pripravuje vlakno
+const aead_ctx_t *key_ratchet_next(key_ratchet_t *ratchet, uint32_t *epoch);              // Odovzda prud dalsej epochy
+void key_ratchet_wipe(key_ratchet_t *ratchet);                                            // Zastavi vlakno a vymaze vsetky kluce
+
 #endif // CRYPTO_UTILS_H
\ No newline at end of file
@@ -7,6 +7,13 @@
 #define ERR_HANDSHAKE "Error: Failed during initial handshake - check network connection\n"
 #define ERR_SALT_RECEIVE "Error: Failed to receive salt from client\n"
 #define ERR_SALT_SEND "Error: Failed to send salt to server\n"
+#define ERR_PARAMS_SEND "Error: Failed to send session parameters\n"
+#define ERR_PARAMS_RECEIVE "Error: Failed to receive session parameters\n"
+#define ERR_PSK_SALT_RECEIVE "Error: Failed to receive password salt\n"
+#define ERR_PARAMS_INVALID "Error: Peer proposed invalid session parameters\n"
+#define ERR_CIPHER_SUITE "Error: No cipher suite supported by both sides\n"
+#define ERR_FRAME_ALLOC "Error: Failed to allocate transfer buffers\n"
+#define ERR_PIPELINE_THREAD "Error: Failed to start transfer threads\n"
 #define ERR_KEY_DERIVATION "Error: Key derivation failed\n"
 #define ERR_KEY_ACK "Error: Failed to send key acknowledgment\n"
 #define ERR_SESSION_SETUP "Error: Failed to start session setup\n"
@@ -15,7 +22,6 @@
 #define ERR_SESSION_CONFIRM "Error: Failed to confirm session setup\n"
 #define ERR_FILENAME_RECEIVE "Error: Failed to receive file name from client (%s)\n"
 #define ERR_FILE_CREATE "Error: Failed to create file '%s' (%s)\n"
-#define ERR_CHUNK_SIZE "Error: Failed to read chunk size\n"
 #define ERR_CHUNK_PROCESS "Error: Failed to process chunk\n"
 #define ERR_TRANSFER_INTERRUPTED "Error: File transfer failed or was interrupted prematurely\n"
 
@@ -27,9 +33,7 @@
 #define ERR_SOCKET_ACCEPT "Error: Accept failed\n"
 #define ERR_INVALID_ADDRESS "Error: Invalid address or port\n"
 #define ERR_CONNECTION_FAILED "Error: Connection failed\n"
-#define ERR_READY_SIGNAL "Error: Failed to send ready signal\n"
 #define ERR_READY_RECEIVE "Error: Failed to receive ready signal\n"
-#define ERR_KEY_ACK_SEND "Error: Failed to send key acknowledgment (sent %d bytes)\n"
 #define ERR_KEY_ACK_RECEIVE "Error: Failed to receive key acknowledgment (received %d bytes)\n"
 #define ERR_KEY_ACK_INVALID "Error: Invalid key acknowledgment received ('%.*s')\n"
 #define ERR_SYNC_SEND "Failed to send sync message\n"
@@ -37,15 +41,35 @@
 #define ERR_SYNC_MESSAGE "Invalid sync message\n"
 #define ERR_SYNC_ACK_SEND "Failed to send sync acknowledgment\n"
 
+// Chybove spravy pre reaktor servera
+#define ERR_REACTOR_INIT "Error: Failed to start the event loop or its worker threads\n"
+#define ERR_REACTOR_WAIT "Error: Waiting for socket events failed (%s)\n"
+#define ERR_SOCKET_NONBLOCKING "Error: Failed to switch socket to non-blocking mode\n"
+#define ERR_REACTOR_THREAD "Error: Failed to start reactor thread\n"
+#define ERR_SOCKET_REUSEPORT "Warning: SO_REUSEPORT is not available, reactors share one listening socket\n"
+#define ERR_COUNT_OPTION "Error: Invalid value '%s' for %s (use 1-%u%s)\n"
+#define ERR_KDF_SCHEDULER "Error: Cannot reserve key derivation work memory (budget %u MiB, %u MiB per derivation)\n"
+#define ERR_CREDENTIALS_OPEN "Error: Cannot open credential store %s (%s)\n"
+#define ERR_CREDENTIALS_FORMAT "Error: %s is not a valid credential store\n"
+#define ERR_CREDENTIALS_PERMISSIONS "Error: Credential store %s is accessible by other users (chmod 600 it)\n"
+#define ERR_CREDENTIALS_LINE "Error: Invalid entry on line %u of %s (expected client-id:password)\n"
+#define ERR_CREDENTIALS_DUPLICATE "Error: Duplicate client ID on line %u of %s\n"
+#define ERR_CREDENTIALS_WRITE "Error: Cannot write credential store %s\n"
+#define ERR_CREDENTIALS_OPTION "Error: --build-credentials= needs --credentials= for the output file\n"
+#define ERR_CLIENT_ID_INVALID "Error: Invalid client ID (1-32 printable characters, no spaces or ':')\n"
+#define ERR_CLIENT_UNKNOWN "Error: Unknown client ID %s\n"
+#define ERR_KDF_QUEUE_FULL "Error: Key derivation queue is full, connection refused\n"
+#define ERR_CONNECTION_ALLOC "Error: Not enough memory for a new connection\n"
+#define ERR_CONNECTION_CLOSED "Error: Client closed the connection during %s\n"
+#define ERR_CONNECTION_IO "Error: Connection failed during %s (%s)\n"
+#define ERR_CONNECTION_TIMEOUT "Error: Client did not respond in time during %s\n"
+#define ERR_CONNECTION_DROPPED "Error: Connection dropped during %s\n"
+
 // Chybove spravy pre rotaciu klucov
-#define ERR_KEY_VALIDATE_SIGNAL "Error: Failed to receive validation marker\n"
-#define ERR_KEY_VALIDATE_RECEIVE "Error: Failed to receive key validation\n"
-#define ERR_KEY_VALIDATE_MISMATCH "Error: Key validation failed - keys do not match\n"
-#define ERR_KEY_ROTATION_READY "Error: Failed to confirm key rotation\n"
-#define ERR_NEW_CLIENT_NONCE_SEND "Error: Failed to send new client nonce\n"
-#define ERR_NEW_CLIENT_NONCE_RECEIVE "Error: Failed to receive new client nonce\n"
-#define ERR_NEW_SERVER_NONCE_SEND "Error: Failed to send new server nonce\n"
-#define ERR_NEW_SERVER_NONCE_RECEIVE "Error: Failed to receive new server nonce\n"
+#define ERR_FRAME_EPOCH "Error: Chunk uses key epoch %u, expected epoch %u or the next one\n"
+#define ERR_ROTATION_POLICY "Error: Peer did not rotate the key as agreed (epoch %u)\n"
+#define ERR_ROTATION_OPTION "Error: Invalid key rotation option '%s'\n"
+#define ERR_ROTATION_DISABLED "Error: At least one key rotation limit must be set\n"
 
 // Chybove spravy pre casove limity
 #define ERR_TIMEOUT_RECV "Error: Failed to set receive timeout (%s)\n"
@@ -55,8 +79,14 @@
 // Chybove spravy pre kryptograficke operacie
 #define ERR_RANDOM_LINUX "Error: Failed to generate random bytes (%s)\n"
 #define ERR_RANDOM_WINDOWS "Error: Failed to generate random bytes (BCrypt error)\n"
+#define ERR_CRYPTO_IMPL "Error: Crypto implementation '%s' is unknown or not supported by this CPU\n"
+#define ERR_CRYPTO_SELF_TEST "Error: Crypto self-test failed for '%s' kernels, falling back to '%s'\n"
+#define ERR_CRYPTO_SELF_TEST_FATAL "Error: Crypto self-test failed, refusing to transfer data\n"
+#define ERR_IO_ENGINE "Error: Unknown I/O engine '%s' (use blocking or io_uring)\n"
+#define ERR_IO_RING_UNAVAILABLE "Warning: io_uring is not available, using blocking I/O\n"
 #define ERR_KEY_DERIVE_PARAMS "Error: Invalid parameters for key derivation\n"
 #define ERR_KEY_DERIVE_MEMORY "Error: Failed to allocate memory for key derivation\n"
+#define ERR_KEY_DERIVE_LANES "Error: Invalid number of Argon2 lanes (%u)\n"
 
 // Chybove spravy pre nastavenia klienta
 #define ERR_IP_ADDRESS_READ "Error: Failed to read IP address\n"
@@ -69,7 +99,6 @@
 #define ERR_FILENAME_READ "Error: Failed to read file name from input\n"
 #define ERR_FILE_OPEN "Error: Cannot open file '%s' (%s)\n"
 #define ERR_FILENAME_SEND "Error: Failed to send file name to server (%s)\n"
-#define ERR_KEY_ROTATION_ACK "Error: Failed to acknowledge key rotation\n"
 #define ERR_SERVER_ACK "Error: Server did not acknowledge successful transfer completion.\n"
 
 // SAKE chybove spravy
@@ -88,8 +117,13 @@
 #define ERR_SAKE_MITM_SUSPECTED_CLIENT "Error: SAKE authentication failed by server. Potential Man-in-the-Middle attack suspected or incorrect password.\n"
 
 // Chybove spravy pre spracovanie blokov
-#define ERR_RECEIVE_ENCRYPTED_CHUNK "Error: Failed to receive encrypted chunk\n"
+#define ERR_SEND_ENCRYPTED_CHUNK "Error: Failed to send encrypted chunk\n"
+#define ERR_FILE_READ "Error: Failed to read from file\n"
+#define ERR_FRAME_SIZE "Error: Chunk of %u bytes exceeds the agreed frame size (%u bytes)\n"
 #define ERR_DECRYPT_CHUNK_AUTH "Error: Failed to decrypt chunk (authentication failed)\n"
 #define ERR_WRITE_TO_FILE "Error: Failed to write to file\n"
+#define ERR_FILE_SIZE_MISMATCH "Error: Received data does not match the announced file size (%llu bytes)\n"
+#define ERR_FILE_RENAME "Error: Failed to move received file to '%s' (%s)\n"
+#define ERR_FILE_NO_SPACE "Error: Announced file size %llu bytes exceeds free disk space (%llu bytes)\n"
 
 #endif // ERRORS_H
@@ -0,0 +1,400 @@
+/*******************************************************************************
+ * Program:    Volitelny I/O engine io_uring pre zabezpeceny prenos suborov
+ * Subor:      io_ring.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia I/O enginu nad io_uring:
+ *     - Vytvorenie kruhu a namapovanie jeho front priamo cez io_uring_setup a mmap
+ *     - Poziadavky read (s registrovanymi buffermi) a sendmsg
+ *     - Casovy limit poziadavky cez pripojenu poziadavku LINK_TIMEOUT
+ *       (io_uring neberie do uvahy SO_RCVTIMEO a SO_SNDTIMEO socketu)
+ *     Ak jadro io_uring nepodporuje, io_ring_init() vrati -1 a volajuci pouzije
+ *     blokujuce volania.
+ *
+ * Zavislosti:
+ *     - io_ring.h (deklaracie funkcii)
+ *     - constants.h (konstanty programu)
+ *     - errors.h (chybove spravy)
+ ******************************************************************************/
+
+#include <stdio.h>  // Kniznica pre standardny vstup a vystup (vypis chyb)
+#include <stdlib.h> // Kniznica pre premenne prostredia
+#include <string.h> // Kniznica pre pracu s retazcami a pamatou
+#include <errno.h>  // Kniznica pre systemove chyby
+
+#include "io_ring.h"   // Deklaracie funkcii
+#include "constants.h" // Definicie konstant pre program
+#include "errors.h"    // Chybove spravy
+
+#ifdef IO_RING_SUPPORTED
+#include <linux/io_uring.h> // Struktury a konstanty io_uring
+#include <sys/mman.h>       // Pre mapovanie front kruhu
+#include <sys/socket.h>     // Pre MSG_WAITALL a MSG_NOSIGNAL
+#include <sys/syscall.h>    // Cisla systemovych volani io_uring
+#include <sys/uio.h>        // Pre struct iovec
+#include <unistd.h>         // Pre syscall a close
+#endif
+
+// Vyber I/O enginu za behu
+// Predvolene su blokujuce volania, io_uring sa zapne prepinacom --io-engine=io_uring
+// alebo premennou SAKE_IO_ENGINE (prepinac ma prednost)
+int io_engine_select(int argc, char *argv[])
+{
+    const char *engine = getenv(IO_ENGINE_ENV);
+    size_t option_len = strlen(IO_ENGINE_OPTION);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], IO_ENGINE_OPTION, option_len) == 0)
+        {
+            engine = argv[i] + option_len;
+        }
+    }
+
+    if (engine == NULL || strcmp(engine, IO_ENGINE_NAME_BLOCKING) == 0)
+    {
+        return IO_ENGINE_BLOCKING;
+    }
+    if (strcmp(engine, IO_ENGINE_NAME_URING) == 0)
+    {
+        return IO_ENGINE_URING;
+    }
+    fprintf(stderr, ERR_IO_ENGINE, engine);
+    return -1;
+}
+
+#ifdef IO_RING_SUPPORTED
+
+// Hodnota user_data pripojenej poziadavky LINK_TIMEOUT (jej dokoncenie sa preskoci)
+#define IO_RING_TIMEOUT_DATA UINT64_MAX
+
+// Potrebne vlastnosti jadra:
+// - NODROP: dokoncenie sa nestrati ani pri plnej fronte dokonceni
+// - RW_CUR_POS: citanie a zapis od aktualnej polohy v subore (offset -1), aj pre rury
+// - LINKED_FILE (jadro 6.0+): zaroven sendmsg s MSG_WAITALL odosle vsetko, ciastocne odoslanie je chyba
+#ifndef IORING_FEAT_LINKED_FILE
+#define IORING_FEAT_LINKED_FILE (1U << 12) // Starsia hlavicka, o podpore rozhodne jadro
+#endif
+#define IO_RING_REQUIRED_FEATURES (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS | IORING_FEAT_LINKED_FILE)
+
+// Vytvorenie kruhu s entries poziadavkami a namapovanie jeho front
+int io_ring_init(io_ring_t *ring, unsigned entries)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if ((params.features & IO_RING_REQUIRED_FEATURES) != IO_RING_REQUIRED_FEATURES)
+    {
+        close(fd);
+        return -1;
+    }
+    ring->fd = fd;
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        io_ring_free(ring);
+        return -1;
+    }
+
+    uint8_t *sq = (uint8_t *)ring->sq_ring;
+    uint8_t *cq = (uint8_t *)ring->cq_ring;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = cq + params.cq_off.cqes;
+    return 0;
+}
+
+// Zrusenie kruhu a jeho mapovani
+void io_ring_free(io_ring_t *ring)
+{
+    if (ring->sq_ring != NULL && ring->sq_ring != MAP_FAILED)
+    {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->cq_ring != NULL && ring->cq_ring != MAP_FAILED)
+    {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sqes != NULL && ring->sqes != MAP_FAILED)
+    {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// Registracia bufferov - jadro si stranky pripne raz, poziadavky READ_FIXED a WRITE_FIXED
+// potom nemusia pri kazdom volani mapovat a pripinat stranky pouzivatelskeho buffera
+int io_ring_register_buffers(io_ring_t *ring, uint8_t *const *buffers, unsigned count, size_t size)
+{
+    struct iovec *iov = calloc(count, sizeof(struct iovec));
+    if (iov == NULL)
+    {
+        return -1;
+    }
+    for (unsigned i = 0; i < count; i++)
+    {
+        iov[i].iov_base = buffers[i];
+        iov[i].iov_len = size;
+    }
+    int result = (int)syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iov, count);
+    free(iov);
+    return (result == 0) ? 0 : -1;
+}
+
+// Dalsia volna poziadavka vo fronte, NULL ak je fronta plna
+static struct io_uring_sqe *io_ring_get_sqe(io_ring_t *ring)
+{
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring->sq_tail + ring->queued;
+    if (tail - head > *ring->sq_mask)
+    {
+        return NULL;
+    }
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &((struct io_uring_sqe *)ring->sqes)[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->queued++;
+    return sqe;
+}
+
+// Pripojenie casoveho limitu k poslednej pripravenej poziadavke
+// Ak poziadavka nestihne skoncit, jadro ju zrusi a dokonci sa s -ECANCELED
+static int io_ring_link_timeout(io_ring_t *ring, struct io_uring_sqe *sqe, int timeout_ms)
+{
+    if (timeout_ms <= 0)
+    {
+        return 0;
+    }
+    struct io_uring_sqe *timeout = io_ring_get_sqe(ring);
+    if (timeout == NULL)
+    {
+        return -1;
+    }
+    sqe->flags |= IOSQE_IO_LINK;
+    ring->timeout[0] = timeout_ms / 1000;
+    ring->timeout[1] = (int64_t)(timeout_ms % 1000) * 1000000;
+    timeout->opcode = IORING_OP_LINK_TIMEOUT;
+    timeout->fd = -1;
+    timeout->addr = (uint64_t)(uintptr_t)ring->timeout;
+    timeout->len = 1;
+    timeout->user_data = IO_RING_TIMEOUT_DATA;
+    return 0;
+}
+
+// Odovzdanie pripravenych poziadaviek a cakanie na wait_nr dokonceni
+static int io_ring_enter(io_ring_t *ring, unsigned wait_nr)
+{
+    // Jadro musi vidiet obsah poziadaviek skor nez novy koniec fronty
+    unsigned submit = ring->queued;
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + submit, __ATOMIC_RELEASE);
+    ring->queued = 0;
+    ring->in_flight += submit;
+
+    for (;;)
+    {
+        int result = (int)syscall(__NR_io_uring_enter, ring->fd, submit, wait_nr,
+                                  (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (result >= 0)
+        {
+            return 0;
+        }
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+        // Prerusenie pred odovzdanim - skusi znova
+    }
+}
+
+int io_ring_submit(io_ring_t *ring)
+{
+    return io_ring_enter(ring, 0);
+}
+
+// Prevzatie dalsieho dokoncenia (aj dokoncenia casoveho limitu), pocka ak ziadne nie je
+static int io_ring_next_completion(io_ring_t *ring, uint64_t *user_data, int *result)
+{
+    for (;;)
+    {
+        unsigned head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            struct io_uring_cqe *cqe = &((struct io_uring_cqe *)ring->cqes)[head & *ring->cq_mask];
+            *user_data = cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            ring->in_flight--;
+            return 0;
+        }
+        if (ring->in_flight == 0 || io_ring_enter(ring, 1) != 0)
+        {
+            return -1;
+        }
+    }
+}
+
+// Prevzatie dalsieho dokoncenia poziadavky (dokoncenia casovych limitov sa preskocia)
+int io_ring_wait(io_ring_t *ring, uint64_t *user_data, ssize_t *result)
+{
+    uint64_t data;
+    int res;
+    do
+    {
+        if (io_ring_next_completion(ring, &data, &res) != 0)
+        {
+            return -1;
+        }
+    } while (data == IO_RING_TIMEOUT_DATA);
+    *user_data = data;
+    *result = res;
+    return 0;
+}
+
+// Odovzdanie jednej pripravenej poziadavky (s pripadnym casovym limitom) a cakanie na jej vysledok
+// Zrusenie poziadavky po uplynuti limitu sa ohlasi ako ETIMEDOUT
+static ssize_t io_ring_complete(io_ring_t *ring, struct io_uring_sqe *sqe, int timeout_ms)
+{
+    sqe->user_data = 0;
+    if (io_ring_link_timeout(ring, sqe, timeout_ms) != 0 || io_ring_enter(ring, 1) != 0)
+    {
+        return -1;
+    }
+
+    uint64_t data;
+    ssize_t result;
+    if (io_ring_wait(ring, &data, &result) != 0)
+    {
+        return -1;
+    }
+    // Dokoncenie casoveho limitu sa prevezme hned, aby kruh ostal prazdny pre dalsiu poziadavku
+    int ignored;
+    while (ring->in_flight > 0 && io_ring_next_completion(ring, &data, &ignored) == 0)
+    {
+    }
+    if (result < 0)
+    {
+        errno = (result == -ECANCELED) ? ETIMEDOUT : (int)-result;
+        return -1;
+    }
+    return result;
+}
+
+// Citanie alebo zapis od aktualnej polohy v subore
+// S buffer_index >= 0 sa pouzije registrovany buffer (buf musi lezat v nom)
+static ssize_t io_ring_rw(io_ring_t *ring, uint8_t opcode, uint8_t fixed_opcode,
+                          int fd, const void *buf, size_t size, int buffer_index)
+{
+    struct io_uring_sqe *sqe = io_ring_get_sqe(ring);
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = (buffer_index >= 0) ? fixed_opcode : opcode;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)-1;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)size;
+    sqe->buf_index = (buffer_index >= 0) ? (uint16_t)buffer_index : 0;
+    return io_ring_complete(ring, sqe, 0);
+}
+
+ssize_t io_ring_read(io_ring_t *ring, int fd, void *buf, size_t size, int buffer_index)
+{
+    return io_ring_rw(ring, IORING_OP_READ, IORING_OP_READ_FIXED, fd, buf, size, buffer_index);
+}
+
+// Priprava odoslania na pozadi - IOSQE_IO_DRAIN zaruci, ze zacne az po dokonceni
+// vsetkych skor odovzdanych poziadaviek (data na sockete sa nepremiesaju),
+// MSG_WAITALL, ze sa odosle cela sprava alebo sa ohlasi chyba
+int io_ring_queue_sendmsg(io_ring_t *ring, int socket, const void *msg, uint64_t user_data, int timeout_ms)
+{
+    struct io_uring_sqe *sqe = io_ring_get_sqe(ring);
+    if (sqe == NULL)
+    {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->flags = IOSQE_IO_DRAIN;
+    sqe->fd = socket;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+    return io_ring_link_timeout(ring, sqe, timeout_ms);
+}
+
+#else
+
+// Bez io_uring sa kruh nevytvori, ostatne funkcie sa preto nikdy nezavolaju
+int io_ring_init(io_ring_t *ring, unsigned entries)
+{
+    (void)entries;
+    ring->fd = -1;
+    return -1;
+}
+
+void io_ring_free(io_ring_t *ring)
+{
+    ring->fd = -1;
+}
+
+int io_ring_register_buffers(io_ring_t *ring, uint8_t *const *buffers, unsigned count, size_t size)
+{
+    (void)ring, (void)buffers, (void)count, (void)size;
+    return -1;
+}
+
+ssize_t io_ring_read(io_ring_t *ring, int fd, void *buf, size_t size, int buffer_index)
+{
+    (void)ring, (void)fd, (void)buf, (void)size, (void)buffer_index;
+    return -1;
+}
+
+int io_ring_queue_sendmsg(io_ring_t *ring, int socket, const void *msg, uint64_t user_data, int timeout_ms)
+{
+    (void)ring, (void)socket, (void)msg, (void)user_data, (void)timeout_ms;
+    return -1;
+}
+
+int io_ring_submit(io_ring_t *ring)
+{
+    (void)ring;
+    return -1;
+}
+
+int io_ring_wait(io_ring_t *ring, uint64_t *user_data, ssize_t *result)
+{
+    (void)ring, (void)user_data, (void)result;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Program:    Volitelny I/O engine io_uring pre zabezpeceny prenos suborov
+ * Subor:      io_ring.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre I/O engine nad io_uring (Linux):
+ *     - Vyber enginu za behu (blokujuce volania alebo io_uring)
+ *     - Kruh poziadaviek zdielany s jadrom, priamo cez systemove volania (bez liburing)
+ *     - Registrovane buffery pre citanie suborov bez mapovania stranok pri kazdom volani
+ *     - Odosielanie zo socketu na pozadi s casovym limitom
+ *
+ * Zavislosti:
+ *     - Standardne C kniznice
+ *     - linux/io_uring.h (inak io_ring_init() vrati -1 a pouziju sa blokujuce volania)
+ ******************************************************************************/
+
+#ifndef IO_RING_H
+#define IO_RING_H
+
+#include <stddef.h>    // Kniznica pre typ size_t
+#include <stdint.h>    // Kniznica pre datove typy (uint8_t, uint32_t)
+#include <sys/types.h> // Kniznica pre typ ssize_t
+
+// io_uring je iba na Linuxe - inde sa kruh nevytvori a pouziju sa blokujuce volania
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_RING_SUPPORTED 1
+#endif
+#endif
+
+#define IO_ENGINE_BLOCKING 0 // Blokujuce send/recv a fread/fwrite (predvolene)
+#define IO_ENGINE_URING 1    // io_uring, ak ho jadro podporuje
+
+// Kruh io_uring - fronta poziadaviek (SQ) a fronta dokonceni (CQ) zdielane s jadrom
+// Jeden kruh smie pouzivat iba jedno vlakno
+typedef struct
+{
+    int fd; // Deskriptor kruhu, -1 ak kruh nie je vytvoreny
+#ifdef IO_RING_SUPPORTED
+    void *sq_ring;       // Namapovana fronta poziadaviek
+    size_t sq_ring_size;
+    void *cq_ring;       // Namapovana fronta dokonceni
+    size_t cq_ring_size;
+    void *sqes;          // Namapovane poziadavky
+    size_t sqes_size;
+    unsigned *sq_head;   // Prva poziadavka, ktoru jadro este neprevzalo
+    unsigned *sq_tail;   // Za poslednou pripravenou poziadavkou
+    unsigned *sq_mask;
+    unsigned *sq_array;  // Poradie poziadaviek vo fronte
+    unsigned *cq_head;   // Prve nespracovane dokoncenie
+    unsigned *cq_tail;   // Za poslednym dokoncenim
+    unsigned *cq_mask;
+    void *cqes;          // Dokoncenia
+    unsigned queued;     // Pripravene, este neodovzdane poziadavky
+    unsigned in_flight;  // Odovzdane poziadavky, ktorych dokoncenie este nebolo prevzate
+    int64_t timeout[2];  // Casovy limit poslednej poziadavky (__kernel_timespec)
+#endif
+} io_ring_t;
+
+int io_engine_select(int argc, char *argv[]); // Engine z prepinaca alebo premennej prostredia, -1 ak je neznamy
+
+int io_ring_init(io_ring_t *ring, unsigned entries); // Vytvori kruh, -1 ak io_uring nie je dostupny
+void io_ring_free(io_ring_t *ring);                  // Zrusi kruh (poziadavky nesmu byt rozpracovane)
+int io_ring_register_buffers(io_ring_t *ring,        // Zaregistruje rovnako velke buffery (index = poradie)
+                             uint8_t *const *buffers, unsigned count, size_t size);
+
+// Citanie so synchronnym cakanim - jedno volanie io_uring_enter odovzda poziadavku a pocka na nu
+// Navratova hodnota: pocet precitanych bajtov, -1 pri chybe
+ssize_t io_ring_read(io_ring_t *ring, int fd, void *buf, size_t size, int buffer_index);
+
+// Odosielanie na pozadi - poziadavka zacne az po dokonceni vsetkych predchadzajucich,
+// takze data na sockete ostanu v poradi; msg je struct msghdr a musi platit az do dokoncenia
+int io_ring_queue_sendmsg(io_ring_t *ring, int socket, const void *msg, uint64_t user_data, int timeout_ms);
+int io_ring_submit(io_ring_t *ring);                                     // Odovzda pripravene poziadavky jadru
+int io_ring_wait(io_ring_t *ring, uint64_t *user_data, ssize_t *result); // Pocka na dalsie dokoncenie
+
+#endif // IO_RING_H
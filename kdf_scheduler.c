@@ -0,0 +1,187 @@
+/********************************************************************************
+ * Program:    Planovac odvodenia klucov pre zabezpeceny prenos suborov
+ * Subor:      kdf_scheduler.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia planovaca odvodenia klucov:
+ *     - Skupina vlakien ma tolko vlakien, kolko je pracovnych pamati, takze
+ *       kazde spustene odvodenie ma volnu pamat a ostatne cakaju vo fronte skupiny
+ *     - Pracovne pamate su namapovane s vopred pridelenymi (velkymi) strankami,
+ *       Monocypher ich po kazdom odvodeni vymaze
+ *     - Pri ukonceni sa cakajuce odvodenia nevykonaju, iba sa oznamia ako zlyhane
+ *
+ * Zavislosti:
+ *     - kdf_scheduler.h (deklaracie funkcii)
+ *     - crypto_utils.h (Argon2, mazanie PSK)
+ *     - errors.h (chybove spravy)
+ *******************************************************************************/
+
+#include <stdio.h>  // Kniznica pre vypis chyb
+#include <string.h> // Kniznica pre pracu s pamatou a retazcami
+
+#include "kdf_scheduler.h" // Deklaracie funkcii
+#include "crypto_utils.h"  // Pre Argon2, PSK z hesla a mazanie PSK
+#include "errors.h"        // Chybove spravy
+
+// Uloha vlakna skupiny: vypozicia si pracovnu pamat, odvodi kluc a vrati ju
+static void kdf_scheduler_task(void *arg)
+{
+    kdf_job_t *job = (kdf_job_t *)arg;
+    kdf_scheduler_t *scheduler = job->scheduler;
+
+    platform_mutex_lock(&scheduler->lock);
+    void *area = scheduler->free_areas[--scheduler->nb_free];
+    int stopping = scheduler->stopping;
+    job->wait_ms = platform_time_ms() - job->queued_at;
+    scheduler->stats.queued--;
+    scheduler->stats.running++;
+    if (!stopping)
+    {
+        scheduler->stats.total_wait_ms += job->wait_ms;
+        if (job->wait_ms > scheduler->stats.max_wait_ms)
+        {
+            scheduler->stats.max_wait_ms = job->wait_ms;
+        }
+    }
+    platform_mutex_unlock(&scheduler->lock);
+
+    if (stopping)
+    {
+        secure_wipe(job->psk, PSK_SIZE);
+        job->result = -1;
+    }
+    else
+    {
+        // PSK zo spolocneho hesla je tiez Argon2id - pocita sa v tej istej pracovnej pamati, nie v reaktore
+        job->result = 0;
+        if (job->password != NULL)
+        {
+            job->result = derive_client_psk(job->psk, job->client_id, job->password, job->psk_salt, area);
+        }
+        if (job->result == 0)
+        {
+            job->result = derive_key_server(job->psk, job->salt, job->key, job->salt_out, job->lanes, area);
+        }
+    }
+
+    platform_mutex_lock(&scheduler->lock);
+    scheduler->free_areas[scheduler->nb_free++] = area;
+    scheduler->stats.running--;
+    if (!stopping)
+    {
+        scheduler->stats.completed++;
+    }
+    platform_mutex_unlock(&scheduler->lock);
+
+    // Po zavolani done moze volajuci ulohu uvolnit
+    job->done(job);
+}
+
+// Spustenie planovaca: tolko pracovnych pamati, kolko dovoli rozpocet a pocet sucasnych odvodeni
+// Ak sa niektore pamate nepodari alokovat, planovac bezi s mensim poctom
+// Navratova hodnota: 0 pri uspechu, -1 ak nie je ani jedna pracovna pamat
+int kdf_scheduler_init(kdf_scheduler_t *scheduler, unsigned memory_mib, unsigned concurrency)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->queue_limit = KDF_QUEUE_LIMIT;
+    scheduler->pages = PLATFORM_PAGES_HUGE;
+
+    unsigned count = (unsigned)(((uint64_t)memory_mib << 20) / ARGON2_WORK_AREA_SIZE);
+    if (count > concurrency)
+    {
+        count = concurrency;
+    }
+    if (count > TASK_POOL_MAX_THREADS)
+    {
+        count = TASK_POOL_MAX_THREADS;
+    }
+    while (scheduler->nb_areas < count)
+    {
+        int pages;
+        void *area = platform_large_alloc(ARGON2_WORK_AREA_SIZE, &pages);
+        if (area == NULL)
+        {
+            break;
+        }
+        scheduler->pages = (pages < scheduler->pages) ? pages : scheduler->pages;
+        scheduler->areas[scheduler->nb_areas] = area;
+        scheduler->free_areas[scheduler->nb_areas] = area;
+        scheduler->nb_areas++;
+    }
+    scheduler->nb_free = scheduler->nb_areas;
+
+    if (scheduler->nb_areas == 0 || task_pool_init(&scheduler->pool, scheduler->nb_areas) != 0)
+    {
+        fprintf(stderr, ERR_KDF_SCHEDULER, memory_mib, (unsigned)(ARGON2_WORK_AREA_SIZE >> 20));
+        for (unsigned i = 0; i < scheduler->nb_areas; i++)
+        {
+            platform_large_free(scheduler->areas[i], ARGON2_WORK_AREA_SIZE);
+        }
+        return -1;
+    }
+
+    // Skupina moze mat menej vlakien, ako sa pozadovalo - kazde vlakno potrebuje jednu pamat
+    while (scheduler->nb_areas > scheduler->pool.nb_threads)
+    {
+        platform_large_free(scheduler->areas[--scheduler->nb_areas], ARGON2_WORK_AREA_SIZE);
+    }
+    scheduler->nb_free = scheduler->nb_areas;
+    platform_mutex_init(&scheduler->lock);
+    return 0;
+}
+
+// Zaradenie odvodenia - done sa zavola vo vlakne planovaca (aj ked planovac medzitym skonci)
+// Navratova hodnota: kolko odvodeni musi skoncit, kym sa toto spusti (0 = hned), -1 ak je fronta plna
+int kdf_scheduler_submit(kdf_scheduler_t *scheduler, kdf_job_t *job)
+{
+    platform_mutex_lock(&scheduler->lock);
+    if (scheduler->stopping || scheduler->stats.queued >= scheduler->queue_limit)
+    {
+        scheduler->stats.rejected++;
+        platform_mutex_unlock(&scheduler->lock);
+        return -1;
+    }
+    unsigned busy = scheduler->stats.queued + scheduler->stats.running;
+    int position = (busy >= scheduler->nb_areas) ? (int)(busy - scheduler->nb_areas + 1) : 0;
+    scheduler->stats.queued++;
+    if (scheduler->stats.queued > scheduler->stats.max_queued)
+    {
+        scheduler->stats.max_queued = scheduler->stats.queued;
+    }
+    platform_mutex_unlock(&scheduler->lock);
+
+    job->scheduler = scheduler;
+    job->queued_at = platform_time_ms();
+    job->wait_ms = 0;
+    job->task.fn = kdf_scheduler_task;
+    job->task.arg = job;
+    task_pool_submit(&scheduler->pool, &job->task);
+    return position;
+}
+
+// Kopia statistiky planovaca
+void kdf_scheduler_stats(kdf_scheduler_t *scheduler, kdf_stats_t *stats)
+{
+    platform_mutex_lock(&scheduler->lock);
+    *stats = scheduler->stats;
+    platform_mutex_unlock(&scheduler->lock);
+}
+
+// Ukoncenie planovaca: bezijuce odvodenia sa dokoncia, cakajuce sa oznamia ako zlyhane
+void kdf_scheduler_free(kdf_scheduler_t *scheduler)
+{
+    platform_mutex_lock(&scheduler->lock);
+    scheduler->stopping = 1;
+    platform_mutex_unlock(&scheduler->lock);
+
+    task_pool_free(&scheduler->pool);
+    for (unsigned i = 0; i < scheduler->nb_areas; i++)
+    {
+        platform_large_free(scheduler->areas[i], ARGON2_WORK_AREA_SIZE);
+    }
+    platform_mutex_destroy(&scheduler->lock);
+    memset(scheduler, 0, sizeof(*scheduler));
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Program:    Planovac odvodenia klucov pre zabezpeceny prenos suborov
+ * Subor:      kdf_scheduler.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre planovac odvodenia klucov (Argon2) na serveri:
+ *     - Pevny rozpocet pamate - pracovne pamate Argon2 sa namapuju raz pri spusteni
+ *       (velke stranky, pridelene vopred) a kazde odvodenie si jednu z nich vypozicia,
+ *       pocas behu sa nic nealokuje
+ *     - Najviac tolko sucasnych odvodeni, kolko je pracovnych pamati, ostatne cakaju vo fronte
+ *     - Plna fronta nove odvodenia odmietne (narazovy nalet klientov nevycerpa pamat)
+ *     - Statistika hlbky fronty a doby cakania
+ *
+ * Zavislosti:
+ *     - platform.h (synchronizacia, cas)
+ *     - task_pool.h (skupina vlakien)
+ *     - constants.h (konstanty programu)
+ ******************************************************************************/
+
+#ifndef KDF_SCHEDULER_H
+#define KDF_SCHEDULER_H
+
+#include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t, uint64_t)
+
+#include "platform.h"  // Pre synchronizaciu a cas
+#include "task_pool.h" // Pre skupinu vlakien
+#include "constants.h" // Definicie konstant pre program
+
+// Jedno odvodenie kluca - patri volajucemu a musi platit, kym sa nezavola done
+typedef struct kdf_job
+{
+    uint8_t *psk;                      // PSK klienta (po odvodeni sa vymaze)
+    const char *password;              // Spolocne heslo - ak nie je NULL, PSK sa z neho najprv odvodi
+    const uint8_t *client_id;          // Identifikator klienta pre PSK z hesla
+    const uint8_t *psk_salt;           // Sol pre PSK z hesla
+    const uint8_t *salt;               // Prijata sol
+    uint8_t *key;                      // Vystup: odvodeny kluc
+    uint8_t *salt_out;                 // Vystup: pouzita sol
+    uint32_t lanes;                    // Pocet liniek Argon2 dohodnuty s klientom
+    int result;                        // 0 pri uspechu, -1 pri chybe alebo zastaveni planovaca
+    uint64_t wait_ms;                  // Ako dlho odvodenie cakalo na pracovnu pamat
+    void (*done)(struct kdf_job *job); // Zavola vlakno planovaca po skonceni odvodenia
+    void *arg;                         // Argument pre done
+
+    // Interne polozky planovaca
+    struct kdf_scheduler *scheduler;
+    uint64_t queued_at; // Cas zaradenia do fronty
+    task_t task;
+} kdf_job_t;
+
+// Statistika planovaca
+typedef struct
+{
+    unsigned queued;        // Odvodenia cakajuce na pracovnu pamat
+    unsigned running;       // Prave bezijuce odvodenia
+    unsigned max_queued;    // Najhlbsia fronta od spustenia
+    uint64_t completed;     // Dokoncene odvodenia
+    uint64_t rejected;      // Odvodenia odmietnute pre plnu frontu
+    uint64_t total_wait_ms; // Sucet cakania vsetkych odvodeni
+    uint64_t max_wait_ms;   // Najdlhsie cakanie
+} kdf_stats_t;
+
+// Planovac - jedno vlakno skupiny na kazdu pracovnu pamat
+typedef struct kdf_scheduler
+{
+    task_pool_t pool;                          // Vlakna, ktore odvodzuju kluce
+    void *areas[TASK_POOL_MAX_THREADS];        // Pracovne pamate alokovane pri spusteni
+    unsigned nb_areas;                         // Pocet pracovnych pamati (= najviac sucasnych odvodeni)
+    int pages;                                 // Najhorsi druh stranok pracovnych pamati (PLATFORM_PAGES_*)
+    void *free_areas[TASK_POOL_MAX_THREADS];   // Volne pracovne pamate
+    unsigned nb_free;                          // Pocet volnych pracovnych pamati
+    unsigned queue_limit;                      // Najviac cakajucich odvodeni
+    int stopping;                              // 1 ak sa cakajuce odvodenia uz nevykonaju
+    kdf_stats_t stats;                         // Statistika (chrani ju lock)
+    platform_mutex_t lock;                     // Chrani volne pamate, stopping a statistiku
+} kdf_scheduler_t;
+
+int kdf_scheduler_init(kdf_scheduler_t *scheduler, unsigned memory_mib, // Alokuje pracovne pamate a spusti vlakna
+                       unsigned concurrency);
+int kdf_scheduler_submit(kdf_scheduler_t *scheduler, kdf_job_t *job);    // Zaradi odvodenie, vrati poradie vo fronte alebo -1
+void kdf_scheduler_stats(kdf_scheduler_t *scheduler, kdf_stats_t *stats); // Kopia aktualnej statistiky
+void kdf_scheduler_free(kdf_scheduler_t *scheduler);                     // Cakajuce odvodenia zrusi, bezijuce dokonci
+
+#endif // KDF_SCHEDULER_H
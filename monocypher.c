@@ -53,6 +53,16 @@
 
 #include "monocypher.h"
 
+// x86 SIMD kernels are compiled with per-function target attributes and
+// selected at run time, so the default build flags stay portable.
+// Define MONOCYPHER_NO_SIMD to build the scalar code only.
+#if !defined(MONOCYPHER_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+#define MONOCYPHER_X86_SIMD
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
 #ifdef MONOCYPHER_CPP_NAMESPACE
 namespace MONOCYPHER_CPP_NAMESPACE {
 #endif
@@ -199,6 +209,195 @@ static void chacha20_rounds(u32 out[16], const u32 in[16])
 	out[12] = t12;  out[13] = t13;  out[14] = t14;  out[15] = t15;
 }
 
+#ifdef MONOCYPHER_X86_SIMD
+// Eight blocks at once, one block per 32-bit lane.
+// Same output as eight successive calls to chacha20_rounds(),
+// then advances the 64-bit block counter in input[12..13] by 8.
+#define ROTL256(x, n) \
+	_mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define QUARTERROUND256(a, b, c, d)	\
+	a = _mm256_add_epi32(a, b);  d = _mm256_xor_si256(d, a); \
+	d = _mm256_shuffle_epi8(d, rot16); \
+	c = _mm256_add_epi32(c, d);  b = _mm256_xor_si256(b, c); \
+	b = ROTL256(b, 12);                                      \
+	a = _mm256_add_epi32(a, b);  d = _mm256_xor_si256(d, a); \
+	d = _mm256_shuffle_epi8(d, rot8);  \
+	c = _mm256_add_epi32(c, d);  b = _mm256_xor_si256(b, c); \
+	b = ROTL256(b, 7)
+
+TARGET("avx2")
+static void xor_store256(u8 *out, const u8 *in, __m256i v)
+{
+	if (in != 0) {
+		v = _mm256_xor_si256(v, _mm256_loadu_si256((const __m256i*)in));
+	}
+	_mm256_storeu_si256((__m256i*)out, v);
+}
+
+TARGET("avx2")
+static void chacha20_blocks_avx2(u8 *cipher_text, const u8 *plain_text,
+                                 u32 input[16])
+{
+	const __m256i rot16 = _mm256_setr_epi8(
+		2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+		2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m256i rot8  = _mm256_setr_epi8(
+		3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+		3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+
+	// Per lane counters, with carry into the high word
+	u64 ctr = input[12] | ((u64)input[13] << 32);
+	u32 ctr_lo[8], ctr_hi[8];
+	FOR (i, 0, 8) {
+		ctr_lo[i] = (u32) (ctr + i);
+		ctr_hi[i] = (u32)((ctr + i) >> 32);
+	}
+
+	__m256i s[16], x[16];
+	FOR (i, 0, 16) { s[i] = _mm256_set1_epi32((int)input[i]); }
+	s[12] = _mm256_loadu_si256((const __m256i*)ctr_lo);
+	s[13] = _mm256_loadu_si256((const __m256i*)ctr_hi);
+	FOR (i, 0, 16) { x[i] = s[i]; }
+
+	FOR (i, 0, 10) { // 20 rounds, 2 rounds per loop.
+		QUARTERROUND256(x[0], x[4], x[ 8], x[12]); // column 0
+		QUARTERROUND256(x[1], x[5], x[ 9], x[13]); // column 1
+		QUARTERROUND256(x[2], x[6], x[10], x[14]); // column 2
+		QUARTERROUND256(x[3], x[7], x[11], x[15]); // column 3
+		QUARTERROUND256(x[0], x[5], x[10], x[15]); // diagonal 0
+		QUARTERROUND256(x[1], x[6], x[11], x[12]); // diagonal 1
+		QUARTERROUND256(x[2], x[7], x[ 8], x[13]); // diagonal 2
+		QUARTERROUND256(x[3], x[4], x[ 9], x[14]); // diagonal 3
+	}
+	FOR (i, 0, 16) { x[i] = _mm256_add_epi32(x[i], s[i]); }
+
+	// Transpose 4x4 words within each 128-bit half.  Afterwards,
+	// t[4*g + k] holds words 4g..4g+3 of block k (low half)
+	// and of block k+4 (high half).
+	__m256i t[16];
+	FOR (g, 0, 4) {
+		__m256i a = _mm256_unpacklo_epi32(x[4*g + 0], x[4*g + 1]);
+		__m256i b = _mm256_unpackhi_epi32(x[4*g + 0], x[4*g + 1]);
+		__m256i c = _mm256_unpacklo_epi32(x[4*g + 2], x[4*g + 3]);
+		__m256i d = _mm256_unpackhi_epi32(x[4*g + 2], x[4*g + 3]);
+		t[4*g + 0] = _mm256_unpacklo_epi64(a, c);
+		t[4*g + 1] = _mm256_unpackhi_epi64(a, c);
+		t[4*g + 2] = _mm256_unpacklo_epi64(b, d);
+		t[4*g + 3] = _mm256_unpackhi_epi64(b, d);
+	}
+	FOR (k, 0, 4) {
+		u8       *out = cipher_text + k * 64;
+		const u8 *in  = plain_text == 0 ? 0 : plain_text + k * 64;
+		xor_store256(out      , in      ,
+		             _mm256_permute2x128_si256(t[k], t[4 + k], 0x20));
+		xor_store256(out +  32, in ? in +  32 : 0,
+		             _mm256_permute2x128_si256(t[8 + k], t[12 + k], 0x20));
+		xor_store256(out + 256, in ? in + 256 : 0,
+		             _mm256_permute2x128_si256(t[k], t[4 + k], 0x31));
+		xor_store256(out + 288, in ? in + 288 : 0,
+		             _mm256_permute2x128_si256(t[8 + k], t[12 + k], 0x31));
+	}
+
+	ctr += 8;
+	input[12] = (u32) ctr;
+	input[13] = (u32)(ctr >> 32);
+}
+
+// Sixteen blocks at once, for CPUs with AVX-512F.
+// Rotations use the native vprold instruction.
+#define QUARTERROUND512(a, b, c, d)	\
+	a = _mm512_add_epi32(a, b);  d = _mm512_xor_si512(d, a); \
+	d = _mm512_rol_epi32(d, 16);                             \
+	c = _mm512_add_epi32(c, d);  b = _mm512_xor_si512(b, c); \
+	b = _mm512_rol_epi32(b, 12);                             \
+	a = _mm512_add_epi32(a, b);  d = _mm512_xor_si512(d, a); \
+	d = _mm512_rol_epi32(d,  8);                             \
+	c = _mm512_add_epi32(c, d);  b = _mm512_xor_si512(b, c); \
+	b = _mm512_rol_epi32(b,  7)
+
+TARGET("avx512f")
+static void xor_store512(u8 *out, const u8 *in, __m512i v)
+{
+	if (in != 0) {
+		v = _mm512_xor_si512(v, _mm512_loadu_si512((const void*)in));
+	}
+	_mm512_storeu_si512((void*)out, v);
+}
+
+TARGET("avx512f")
+static void chacha20_blocks_avx512(u8 *cipher_text, const u8 *plain_text,
+                                   u32 input[16])
+{
+	u64 ctr = input[12] | ((u64)input[13] << 32);
+	u32 ctr_lo[16], ctr_hi[16];
+	FOR (i, 0, 16) {
+		ctr_lo[i] = (u32) (ctr + i);
+		ctr_hi[i] = (u32)((ctr + i) >> 32);
+	}
+
+	__m512i s[16], x[16];
+	FOR (i, 0, 16) { s[i] = _mm512_set1_epi32((int)input[i]); }
+	s[12] = _mm512_loadu_si512((const void*)ctr_lo);
+	s[13] = _mm512_loadu_si512((const void*)ctr_hi);
+	FOR (i, 0, 16) { x[i] = s[i]; }
+
+	FOR (i, 0, 10) { // 20 rounds, 2 rounds per loop.
+		QUARTERROUND512(x[0], x[4], x[ 8], x[12]); // column 0
+		QUARTERROUND512(x[1], x[5], x[ 9], x[13]); // column 1
+		QUARTERROUND512(x[2], x[6], x[10], x[14]); // column 2
+		QUARTERROUND512(x[3], x[7], x[11], x[15]); // column 3
+		QUARTERROUND512(x[0], x[5], x[10], x[15]); // diagonal 0
+		QUARTERROUND512(x[1], x[6], x[11], x[12]); // diagonal 1
+		QUARTERROUND512(x[2], x[7], x[ 8], x[13]); // diagonal 2
+		QUARTERROUND512(x[3], x[4], x[ 9], x[14]); // diagonal 3
+	}
+	FOR (i, 0, 16) { x[i] = _mm512_add_epi32(x[i], s[i]); }
+
+	// Transpose 4x4 words within each 128-bit lane.  Afterwards,
+	// t[4*g + k] holds words 4g..4g+3 of blocks k, k+4, k+8, k+12.
+	__m512i t[16];
+	FOR (g, 0, 4) {
+		__m512i a = _mm512_unpacklo_epi32(x[4*g + 0], x[4*g + 1]);
+		__m512i b = _mm512_unpackhi_epi32(x[4*g + 0], x[4*g + 1]);
+		__m512i c = _mm512_unpacklo_epi32(x[4*g + 2], x[4*g + 3]);
+		__m512i d = _mm512_unpackhi_epi32(x[4*g + 2], x[4*g + 3]);
+		t[4*g + 0] = _mm512_unpacklo_epi64(a, c);
+		t[4*g + 1] = _mm512_unpackhi_epi64(a, c);
+		t[4*g + 2] = _mm512_unpacklo_epi64(b, d);
+		t[4*g + 3] = _mm512_unpackhi_epi64(b, d);
+	}
+	// Then transpose the 128-bit lanes, to get whole blocks.
+	FOR (k, 0, 4) {
+		__m512i a = _mm512_shuffle_i32x4(t[k    ], t[4 + k ], 0x44);
+		__m512i b = _mm512_shuffle_i32x4(t[k    ], t[4 + k ], 0xee);
+		__m512i c = _mm512_shuffle_i32x4(t[8 + k], t[12 + k], 0x44);
+		__m512i d = _mm512_shuffle_i32x4(t[8 + k], t[12 + k], 0xee);
+		__m512i blocks[4];
+		blocks[0] = _mm512_shuffle_i32x4(a, c, 0x88); // block k
+		blocks[1] = _mm512_shuffle_i32x4(a, c, 0xdd); // block k + 4
+		blocks[2] = _mm512_shuffle_i32x4(b, d, 0x88); // block k + 8
+		blocks[3] = _mm512_shuffle_i32x4(b, d, 0xdd); // block k + 12
+		FOR (j, 0, 4) {
+			size_t offset = (k + j * 4) * 64;
+			xor_store512(cipher_text + offset,
+			             plain_text == 0 ? 0 : plain_text + offset,
+			             blocks[j]);
+		}
+	}
+
+	ctr += 16;
+	input[12] = (u32) ctr;
+	input[13] = (u32)(ctr >> 32);
+}
+#endif // MONOCYPHER_X86_SIMD
+
+// Multi-block kernels, bound by crypto_cpu_select().  A null kernel is
+// not available; the portable loop handles whatever they leave.
+typedef void chacha20_kernel(u8 *cipher_text, const u8 *plain_text,
+                             u32 input[16]);
+static chacha20_kernel *chacha20_x16 = 0; // 16 blocks per call
+static chacha20_kernel *chacha20_x8  = 0; //  8 blocks per call
+
 static const u8 *chacha20_constant = (const u8*)"expand 32-byte k"; // 16 bytes
 
 void crypto_chacha20_h(u8 out[32], const u8 key[32], const u8 in [16])
@@ -230,6 +429,27 @@ u64 crypto_chacha20_djb(u8 *cipher_text, const u8 *plain_text,
 	// Whole blocks
 	u32    pool[16];
 	size_t nb_blocks = text_size >> 6;
+	// Widest kernel first, narrower ones take the rest.
+	if (chacha20_x16 != 0) {
+		while (nb_blocks >= 16) {
+			chacha20_x16(cipher_text, plain_text, input);
+			cipher_text += 1024;
+			if (plain_text != 0) {
+				plain_text += 1024;
+			}
+			nb_blocks -= 16;
+		}
+	}
+	if (chacha20_x8 != 0) {
+		while (nb_blocks >= 8) {
+			chacha20_x8(cipher_text, plain_text, input);
+			cipher_text += 512;
+			if (plain_text != 0) {
+				plain_text += 512;
+			}
+			nb_blocks -= 8;
+		}
+	}
 	FOR (i, 0, nb_blocks) {
 		chacha20_rounds(pool, input);
 		if (plain_text != 0) {
@@ -300,6 +520,67 @@ u64 crypto_chacha20_x(u8 *cipher_text, const u8 *plain_text,
 /// Poly 1305 ///
 /////////////////
 
+#ifdef __SIZEOF_INT128__
+// 64-bit targets: radix 2^64, with 64x64->128 bit multiplies.
+// Two full limbs plus a few top bits, and 4 big multiplies per block
+// instead of the 20 small ones of the 32-bit code below.
+typedef unsigned __int128 u128;
+
+// h = (h + c) * r
+// preconditions:
+//   ctx->h <= 4_ffffffff_ffffffff_ffffffff_ffffffff
+//   ctx->r <=   0ffffffc_0ffffffc_0ffffffc_0fffffff
+//   end    <= 1
+// Postcondition:
+//   ctx->h <= 4_ffffffff_ffffffff_ffffffff_ffffffff
+static void poly_blocks(crypto_poly1305_ctx *ctx, const u8 *in,
+                        size_t nb_blocks, unsigned end)
+{
+	const u64 r0 = ctx->r[0] | ((u64)ctx->r[1] << 32);
+	const u64 r1 = ctx->r[2] | ((u64)ctx->r[3] << 32);
+	const u64 s1 = r1 + (r1 >> 2); // r1 is a multiple of 4: s1 == r1/4 * 5
+	u64 h0 = ctx->h[0] | ((u64)ctx->h[1] << 32);
+	u64 h1 = ctx->h[2] | ((u64)ctx->h[3] << 32);
+	u64 h2 = ctx->h[4];
+
+	FOR (i, 0, nb_blocks) {
+		// h + c
+		u128 t = (u128)h0 + load64_le(in);
+		h0 = (u64)t;
+		t  = (u128)h1 + load64_le(in + 8) + (u64)(t >> 64);
+		h1 = (u64)t;
+		h2 += (u64)(t >> 64) + end; // h2 <= 6
+		in += 16;
+
+		// (h + c) * r, without carry propagation
+		// 2^128 * r1 == 2^130 * r1/4 == 5 * r1/4 (mod 2^130 - 5)
+		const u128 d0 = (u128)h0 * r0 + (u128)h1 * s1;
+		const u128 d1 = (u128)h0 * r1 + (u128)h1 * r0 + (u128)(h2 * s1);
+		const u64  d2 = h2 * r0; // small: r0 < 2^60
+
+		// carry propagation
+		h0 = (u64)d0;
+		t  = d1 + (u64)(d0 >> 64);
+		h1 = (u64)t;
+		h2 = d2 + (u64)(t >> 64);
+
+		// partial reduction modulo 2^130 - 5:
+		// everything above 2^130 is multiplied by 5 and added back.
+		const u64 c = (h2 >> 2) + (h2 & ~(u64)3); // (h2 >> 2) * 5
+		h2 &= 3;
+		t  = (u128)h0 + c;
+		h0 = (u64)t;
+		t  = (u128)h1 + (u64)(t >> 64);
+		h1 = (u64)t;
+		h2 += (u64)(t >> 64); // h2 <= 4
+	}
+	ctx->h[0] = (u32) h0;
+	ctx->h[1] = (u32)(h0 >> 32);
+	ctx->h[2] = (u32) h1;
+	ctx->h[3] = (u32)(h1 >> 32);
+	ctx->h[4] = (u32) h2;
+}
+#else
 // h = (h + c) * r
 // preconditions:
 //   ctx->h <= 4_ffffffff_ffffffff_ffffffff_ffffffff
@@ -363,6 +644,221 @@ static void poly_blocks(crypto_poly1305_ctx *ctx, const u8 *in,
 	ctx->h[4] = h4;
 }
 
+#endif // __SIZEOF_INT128__
+
+#ifdef MONOCYPHER_X86_SIMD
+// Vectorised Poly1305 works in radix 2^26: five 26-bit limbs per number,
+// so that limb products fit the 32x32->64 bit vector multiplies.
+#define POLY_MASK26 0x3ffffff
+
+// 130-bit number in 32-bit words -> 26-bit limbs.
+static void poly26_load(u64 out[5], const u32 in[5])
+{
+	out[0] =   in[0]                       & POLY_MASK26;
+	out[1] = ((in[0] >> 26) | (in[1] <<  6)) & POLY_MASK26;
+	out[2] = ((in[1] >> 20) | (in[2] << 12)) & POLY_MASK26;
+	out[3] = ((in[2] >> 14) | (in[3] << 18)) & POLY_MASK26;
+	out[4] =  (in[3] >>  8) | ((u64)in[4] << 24);
+}
+
+// 26-bit limbs (possibly a bit over) -> 130-bit number in 32-bit words.
+static void poly26_store(u32 out[5], const u64 in[5])
+{
+	u64 c;
+	c =      in[0] + (in[1] << 26);  out[0] = (u32)c;  c >>= 32;
+	c +=     in[2] << 20;            out[1] = (u32)c;  c >>= 32;
+	c +=     in[3] << 14;            out[2] = (u32)c;  c >>= 32;
+	c +=     in[4] <<  8;            out[3] = (u32)c;  c >>= 32;
+	out[4] = (u32)c;
+}
+
+// Partial reduction modulo 2^130 - 5 after a multiplication.
+static void poly26_carry(u64 d[5])
+{
+	d[1] += d[0] >> 26;  d[0] &= POLY_MASK26;
+	d[2] += d[1] >> 26;  d[1] &= POLY_MASK26;
+	d[3] += d[2] >> 26;  d[2] &= POLY_MASK26;
+	d[4] += d[3] >> 26;  d[3] &= POLY_MASK26;
+	d[0] += (d[4] >> 26) * 5;  d[4] &= POLY_MASK26;
+	d[1] += d[0] >> 26;  d[0] &= POLY_MASK26;
+}
+
+// out = a * b, modulo 2^130 - 5 (partially reduced)
+static void poly26_mul(u64 out[5], const u64 a[5], const u64 b[5])
+{
+	const u64 s1 = b[1] * 5;
+	const u64 s2 = b[2] * 5;
+	const u64 s3 = b[3] * 5;
+	const u64 s4 = b[4] * 5;
+	u64 d[5];
+	d[0] = a[0]*b[0] + a[1]*s4   + a[2]*s3   + a[3]*s2   + a[4]*s1;
+	d[1] = a[0]*b[1] + a[1]*b[0] + a[2]*s4   + a[3]*s3   + a[4]*s2;
+	d[2] = a[0]*b[2] + a[1]*b[1] + a[2]*b[0] + a[3]*s4   + a[4]*s3;
+	d[3] = a[0]*b[3] + a[1]*b[2] + a[2]*b[1] + a[3]*b[0] + a[4]*s4;
+	d[4] = a[0]*b[4] + a[1]*b[3] + a[2]*b[2] + a[3]*b[1] + a[4]*b[0];
+	poly26_carry(d);
+	COPY(out, d, 5);
+}
+
+// Loads 4 blocks (64 bytes) as 26-bit limbs, one block per 64-bit lane.
+TARGET("avx2")
+static void poly_load4_avx2(__m256i m[5], const u8 *in)
+{
+	const __m256i mask  = _mm256_set1_epi64x(POLY_MASK26);
+	const __m256i hibit = _mm256_set1_epi64x(1 << 24); // 2^128
+	__m256i a  = _mm256_loadu_si256((const __m256i*) in      );
+	__m256i b  = _mm256_loadu_si256((const __m256i*)(in + 32));
+	__m256i lo = _mm256_unpacklo_epi64(a, b);
+	__m256i hi = _mm256_unpackhi_epi64(a, b);
+	lo = _mm256_permute4x64_epi64(lo, _MM_SHUFFLE(3, 1, 2, 0));
+	hi = _mm256_permute4x64_epi64(hi, _MM_SHUFFLE(3, 1, 2, 0));
+	m[0] = _mm256_and_si256(lo, mask);
+	m[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask);
+	m[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+	                                        _mm256_slli_epi64(hi, 12)), mask);
+	m[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask);
+	m[4] = _mm256_or_si256 (_mm256_srli_epi64(hi, 40), hibit);
+}
+
+// h = h * r (lane by lane), partially reduced.
+// s holds 5*r, for the limbs that wrap around 2^130.
+TARGET("avx2")
+static void poly_mul_avx2(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+	const __m256i mask = _mm256_set1_epi64x(POLY_MASK26);
+#define MUL(a, b) _mm256_mul_epu32(a, b)
+#define ADD(a, b) _mm256_add_epi64(a, b)
+	__m256i d0 = ADD(ADD(ADD(ADD(MUL(h[0], r[0]), MUL(h[1], s[4])),
+	                         MUL(h[2], s[3])), MUL(h[3], s[2])), MUL(h[4], s[1]));
+	__m256i d1 = ADD(ADD(ADD(ADD(MUL(h[0], r[1]), MUL(h[1], r[0])),
+	                         MUL(h[2], s[4])), MUL(h[3], s[3])), MUL(h[4], s[2]));
+	__m256i d2 = ADD(ADD(ADD(ADD(MUL(h[0], r[2]), MUL(h[1], r[1])),
+	                         MUL(h[2], r[0])), MUL(h[3], s[4])), MUL(h[4], s[3]));
+	__m256i d3 = ADD(ADD(ADD(ADD(MUL(h[0], r[3]), MUL(h[1], r[2])),
+	                         MUL(h[2], r[1])), MUL(h[3], r[0])), MUL(h[4], s[4]));
+	__m256i d4 = ADD(ADD(ADD(ADD(MUL(h[0], r[4]), MUL(h[1], r[3])),
+	                         MUL(h[2], r[2])), MUL(h[3], r[1])), MUL(h[4], r[0]));
+	__m256i c;
+	c = _mm256_srli_epi64(d0, 26);  d0 = _mm256_and_si256(d0, mask);  d1 = ADD(d1, c);
+	c = _mm256_srli_epi64(d1, 26);  d1 = _mm256_and_si256(d1, mask);  d2 = ADD(d2, c);
+	c = _mm256_srli_epi64(d2, 26);  d2 = _mm256_and_si256(d2, mask);  d3 = ADD(d3, c);
+	c = _mm256_srli_epi64(d3, 26);  d3 = _mm256_and_si256(d3, mask);  d4 = ADD(d4, c);
+	c = _mm256_srli_epi64(d4, 26);  d4 = _mm256_and_si256(d4, mask);
+	d0 = ADD(d0, ADD(c, _mm256_slli_epi64(c, 2))); // c * 5
+	c = _mm256_srli_epi64(d0, 26);  d0 = _mm256_and_si256(d0, mask);  d1 = ADD(d1, c);
+#undef MUL
+#undef ADD
+	h[0] = d0;  h[1] = d1;  h[2] = d2;  h[3] = d3;  h[4] = d4;
+}
+
+// Four interleaved Horner evaluations, each stepping by r^4:
+//   lane i accumulates blocks i, i+4, i+8...
+// At the end lane i is multiplied by r^(4-i), and the lanes are summed.
+typedef struct {
+	__m256i h[5];      // the 4 accumulators
+	__m256i r[5];      // r^4 in every lane
+	__m256i s[5];      // 5 * r^4
+	u64     pow[4][5]; // r^1 .. r^4
+	int     started;   // 0 until the first 4 blocks are absorbed
+} poly_avx2_ctx;
+
+// Precomputes r^1 .. r^4.  The current hash goes in lane 0.
+TARGET("avx2")
+static void poly_avx2_init(poly_avx2_ctx *p, const crypto_poly1305_ctx *ctx)
+{
+	u32 r_words[5] = { ctx->r[0], ctx->r[1], ctx->r[2], ctx->r[3], 0 };
+	poly26_load(p->pow[0], r_words);
+	poly26_mul (p->pow[1], p->pow[0], p->pow[0]);
+	poly26_mul (p->pow[2], p->pow[1], p->pow[0]);
+	poly26_mul (p->pow[3], p->pow[1], p->pow[1]);
+	u64 h26[5];
+	poly26_load(h26, ctx->h);
+	FOR (i, 0, 5) {
+		p->r[i] = _mm256_set1_epi64x((long long)p->pow[3][i]);
+		p->s[i] = _mm256_set1_epi64x((long long)p->pow[3][i] * 5);
+		p->h[i] = _mm256_setr_epi64x((long long)h26[i], 0, 0, 0);
+	}
+	p->started = 0;
+	WIPE_BUFFER(h26);
+}
+
+// Absorbs whole blocks.  nb_blocks must be a multiple of 4.
+TARGET("avx2")
+static void poly_avx2_update(poly_avx2_ctx *p, const u8 *in, size_t nb_blocks)
+{
+	if (nb_blocks == 0) {
+		return;
+	}
+	__m256i h[5], r[5], s[5], m[5];
+	FOR (i, 0, 5) {
+		h[i] = p->h[i];
+		r[i] = p->r[i];
+		s[i] = p->s[i];
+	}
+	// The first 4 blocks are added without multiplying
+	if (!p->started) {
+		poly_load4_avx2(m, in);
+		FOR (i, 0, 5) { h[i] = _mm256_add_epi64(h[i], m[i]); }
+		p->started = 1;
+		in        += 64;
+		nb_blocks -= 4;
+	}
+	while (nb_blocks > 0) {
+		poly_mul_avx2(h, r, s);
+		poly_load4_avx2(m, in);
+		FOR (i, 0, 5) { h[i] = _mm256_add_epi64(h[i], m[i]); }
+		in        += 64;
+		nb_blocks -= 4;
+	}
+	FOR (i, 0, 5) { p->h[i] = h[i]; }
+}
+
+// Last step: lane i times r^(4-i), then the lanes are summed into ctx.
+// Same result as poly_blocks(ctx, in, nb_blocks, 1) over all the blocks.
+TARGET("avx2")
+static void poly_avx2_final(poly_avx2_ctx *p, crypto_poly1305_ctx *ctx)
+{
+	__m256i r[5], s[5];
+	FOR (i, 0, 5) {
+		r[i] = _mm256_setr_epi64x((long long)p->pow[3][i],
+		                          (long long)p->pow[2][i],
+		                          (long long)p->pow[1][i],
+		                          (long long)p->pow[0][i]);
+		s[i] = _mm256_add_epi64(_mm256_slli_epi64(r[i], 2), r[i]);
+	}
+	poly_mul_avx2(p->h, r, s);
+
+	// Sum the lanes
+	u64 h26[5];
+	FOR (i, 0, 5) {
+		u64 lanes[4];
+		_mm256_storeu_si256((__m256i*)lanes, p->h[i]);
+		h26[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+	poly26_carry(h26);
+	poly26_store(ctx->h, h26);
+
+	WIPE_BUFFER(h26);
+	crypto_wipe(p, sizeof(*p));
+}
+
+// nb_blocks must be a non-zero multiple of 4.
+TARGET("avx2")
+static void poly_blocks_avx2(crypto_poly1305_ctx *ctx, const u8 *in,
+                             size_t nb_blocks)
+{
+	poly_avx2_ctx p;
+	poly_avx2_init  (&p, ctx);
+	poly_avx2_update(&p, in, nb_blocks);
+	poly_avx2_final (&p, ctx);
+}
+#endif // MONOCYPHER_X86_SIMD
+
+// 4-way kernel, bound by crypto_cpu_select().  Null when not available.
+// nb_blocks must be a non-zero multiple of 4.
+static void (*poly_blocks_x4)(crypto_poly1305_ctx *ctx, const u8 *in,
+                              size_t nb_blocks) = 0;
+
 void crypto_poly1305_init(crypto_poly1305_ctx *ctx, const u8 key[32])
 {
 	ZERO(ctx->h, 5); // Initial hash is zero
@@ -399,6 +895,14 @@ void crypto_poly1305_update(crypto_poly1305_ctx *ctx,
 
 	// Process the message block by block
 	size_t nb_blocks = message_size >> 4;
+	// Precomputing r^2..r^4 only pays off on longer messages.
+	if (nb_blocks >= 16 && poly_blocks_x4 != 0) {
+		size_t nb_simd = nb_blocks & ~(size_t)3;
+		poly_blocks_x4(ctx, message, nb_simd);
+		message      += nb_simd << 4;
+		message_size -= nb_simd << 4;
+		nb_blocks    -= nb_simd;
+	}
 	poly_blocks(ctx, message, nb_blocks, 1);
 	message      += nb_blocks << 4;
 	message_size &= 15;
@@ -458,43 +962,181 @@ static const u64 iv[8] = {
 	0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
 };
 
-static void blake2b_compress(crypto_blake2b_ctx *ctx, int is_last_block)
+static const u8 sigma[12][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+};
+
+#ifdef MONOCYPHER_X86_SIMD
+// BLAKE2b compression with one row of the work vector per register
+// (AVX2), or per pair of registers (SSE4.1).  The diagonal step is done
+// by rotating rows 2, 3 and 4, then rotating them back.
+TARGET("avx2")
+static void blake2b_compress_avx2(u64 hash[8], const u64 input[16],
+                                  const u64 offset[2], int is_last_block)
 {
-	static const u8 sigma[12][16] = {
-		{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
-		{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
-		{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
-		{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
-		{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
-		{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
-		{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
-		{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
-		{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
-		{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
-		{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
-		{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
-	};
+	const __m256i rot24 = _mm256_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	const __m256i rot16 = _mm256_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const u64 *m = input;
+
+	__m256i a = _mm256_loadu_si256((const __m256i*) hash     );
+	__m256i b = _mm256_loadu_si256((const __m256i*)(hash + 4));
+	__m256i c = _mm256_loadu_si256((const __m256i*) iv       );
+	__m256i d = _mm256_loadu_si256((const __m256i*)(iv   + 4));
+	d = _mm256_xor_si256(d, _mm256_setr_epi64x(
+		(long long)offset[0], (long long)offset[1],
+		(long long)~(u64)(is_last_block - 1), 0));
+	const __m256i a0 = a;
+	const __m256i b0 = b;
+
+#define BLAKE2_G1_256(x)	\
+	a = _mm256_add_epi64(_mm256_add_epi64(a, x), b);              \
+	d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2, 3, 0, 1)); \
+	c = _mm256_add_epi64(c, d);                                   \
+	b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rot24)
+#define BLAKE2_G2_256(x)	\
+	a = _mm256_add_epi64(_mm256_add_epi64(a, x), b);              \
+	d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);       \
+	c = _mm256_add_epi64(c, d);                                   \
+	b = _mm256_xor_si256(b, c);                                   \
+	b = _mm256_xor_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b))
+#define BLAKE2_MSG_256(s, i, j, k, l)	\
+	_mm256_setr_epi64x((long long)m[s[i]], (long long)m[s[j]], \
+	                   (long long)m[s[k]], (long long)m[s[l]])
+
+#define BLAKE2_ROUND_256(i)	\
+	BLAKE2_G1_256(BLAKE2_MSG_256(sigma[i], 0, 2, 4, 6));      \
+	BLAKE2_G2_256(BLAKE2_MSG_256(sigma[i], 1, 3, 5, 7));      \
+	b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1)); \
+	c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+	d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3)); \
+	BLAKE2_G1_256(BLAKE2_MSG_256(sigma[i], 8, 10, 12, 14));   \
+	BLAKE2_G2_256(BLAKE2_MSG_256(sigma[i], 9, 11, 13, 15));   \
+	b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+	c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+	d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1))
+
+	// Unrolled, so the message schedule is resolved at compile time
+	BLAKE2_ROUND_256(0);  BLAKE2_ROUND_256(1);  BLAKE2_ROUND_256(2);
+	BLAKE2_ROUND_256(3);  BLAKE2_ROUND_256(4);  BLAKE2_ROUND_256(5);
+	BLAKE2_ROUND_256(6);  BLAKE2_ROUND_256(7);  BLAKE2_ROUND_256(8);
+	BLAKE2_ROUND_256(9);  BLAKE2_ROUND_256(10); BLAKE2_ROUND_256(11);
+
+	a = _mm256_xor_si256(a0, _mm256_xor_si256(a, c));
+	b = _mm256_xor_si256(b0, _mm256_xor_si256(b, d));
+	_mm256_storeu_si256((__m256i*) hash     , a);
+	_mm256_storeu_si256((__m256i*)(hash + 4), b);
+}
 
-	// increment input offset
-	u64   *x = ctx->input_offset;
-	size_t y = ctx->input_idx;
-	x[0] += y;
-	if (x[0] < y) {
-		x[1]++;
-	}
+TARGET("sse4.1")
+static void blake2b_compress_sse41(u64 hash[8], const u64 input[16],
+                                   const u64 offset[2], int is_last_block)
+{
+	const __m128i rot24 = _mm_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	const __m128i rot16 = _mm_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	const u64 *m = input;
+
+	// Rows are split in low (l) and high (h) halves
+	__m128i al = _mm_loadu_si128((const __m128i*)(hash + 0));
+	__m128i ah = _mm_loadu_si128((const __m128i*)(hash + 2));
+	__m128i bl = _mm_loadu_si128((const __m128i*)(hash + 4));
+	__m128i bh = _mm_loadu_si128((const __m128i*)(hash + 6));
+	__m128i cl = _mm_loadu_si128((const __m128i*)(iv   + 0));
+	__m128i ch = _mm_loadu_si128((const __m128i*)(iv   + 2));
+	__m128i dl = _mm_loadu_si128((const __m128i*)(iv   + 4));
+	__m128i dh = _mm_loadu_si128((const __m128i*)(iv   + 6));
+	dl = _mm_xor_si128(dl, _mm_set_epi64x((long long)offset[1],
+	                                      (long long)offset[0]));
+	dh = _mm_xor_si128(dh, _mm_set_epi64x(0,
+	                                      (long long)~(u64)(is_last_block - 1)));
+	const __m128i al0 = al, ah0 = ah, bl0 = bl, bh0 = bh;
+	__m128i t0, t1;
+
+#define ROTR63_128(x) _mm_xor_si128(_mm_srli_epi64(x, 63), _mm_add_epi64(x, x))
+#define BLAKE2_G1_128(xl, xh)	\
+	al = _mm_add_epi64(_mm_add_epi64(al, xl), bl);            \
+	ah = _mm_add_epi64(_mm_add_epi64(ah, xh), bh);            \
+	dl = _mm_shuffle_epi32(_mm_xor_si128(dl, al), _MM_SHUFFLE(2, 3, 0, 1)); \
+	dh = _mm_shuffle_epi32(_mm_xor_si128(dh, ah), _MM_SHUFFLE(2, 3, 0, 1)); \
+	cl = _mm_add_epi64(cl, dl);                               \
+	ch = _mm_add_epi64(ch, dh);                               \
+	bl = _mm_shuffle_epi8(_mm_xor_si128(bl, cl), rot24);      \
+	bh = _mm_shuffle_epi8(_mm_xor_si128(bh, ch), rot24)
+#define BLAKE2_G2_128(xl, xh)	\
+	al = _mm_add_epi64(_mm_add_epi64(al, xl), bl);            \
+	ah = _mm_add_epi64(_mm_add_epi64(ah, xh), bh);            \
+	dl = _mm_shuffle_epi8(_mm_xor_si128(dl, al), rot16);      \
+	dh = _mm_shuffle_epi8(_mm_xor_si128(dh, ah), rot16);      \
+	cl = _mm_add_epi64(cl, dl);                               \
+	ch = _mm_add_epi64(ch, dh);                               \
+	bl = ROTR63_128(_mm_xor_si128(bl, cl));                   \
+	bh = ROTR63_128(_mm_xor_si128(bh, ch))
+#define BLAKE2_MSG_128(s, i, j) \
+	_mm_set_epi64x((long long)m[s[j]], (long long)m[s[i]])
+
+#define BLAKE2_ROUND_128(i)	\
+	BLAKE2_G1_128(BLAKE2_MSG_128(sigma[i], 0, 2), BLAKE2_MSG_128(sigma[i], 4, 6));     \
+	BLAKE2_G2_128(BLAKE2_MSG_128(sigma[i], 1, 3), BLAKE2_MSG_128(sigma[i], 5, 7));     \
+	t0 = _mm_alignr_epi8(bh, bl, 8);  t1 = _mm_alignr_epi8(bl, bh, 8);             \
+	bl = t0;  bh = t1;                                                           \
+	t0 = cl;  cl = ch;  ch = t0;                                                 \
+	t0 = _mm_alignr_epi8(dh, dl, 8);  t1 = _mm_alignr_epi8(dl, dh, 8);             \
+	dl = t1;  dh = t0;                                                           \
+	BLAKE2_G1_128(BLAKE2_MSG_128(sigma[i], 8, 10), BLAKE2_MSG_128(sigma[i], 12, 14)); \
+	BLAKE2_G2_128(BLAKE2_MSG_128(sigma[i], 9, 11), BLAKE2_MSG_128(sigma[i], 13, 15)); \
+	t0 = _mm_alignr_epi8(bl, bh, 8);  t1 = _mm_alignr_epi8(bh, bl, 8);             \
+	bl = t0;  bh = t1;                                                           \
+	t0 = cl;  cl = ch;  ch = t0;                                                 \
+	t0 = _mm_alignr_epi8(dl, dh, 8);  t1 = _mm_alignr_epi8(dh, dl, 8);             \
+	dl = t1;  dh = t0
+
+	// Each round: columns, diagonalize, diagonals, undiagonalize
+	BLAKE2_ROUND_128(0);  BLAKE2_ROUND_128(1);  BLAKE2_ROUND_128(2);
+	BLAKE2_ROUND_128(3);  BLAKE2_ROUND_128(4);  BLAKE2_ROUND_128(5);
+	BLAKE2_ROUND_128(6);  BLAKE2_ROUND_128(7);  BLAKE2_ROUND_128(8);
+	BLAKE2_ROUND_128(9);  BLAKE2_ROUND_128(10); BLAKE2_ROUND_128(11);
+
+	_mm_storeu_si128((__m128i*)(hash + 0),
+	                 _mm_xor_si128(al0, _mm_xor_si128(al, cl)));
+	_mm_storeu_si128((__m128i*)(hash + 2),
+	                 _mm_xor_si128(ah0, _mm_xor_si128(ah, ch)));
+	_mm_storeu_si128((__m128i*)(hash + 4),
+	                 _mm_xor_si128(bl0, _mm_xor_si128(bl, dl)));
+	_mm_storeu_si128((__m128i*)(hash + 6),
+	                 _mm_xor_si128(bh0, _mm_xor_si128(bh, dh)));
+}
+#endif // MONOCYPHER_X86_SIMD
 
+static void blake2b_compress_portable(u64 hash[8], const u64 input[16],
+                                      const u64 offset[2], int is_last_block)
+{
 	// init work vector
-	u64 v0 = ctx->hash[0];  u64 v8  = iv[0];
-	u64 v1 = ctx->hash[1];  u64 v9  = iv[1];
-	u64 v2 = ctx->hash[2];  u64 v10 = iv[2];
-	u64 v3 = ctx->hash[3];  u64 v11 = iv[3];
-	u64 v4 = ctx->hash[4];  u64 v12 = iv[4] ^ ctx->input_offset[0];
-	u64 v5 = ctx->hash[5];  u64 v13 = iv[5] ^ ctx->input_offset[1];
-	u64 v6 = ctx->hash[6];  u64 v14 = iv[6] ^ (u64)~(is_last_block - 1);
-	u64 v7 = ctx->hash[7];  u64 v15 = iv[7];
+	u64 v0 = hash[0];  u64 v8  = iv[0];
+	u64 v1 = hash[1];  u64 v9  = iv[1];
+	u64 v2 = hash[2];  u64 v10 = iv[2];
+	u64 v3 = hash[3];  u64 v11 = iv[3];
+	u64 v4 = hash[4];  u64 v12 = iv[4] ^ offset[0];
+	u64 v5 = hash[5];  u64 v13 = iv[5] ^ offset[1];
+	u64 v6 = hash[6];  u64 v14 = iv[6] ^ (u64)~(is_last_block - 1);
+	u64 v7 = hash[7];  u64 v15 = iv[7];
 
 	// mangle work vector
-	u64 *input = ctx->input;
 #define BLAKE2_G(a, b, c, d, x, y)	\
 	a += b + x;  d = rotr64(d ^ a, 32); \
 	c += d;      b = rotr64(b ^ c, 24); \
@@ -521,10 +1163,28 @@ static void blake2b_compress(crypto_blake2b_ctx *ctx, int is_last_block)
 #endif
 
 	// update hash
-	ctx->hash[0] ^= v0 ^ v8;   ctx->hash[1] ^= v1 ^ v9;
-	ctx->hash[2] ^= v2 ^ v10;  ctx->hash[3] ^= v3 ^ v11;
-	ctx->hash[4] ^= v4 ^ v12;  ctx->hash[5] ^= v5 ^ v13;
-	ctx->hash[6] ^= v6 ^ v14;  ctx->hash[7] ^= v7 ^ v15;
+	hash[0] ^= v0 ^ v8;   hash[1] ^= v1 ^ v9;
+	hash[2] ^= v2 ^ v10;  hash[3] ^= v3 ^ v11;
+	hash[4] ^= v4 ^ v12;  hash[5] ^= v5 ^ v13;
+	hash[6] ^= v6 ^ v14;  hash[7] ^= v7 ^ v15;
+}
+
+// Compression kernel, bound by crypto_cpu_select().
+typedef void blake2b_kernel(u64 hash[8], const u64 input[16],
+                            const u64 offset[2], int is_last_block);
+static blake2b_kernel *blake2b_compress_kernel = blake2b_compress_portable;
+
+static void blake2b_compress(crypto_blake2b_ctx *ctx, int is_last_block)
+{
+	// increment input offset
+	u64   *x = ctx->input_offset;
+	size_t y = ctx->input_idx;
+	x[0] += y;
+	if (x[0] < y) {
+		x[1]++;
+	}
+	blake2b_compress_kernel(ctx->hash, ctx->input, ctx->input_offset,
+	                        is_last_block);
 }
 
 void crypto_blake2b_keyed_init(crypto_blake2b_ctx *ctx, size_t hash_size,
@@ -742,12 +1402,346 @@ static void g_rounds(blk *b)
 	}
 }
 
+#ifdef MONOCYPHER_X86_SIMD
+// Argon2 block filling with 4 words per AVX2 register, or 2 words per
+// SSE2 register.  Computes R = previous ^ reference, writes (or XORs) R
+// to current, then XORs G(R) into current.  tmp holds R while rounds
+// are computed; the caller wipes it.
+#define BLAMKA_256(a, b)	\
+	_mm256_add_epi64(_mm256_add_epi64(a, b), \
+	                 _mm256_slli_epi64(_mm256_mul_epu32(a, b), 1))
+#define ARGON2_G1_256(a, b, c, d)	\
+	a = BLAMKA_256(a, b);                                         \
+	d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2, 3, 0, 1)); \
+	c = BLAMKA_256(c, d);                                         \
+	b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rot24)
+#define ARGON2_G2_256(a, b, c, d)	\
+	a = BLAMKA_256(a, b);                                         \
+	d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);       \
+	c = BLAMKA_256(c, d);                                         \
+	b = _mm256_xor_si256(b, c);                                   \
+	b = _mm256_xor_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b))
+#define ARGON2_ROUND_256(a, b, c, d)	\
+	ARGON2_G1_256(a, b, c, d);                                \
+	ARGON2_G2_256(a, b, c, d);                                \
+	b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1)); \
+	c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+	d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3)); \
+	ARGON2_G1_256(a, b, c, d);                                \
+	ARGON2_G2_256(a, b, c, d);                                \
+	b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+	c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+	d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1))
+#define LOAD256(p)     _mm256_loadu_si256((const __m256i*)(p))
+#define STORE256(p, x) _mm256_storeu_si256((__m256i*)(p), x)
+
+TARGET("avx2")
+static void fill_block_avx2(blk *current, const blk *previous,
+                            const blk *reference, blk *tmp, int xor_current)
+{
+	const __m256i rot24 = _mm256_setr_epi8(
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+		3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+	const __m256i rot16 = _mm256_setr_epi8(
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+		2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+	u64 *t = tmp->a;
+	u64 *o = current->a;
+
+	for (int i = 0; i < 128; i += 4) {
+		__m256i r = _mm256_xor_si256(LOAD256(previous ->a + i),
+		                             LOAD256(reference->a + i));
+		STORE256(t + i, r);
+		if (xor_current) {
+			r = _mm256_xor_si256(r, LOAD256(o + i));
+		}
+		STORE256(o + i, r);
+	}
+
+	// column rounds, two at a time (16 consecutive words each)
+	for (int i = 0; i < 128; i += 32) {
+		__m256i a0 = LOAD256(t + i     ), a1 = LOAD256(t + i + 16);
+		__m256i b0 = LOAD256(t + i +  4), b1 = LOAD256(t + i + 20);
+		__m256i c0 = LOAD256(t + i +  8), c1 = LOAD256(t + i + 24);
+		__m256i d0 = LOAD256(t + i + 12), d1 = LOAD256(t + i + 28);
+		ARGON2_ROUND_256(a0, b0, c0, d0);
+		ARGON2_ROUND_256(a1, b1, c1, d1);
+		STORE256(t + i     , a0);  STORE256(t + i + 16, a1);
+		STORE256(t + i +  4, b0);  STORE256(t + i + 20, b1);
+		STORE256(t + i +  8, c0);  STORE256(t + i + 24, c1);
+		STORE256(t + i + 12, d0);  STORE256(t + i + 28, d1);
+	}
+
+	// row rounds, two at a time.  Register j of each row of the
+	// matrix holds words 4j..4j+3; the low halves belong to row round
+	// 2j, the high halves to row round 2j+1.  The result goes
+	// straight into current.
+	for (int j = 0; j < 16; j += 4) {
+		__m256i v0 = LOAD256(t + j     ), v1 = LOAD256(t + j + 16);
+		__m256i v2 = LOAD256(t + j + 32), v3 = LOAD256(t + j + 48);
+		__m256i v4 = LOAD256(t + j + 64), v5 = LOAD256(t + j + 80);
+		__m256i v6 = LOAD256(t + j + 96), v7 = LOAD256(t + j + 112);
+		__m256i a0 = _mm256_permute2x128_si256(v0, v1, 0x20);
+		__m256i a1 = _mm256_permute2x128_si256(v0, v1, 0x31);
+		__m256i b0 = _mm256_permute2x128_si256(v2, v3, 0x20);
+		__m256i b1 = _mm256_permute2x128_si256(v2, v3, 0x31);
+		__m256i c0 = _mm256_permute2x128_si256(v4, v5, 0x20);
+		__m256i c1 = _mm256_permute2x128_si256(v4, v5, 0x31);
+		__m256i d0 = _mm256_permute2x128_si256(v6, v7, 0x20);
+		__m256i d1 = _mm256_permute2x128_si256(v6, v7, 0x31);
+		ARGON2_ROUND_256(a0, b0, c0, d0);
+		ARGON2_ROUND_256(a1, b1, c1, d1);
+#define ARGON2_XOR_ROWS_256(x0, x1, offset)	\
+		STORE256(o + j + offset, _mm256_xor_si256(LOAD256(o + j + offset), \
+		         _mm256_permute2x128_si256(x0, x1, 0x20)));                 \
+		STORE256(o + j + offset + 16, _mm256_xor_si256(LOAD256(o + j + offset + 16), \
+		         _mm256_permute2x128_si256(x0, x1, 0x31)))
+		ARGON2_XOR_ROWS_256(a0, a1,  0);
+		ARGON2_XOR_ROWS_256(b0, b1, 32);
+		ARGON2_XOR_ROWS_256(c0, c1, 64);
+		ARGON2_XOR_ROWS_256(d0, d1, 96);
+	}
+}
+
+#define BLAMKA_128(a, b)	\
+	_mm_add_epi64(_mm_add_epi64(a, b), \
+	              _mm_slli_epi64(_mm_mul_epu32(a, b), 1))
+#define ROTR_128(x, n) \
+	_mm_or_si128(_mm_srli_epi64(x, n), _mm_slli_epi64(x, 64 - (n)))
+#define ARGON2_G1_128(al, ah, bl, bh, cl, ch, dl, dh)	\
+	al = BLAMKA_128(al, bl);  ah = BLAMKA_128(ah, bh);                    \
+	dl = _mm_shuffle_epi32(_mm_xor_si128(dl, al), _MM_SHUFFLE(2, 3, 0, 1)); \
+	dh = _mm_shuffle_epi32(_mm_xor_si128(dh, ah), _MM_SHUFFLE(2, 3, 0, 1)); \
+	cl = BLAMKA_128(cl, dl);  ch = BLAMKA_128(ch, dh);                    \
+	bl = ROTR_128(_mm_xor_si128(bl, cl), 24);                             \
+	bh = ROTR_128(_mm_xor_si128(bh, ch), 24)
+#define ARGON2_G2_128(al, ah, bl, bh, cl, ch, dl, dh)	\
+	al = BLAMKA_128(al, bl);  ah = BLAMKA_128(ah, bh);                    \
+	dl = ROTR_128(_mm_xor_si128(dl, al), 16);                             \
+	dh = ROTR_128(_mm_xor_si128(dh, ah), 16);                             \
+	cl = BLAMKA_128(cl, dl);  ch = BLAMKA_128(ch, dh);                    \
+	bl = _mm_xor_si128(bl, cl);                                           \
+	bh = _mm_xor_si128(bh, ch);                                           \
+	bl = _mm_xor_si128(_mm_srli_epi64(bl, 63), _mm_add_epi64(bl, bl));    \
+	bh = _mm_xor_si128(_mm_srli_epi64(bh, 63), _mm_add_epi64(bh, bh))
+// Rows are split in low and high halves.  SSE2 has no alignr, so rows
+// are rotated with unpacks.
+#define ARGON2_ROUND_128(al, ah, bl, bh, cl, ch, dl, dh)	\
+	ARGON2_G1_128(al, ah, bl, bh, cl, ch, dl, dh);                      \
+	ARGON2_G2_128(al, ah, bl, bh, cl, ch, dl, dh);                      \
+	t0 = bl;  t1 = dl;                                                  \
+	bl = _mm_unpackhi_epi64(bl, _mm_unpacklo_epi64(bh, bh));            \
+	bh = _mm_unpackhi_epi64(bh, _mm_unpacklo_epi64(t0, t0));            \
+	t0 = cl;  cl = ch;  ch = t0;                                        \
+	dl = _mm_unpackhi_epi64(dh, _mm_unpacklo_epi64(t1, t1));            \
+	dh = _mm_unpackhi_epi64(t1, _mm_unpacklo_epi64(dh, dh));            \
+	ARGON2_G1_128(al, ah, bl, bh, cl, ch, dl, dh);                      \
+	ARGON2_G2_128(al, ah, bl, bh, cl, ch, dl, dh);                      \
+	t0 = bl;  t1 = dl;                                                  \
+	bl = _mm_unpackhi_epi64(bh, _mm_unpacklo_epi64(t0, t0));            \
+	bh = _mm_unpackhi_epi64(t0, _mm_unpacklo_epi64(bh, bh));            \
+	t0 = cl;  cl = ch;  ch = t0;                                        \
+	dl = _mm_unpackhi_epi64(dl, _mm_unpacklo_epi64(dh, dh));            \
+	dh = _mm_unpackhi_epi64(dh, _mm_unpacklo_epi64(t1, t1))
+#define LOAD128(p)     _mm_loadu_si128((const __m128i*)(p))
+#define STORE128(p, x) _mm_storeu_si128((__m128i*)(p), x)
+
+TARGET("sse2")
+static void fill_block_sse2(blk *current, const blk *previous,
+                            const blk *reference, blk *tmp, int xor_current)
+{
+	u64 *t = tmp->a;
+	u64 *o = current->a;
+	__m128i t0, t1;
+
+	for (int i = 0; i < 128; i += 2) {
+		__m128i r = _mm_xor_si128(LOAD128(previous ->a + i),
+		                          LOAD128(reference->a + i));
+		STORE128(t + i, r);
+		if (xor_current) {
+			r = _mm_xor_si128(r, LOAD128(o + i));
+		}
+		STORE128(o + i, r);
+	}
+
+	// column rounds (16 consecutive words each)
+	for (int i = 0; i < 128; i += 16) {
+		__m128i al = LOAD128(t + i     ), ah = LOAD128(t + i +  2);
+		__m128i bl = LOAD128(t + i +  4), bh = LOAD128(t + i +  6);
+		__m128i cl = LOAD128(t + i +  8), ch = LOAD128(t + i + 10);
+		__m128i dl = LOAD128(t + i + 12), dh = LOAD128(t + i + 14);
+		ARGON2_ROUND_128(al, ah, bl, bh, cl, ch, dl, dh);
+		STORE128(t + i     , al);  STORE128(t + i +  2, ah);
+		STORE128(t + i +  4, bl);  STORE128(t + i +  6, bh);
+		STORE128(t + i +  8, cl);  STORE128(t + i + 10, ch);
+		STORE128(t + i + 12, dl);  STORE128(t + i + 14, dh);
+	}
+
+	// row rounds (words i, i+1, i+16, i+17...), XORed into current
+	for (int i = 0; i < 16; i += 2) {
+		__m128i al = LOAD128(t + i     ), ah = LOAD128(t + i +  16);
+		__m128i bl = LOAD128(t + i + 32), bh = LOAD128(t + i +  48);
+		__m128i cl = LOAD128(t + i + 64), ch = LOAD128(t + i +  80);
+		__m128i dl = LOAD128(t + i + 96), dh = LOAD128(t + i + 112);
+		ARGON2_ROUND_128(al, ah, bl, bh, cl, ch, dl, dh);
+		STORE128(o + i     , _mm_xor_si128(LOAD128(o + i     ), al));
+		STORE128(o + i +  16, _mm_xor_si128(LOAD128(o + i +  16), ah));
+		STORE128(o + i +  32, _mm_xor_si128(LOAD128(o + i +  32), bl));
+		STORE128(o + i +  48, _mm_xor_si128(LOAD128(o + i +  48), bh));
+		STORE128(o + i +  64, _mm_xor_si128(LOAD128(o + i +  64), cl));
+		STORE128(o + i +  80, _mm_xor_si128(LOAD128(o + i +  80), ch));
+		STORE128(o + i +  96, _mm_xor_si128(LOAD128(o + i +  96), dl));
+		STORE128(o + i + 112, _mm_xor_si128(LOAD128(o + i + 112), dh));
+	}
+}
+#endif // MONOCYPHER_X86_SIMD
+
+// Computes the new block from the previous and reference blocks.
+// After the first pass the result is XORed into current instead of
+// overwriting it.
+static void fill_block_portable(blk *current, const blk *previous,
+                                const blk *reference, blk *tmp,
+                                int xor_current)
+{
+	copy_block(tmp, previous);
+	xor_block (tmp, reference);
+	if (xor_current) { xor_block (current, tmp); }
+	else             { copy_block(current, tmp); }
+	g_rounds  (tmp);
+	xor_block (current, tmp);
+}
+
+// Block filling kernel, bound by crypto_cpu_select().
+typedef void fill_block_kernel(blk *current, const blk *previous,
+                               const blk *reference, blk *tmp,
+                               int xor_current);
+static fill_block_kernel *fill_block = fill_block_portable;
+
 const crypto_argon2_extras crypto_argon2_no_extras = { 0, 0, 0, 0 };
 
-void crypto_argon2(u8 *hash, u32 hash_size, void *work_area,
-                   crypto_argon2_config config,
-                   crypto_argon2_inputs inputs,
-                   crypto_argon2_extras extras)
+// State shared by all segments of the slice being filled.
+// Segments only read it, so they can be filled concurrently.
+typedef struct {
+	blk *blocks;
+	crypto_argon2_config config;
+	u32  segment_size;
+	u32  lane_size;
+	u32  nb_blocks;
+	u32  pass;
+	u32  slice;
+	u32  pass_offset;
+	int  constant_time;
+} argon2_slice;
+
+// Fills one segment of the current slice.
+// Only reads blocks from previous slices, or from its own segment.
+static void argon2_fill_segment(void *slice_state, u32 segment)
+{
+	const argon2_slice *s = (const argon2_slice*)slice_state;
+	crypto_argon2_config config = s->config;
+	blk *blocks        = s->blocks;
+	u32  segment_size  = s->segment_size;
+	u32  lane_size     = s->lane_size;
+	u32  nb_blocks     = s->nb_blocks;
+	u32  pass          = s->pass;
+	u32  slice         = s->slice;
+	u32  pass_offset   = s->pass_offset;
+	u32  slice_offset  = slice * segment_size;
+	int  constant_time = s->constant_time;
+
+	blk tmp;
+	blk index_block;
+	u32 index_ctr = 1;
+	FOR_T (u32, block, pass_offset, segment_size) {
+		// Current and previous blocks
+		u32  lane_offset   = segment * lane_size;
+		blk *segment_start = blocks + lane_offset + slice_offset;
+		blk *current       = segment_start + block;
+		blk *previous      =
+			block == 0 && slice_offset == 0
+			? segment_start + lane_size - 1
+			: segment_start + block - 1;
+
+		u64 index_seed;
+		if (constant_time) {
+			if (block == pass_offset || (block % 128) == 0) {
+				// Fill or refresh deterministic indices block
+
+				// seed the beginning of the block...
+				ZERO(index_block.a, 128);
+				index_block.a[0] = pass;
+				index_block.a[1] = segment;
+				index_block.a[2] = slice;
+				index_block.a[3] = nb_blocks;
+				index_block.a[4] = config.nb_passes;
+				index_block.a[5] = config.algorithm;
+				index_block.a[6] = index_ctr;
+				index_ctr++;
+
+				// ... then shuffle it
+				copy_block(&tmp, &index_block);
+				g_rounds  (&index_block);
+				xor_block (&index_block, &tmp);
+				copy_block(&tmp, &index_block);
+				g_rounds  (&index_block);
+				xor_block (&index_block, &tmp);
+			}
+			index_seed = index_block.a[block % 128];
+		} else {
+			index_seed = previous->a[0];
+		}
+
+		// Establish the reference set.  *Approximately* comprises:
+		// - The last 3 slices (if they exist yet)
+		// - The already constructed blocks in the current segment
+		u32 next_slice   = ((slice + 1) % 4) * segment_size;
+		u32 window_start = pass == 0 ? 0     : next_slice;
+		u32 nb_segments  = pass == 0 ? slice : 3;
+		u64 lane         =
+			pass == 0 && slice == 0
+			? segment
+			: (index_seed >> 32) % config.nb_lanes;
+		u32 window_size  =
+			nb_segments * segment_size +
+			(lane  == segment ? block-1 :
+			 block == 0       ? (u32)-1 : 0);
+
+		// Find reference block
+		u64  j1        = index_seed & 0xffffffff; // block selector
+		u64  x         = (j1 * j1)         >> 32;
+		u64  y         = (window_size * x) >> 32;
+		u64  z         = (window_size - 1) - y;
+		u64  ref       = (window_start + z) % lane_size;
+		u32  index     = lane * lane_size + (u32)ref;
+		blk *reference = blocks + index;
+
+		// Shuffle the previous & reference block
+		// into the current block
+		fill_block(current, previous, reference, &tmp, pass != 0);
+	}
+
+	// Wipe temporary block
+	volatile u64* p = tmp.a;
+	ZERO(p, 128);
+}
+
+// Fills the segments one after the other, in the calling thread.
+static void argon2_sequential(void *executor_ctx,
+                              void (*fill)(void *arg, u32 lane),
+                              void *arg, u32 nb_lanes)
+{
+	(void)executor_ctx;
+	FOR_T(u32, lane, 0, nb_lanes) {
+		fill(arg, lane);
+	}
+}
+
+void crypto_argon2_parallel(u8 *hash, u32 hash_size, void *work_area,
+                            crypto_argon2_config config,
+                            crypto_argon2_inputs inputs,
+                            crypto_argon2_extras extras,
+                            crypto_argon2_executor *executor,
+                            void *executor_ctx)
 {
 	const u32 segment_size = config.nb_blocks / config.nb_lanes / 4;
 	const u32 lane_size    = segment_size * 4;
@@ -787,117 +1781,46 @@ void crypto_argon2(u8 *hash, u32 hash_size, void *work_area,
 	}
 
 	// Argon2i and Argon2id start with constant time indexing
-	int constant_time = config.algorithm != CRYPTO_ARGON2_D;
+	argon2_slice s;
+	s.blocks        = blocks;
+	s.config        = config;
+	s.segment_size  = segment_size;
+	s.lane_size     = lane_size;
+	s.nb_blocks     = nb_blocks;
+	s.constant_time = config.algorithm != CRYPTO_ARGON2_D;
 
 	// Fill (and re-fill) the rest of the blocks
 	//
-	// Note: even though each segment within the same slice can be
-	// computed in parallel, (one thread per lane), we are computing
-	// them sequentially, because Monocypher doesn't support threads.
+	// Each segment within the same slice can be computed in parallel,
+	// (one thread per lane).  Monocypher doesn't support threads, so
+	// this is left to the executor.  Without one, segments are
+	// computed sequentially.
 	//
-	// Yet optimal performance (and therefore security) requires one
-	// thread per lane. The only reason Monocypher supports multiple
-	// lanes is compatibility.
-	blk tmp;
+	// Optimal performance (and therefore security) requires one
+	// thread per lane.
+	if (executor == 0) {
+		executor = argon2_sequential;
+	}
 	FOR_T(u32, pass, 0, config.nb_passes) {
 		FOR_T(u32, slice, 0, 4) {
 			// On the first slice of the first pass,
 			// blocks 0 and 1 are already filled, hence pass_offset.
-			u32 pass_offset  = pass == 0 && slice == 0 ? 2 : 0;
-			u32 slice_offset = slice * segment_size;
+			s.pass        = pass;
+			s.slice       = slice;
+			s.pass_offset = pass == 0 && slice == 0 ? 2 : 0;
 
 			// Argon2id switches back to non-constant time indexing
 			// after the first two slices of the first pass
 			if (slice == 2 && config.algorithm == CRYPTO_ARGON2_ID) {
-				constant_time = 0;
+				s.constant_time = 0;
 			}
 
-			// Each iteration of the following loop may be performed in
-			// a separate thread.  All segments must be fully completed
+			// All segments must be fully completed
 			// before we start filling the next slice.
-			FOR_T(u32, segment, 0, config.nb_lanes) {
-				blk index_block;
-				u32 index_ctr = 1;
-				FOR_T (u32, block, pass_offset, segment_size) {
-					// Current and previous blocks
-					u32  lane_offset   = segment * lane_size;
-					blk *segment_start = blocks + lane_offset + slice_offset;
-					blk *current       = segment_start + block;
-					blk *previous      =
-						block == 0 && slice_offset == 0
-						? segment_start + lane_size - 1
-						: segment_start + block - 1;
-
-					u64 index_seed;
-					if (constant_time) {
-						if (block == pass_offset || (block % 128) == 0) {
-							// Fill or refresh deterministic indices block
-
-							// seed the beginning of the block...
-							ZERO(index_block.a, 128);
-							index_block.a[0] = pass;
-							index_block.a[1] = segment;
-							index_block.a[2] = slice;
-							index_block.a[3] = nb_blocks;
-							index_block.a[4] = config.nb_passes;
-							index_block.a[5] = config.algorithm;
-							index_block.a[6] = index_ctr;
-							index_ctr++;
-
-							// ... then shuffle it
-							copy_block(&tmp, &index_block);
-							g_rounds  (&index_block);
-							xor_block (&index_block, &tmp);
-							copy_block(&tmp, &index_block);
-							g_rounds  (&index_block);
-							xor_block (&index_block, &tmp);
-						}
-						index_seed = index_block.a[block % 128];
-					} else {
-						index_seed = previous->a[0];
-					}
-
-					// Establish the reference set.  *Approximately* comprises:
-					// - The last 3 slices (if they exist yet)
-					// - The already constructed blocks in the current segment
-					u32 next_slice   = ((slice + 1) % 4) * segment_size;
-					u32 window_start = pass == 0 ? 0     : next_slice;
-					u32 nb_segments  = pass == 0 ? slice : 3;
-					u64 lane         =
-						pass == 0 && slice == 0
-						? segment
-						: (index_seed >> 32) % config.nb_lanes;
-					u32 window_size  =
-						nb_segments * segment_size +
-						(lane  == segment ? block-1 :
-						 block == 0       ? (u32)-1 : 0);
-
-					// Find reference block
-					u64  j1        = index_seed & 0xffffffff; // block selector
-					u64  x         = (j1 * j1)         >> 32;
-					u64  y         = (window_size * x) >> 32;
-					u64  z         = (window_size - 1) - y;
-					u64  ref       = (window_start + z) % lane_size;
-					u32  index     = lane * lane_size + (u32)ref;
-					blk *reference = blocks + index;
-
-					// Shuffle the previous & reference block
-					// into the current block
-					copy_block(&tmp, previous);
-					xor_block (&tmp, reference);
-					if (pass == 0) { copy_block(current, &tmp); }
-					else           { xor_block (current, &tmp); }
-					g_rounds  (&tmp);
-					xor_block (current, &tmp);
-				}
-			}
+			executor(executor_ctx, argon2_fill_segment, &s, config.nb_lanes);
 		}
 	}
 
-	// Wipe temporary block
-	volatile u64* p = tmp.a;
-	ZERO(p, 128);
-
 	// XOR last blocks of each lane
 	blk *last_block = blocks + lane_size - 1;
 	FOR_T (u32, lane, 1, config.nb_lanes) {
@@ -911,7 +1834,7 @@ void crypto_argon2(u8 *hash, u32 hash_size, void *work_area,
 	store64_le_buf(final_block, last_block->a, 128);
 
 	// Wipe work area
-	p = (u64*)work_area;
+	volatile u64 *p = (u64*)work_area;
 	ZERO(p, 128 * nb_blocks);
 
 	// Hash the very last block with H' into the output hash
@@ -919,6 +1842,15 @@ void crypto_argon2(u8 *hash, u32 hash_size, void *work_area,
 	WIPE_BUFFER(final_block);
 }
 
+void crypto_argon2(u8 *hash, u32 hash_size, void *work_area,
+                   crypto_argon2_config config,
+                   crypto_argon2_inputs inputs,
+                   crypto_argon2_extras extras)
+{
+	crypto_argon2_parallel(hash, hash_size, work_area,
+	                       config, inputs, extras, 0, 0);
+}
+
 ////////////////////////////////////
 /// Arithmetic modulo 2^255 - 19 ///
 ////////////////////////////////////
@@ -2855,6 +3787,47 @@ void crypto_x25519_inverse(u8 blind_salt [32], const u8 private_key[32],
 ////////////////////////////////
 /// Authenticated encryption ///
 ////////////////////////////////
+// Encrypts and authenticates in a single pass over the text.  The text
+// is processed in chunks small enough to still be in L1 cache when
+// Poly1305 reads them back, instead of running ChaCha20 and Poly1305
+// over the whole text one after the other.  Decryption does not use it:
+// the whole text is authenticated before any plaintext is written.
+#define AEAD_CHUNK_SIZE 1024
+
+#ifdef MONOCYPHER_X86_SIMD
+// Vector chunks are grouped by 16 (16KiB): small enough to stay in L1,
+// big enough to amortise the switch between ChaCha20 and Poly1305.
+// The Poly1305 accumulators stay in the 4-way kernel for the whole
+// text, and must start at a block boundary.
+#define AEAD_GROUP_CHUNKS 16
+
+TARGET("avx2")
+static void aead_chunks_avx2(crypto_poly1305_ctx *poly_ctx, u32 input[16],
+                             u8 *out, const u8 *in, size_t nb_chunks)
+{
+	poly_avx2_ctx p;
+	poly_avx2_init(&p, poly_ctx);
+	while (nb_chunks > 0) {
+		size_t group      = MIN(nb_chunks, AEAD_GROUP_CHUNKS);
+		size_t group_size = group * AEAD_CHUNK_SIZE;
+		FOR (i, 0, group) {
+			size_t offset = i * AEAD_CHUNK_SIZE;
+			if (chacha20_x16 != 0) {
+				chacha20_x16(out + offset, in + offset, input);
+			} else {
+				chacha20_x8(out + offset      , in + offset      , input);
+				chacha20_x8(out + offset + 512, in + offset + 512, input);
+			}
+		}
+		poly_avx2_update(&p, out, group_size >> 4);
+		out       += group_size;
+		in        += group_size;
+		nb_chunks -= group;
+	}
+	poly_avx2_final(&p, poly_ctx);
+}
+#endif // MONOCYPHER_X86_SIMD
+
 static void lock_auth(u8 mac[16], const u8  auth_key[32],
                       const u8 *ad         , size_t ad_size,
                       const u8 *cipher_text, size_t text_size)
@@ -2872,6 +3845,59 @@ static void lock_auth(u8 mac[16], const u8  auth_key[32],
 	crypto_poly1305_final (&poly_ctx, mac); // ...here
 }
 
+static void aead_stitched(crypto_aead_ctx *ctx, u8 mac[16], u8 auth_key[64],
+                          const u8 *ad ,   size_t ad_size,
+                          u8       *out,   const u8 *in,
+                          size_t text_size)
+{
+	crypto_chacha20_djb(auth_key, 0, 64, ctx->key, ctx->nonce, ctx->counter);
+
+	u8 sizes[16]; // Not secret, not wiped
+	store64_le(sizes + 0, ad_size);
+	store64_le(sizes + 8, text_size);
+	crypto_poly1305_ctx poly_ctx;           // auto wiped...
+	crypto_poly1305_init  (&poly_ctx, auth_key);
+	crypto_poly1305_update(&poly_ctx, ad  , ad_size);
+	crypto_poly1305_update(&poly_ctx, zero, gap(ad_size, 16));
+
+	u64    ctr       = ctx->counter + 1;
+	size_t remaining = text_size;
+#ifdef MONOCYPHER_X86_SIMD
+	// The chunk kernel needs the AVX2 Poly1305 state, and at least
+	// the 8-block ChaCha20 kernel.
+	if (text_size >= AEAD_CHUNK_SIZE && poly_blocks_x4 == poly_blocks_avx2
+	    && chacha20_x8 != 0) {
+		u32 input[16];
+		load32_le_buf(input     , chacha20_constant, 4);
+		load32_le_buf(input +  4, ctx->key         , 8);
+		load32_le_buf(input + 14, ctx->nonce       , 2);
+		input[12] = (u32) ctr;
+		input[13] = (u32)(ctr >> 32);
+		size_t nb_chunks = text_size / AEAD_CHUNK_SIZE;
+		aead_chunks_avx2(&poly_ctx, input, out, in, nb_chunks);
+		ctr        = input[12] + ((u64)input[13] << 32);
+		out       += nb_chunks * AEAD_CHUNK_SIZE;
+		in        += nb_chunks * AEAD_CHUNK_SIZE;
+		remaining -= nb_chunks * AEAD_CHUNK_SIZE;
+		WIPE_BUFFER(input);
+	}
+#endif
+	while (remaining > 0) {
+		// Chunks are multiples of 64 bytes (except the last one),
+		// so the counter stays in sync with a single ChaCha20 call.
+		size_t chunk = MIN(remaining, AEAD_CHUNK_SIZE);
+		ctr = crypto_chacha20_djb(out, in, chunk, ctx->key, ctx->nonce, ctr);
+		crypto_poly1305_update(&poly_ctx, out, chunk);
+		out       += chunk;
+		in        += chunk;
+		remaining -= chunk;
+	}
+
+	crypto_poly1305_update(&poly_ctx, zero , gap(text_size, 16));
+	crypto_poly1305_update(&poly_ctx, sizes, 16);
+	crypto_poly1305_final (&poly_ctx, mac); // ...here
+}
+
 void crypto_aead_init_x(crypto_aead_ctx *ctx,
                         u8 const key[32], const u8 nonce[24])
 {
@@ -2901,10 +3927,8 @@ void crypto_aead_write(crypto_aead_ctx *ctx, u8 *cipher_text, u8 mac[16],
                        const u8 *plain_text, size_t text_size)
 {
 	u8 auth_key[64]; // the last 32 bytes are used for rekeying.
-	crypto_chacha20_djb(auth_key, 0, 64, ctx->key, ctx->nonce, ctx->counter);
-	crypto_chacha20_djb(cipher_text, plain_text, text_size,
-	                    ctx->key, ctx->nonce, ctx->counter + 1);
-	lock_auth(mac, auth_key, ad, ad_size, cipher_text, text_size);
+	aead_stitched(ctx, mac, auth_key, ad, ad_size,
+	              cipher_text, plain_text, text_size);
 	COPY(ctx->key, auth_key + 32, 32);
 	WIPE_BUFFER(auth_key);
 }
@@ -2951,6 +3975,176 @@ int crypto_aead_unlock(u8 *plain_text, const u8  mac[16], const u8 key[32],
 	return mismatch;
 }
 
+////////////////////////////
+/// CPU specific kernels ///
+////////////////////////////
+// Each level uses the kernels of the levels below it, plus its own.
+// Levels are ordered: selecting one needs the features of all of them.
+static const char *const cpu_levels[] = {
+	"portable", // no SIMD
+	"sse",      // SSE2 Argon2, SSE4.1 BLAKE2b
+	"avx2",     // AVX2 everything
+	"avx512",   // AVX-512 ChaCha20, AVX2 for the rest
+};
+#define CPU_NB_LEVELS ((int)(sizeof(cpu_levels) / sizeof(cpu_levels[0])))
+static int cpu_level = 0; // portable until crypto_cpu_select()
+
+static int cpu_supports(int level)
+{
+#ifdef MONOCYPHER_X86_SIMD
+	switch (level) {
+	case 0 : return 1;
+	case 1 : return __builtin_cpu_supports("sse4.1");
+	case 2 : return __builtin_cpu_supports("avx2");
+	case 3 : return __builtin_cpu_supports("avx512f")
+		         && __builtin_cpu_supports("avx2");
+	default: return 0;
+	}
+#else
+	return level == 0;
+#endif
+}
+
+static int cpu_name_is(const char *name, const char *level)
+{
+	while (*name != 0 && *name == *level) {
+		name++;
+		level++;
+	}
+	return *name == *level;
+}
+
+static void cpu_bind(int level)
+{
+	chacha20_x16            = 0;
+	chacha20_x8             = 0;
+	poly_blocks_x4          = 0;
+	blake2b_compress_kernel = blake2b_compress_portable;
+	fill_block              = fill_block_portable;
+#ifdef MONOCYPHER_X86_SIMD
+	if (level >= 1) {
+		blake2b_compress_kernel = blake2b_compress_sse41;
+		fill_block              = fill_block_sse2;
+	}
+	if (level >= 2) {
+		chacha20_x8             = chacha20_blocks_avx2;
+		poly_blocks_x4          = poly_blocks_avx2;
+		blake2b_compress_kernel = blake2b_compress_avx2;
+		fill_block              = fill_block_avx2;
+	}
+	if (level >= 3) {
+		chacha20_x16            = chacha20_blocks_avx512;
+	}
+#endif
+	cpu_level = level;
+}
+
+int crypto_cpu_select(const char *impl)
+{
+	if (impl == 0 || impl[0] == 0 || cpu_name_is(impl, "auto")) {
+		int level = CPU_NB_LEVELS - 1;
+		while (!cpu_supports(level)) {
+			level--;
+		}
+		cpu_bind(level);
+		return 0;
+	}
+	FOR_T (int, level, 0, CPU_NB_LEVELS) {
+		if (cpu_name_is(impl, cpu_levels[level])) {
+			if (!cpu_supports(level)) {
+				return -1;
+			}
+			cpu_bind(level);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+const char *crypto_cpu_impl(void)
+{
+	return cpu_levels[cpu_level];
+}
+
+#ifdef MONOCYPHER_X86_SIMD
+// Probe the CPU once, before main().
+__attribute__((constructor))
+static void cpu_init(void)
+{
+	__builtin_cpu_init();
+	crypto_cpu_select("auto");
+}
+#endif
+
+// Runs every dispatched primitive on fixed inputs, and hashes the
+// results.  The sizes exercise the wide kernels and the portable tails.
+#define CPU_TEST_SIZE (3*1024 + 512 + 77)
+#define CPU_TEST_BLOCKS 8
+static void cpu_test_digest(u8 digest[64], void *work_area)
+{
+	u8 text [CPU_TEST_SIZE];
+	u8 out  [CPU_TEST_SIZE];
+	u8 key  [32];
+	u8 nonce[24];
+	u8 mac  [16];
+	u8 hash [64];
+	FOR (i, 0, CPU_TEST_SIZE) { text [i] = (u8)(i * 131 + 7); }
+	FOR (i, 0, 32)            { key  [i] = (u8)(i *  17 + 3); }
+	FOR (i, 0, 24)            { nonce[i] = (u8)(i *  29 + 5); }
+
+	crypto_blake2b_ctx ctx;
+	crypto_blake2b_init(&ctx, 64);
+
+	// Start below a 32-bit counter boundary to test the carry.
+	crypto_chacha20_djb(out, text, CPU_TEST_SIZE, key, nonce, 0xffffffe0);
+	crypto_blake2b_update(&ctx, out, CPU_TEST_SIZE);
+
+	crypto_poly1305(mac, text, CPU_TEST_SIZE, key);
+	crypto_blake2b_update(&ctx, mac, 16);
+
+	crypto_blake2b(hash, 64, text, CPU_TEST_SIZE);
+	crypto_blake2b_update(&ctx, hash, 64);
+
+	crypto_aead_lock(out, mac, key, nonce, text, 13, text, CPU_TEST_SIZE);
+	crypto_blake2b_update(&ctx, out, CPU_TEST_SIZE);
+	crypto_blake2b_update(&ctx, mac, 16);
+
+	crypto_argon2_config config = {
+		CRYPTO_ARGON2_ID, CPU_TEST_BLOCKS, 2, 1,
+	};
+	crypto_argon2_inputs inputs = { text, key, 64, 16 };
+	crypto_argon2(hash, 32, work_area, config, inputs,
+	              crypto_argon2_no_extras);
+	crypto_blake2b_update(&ctx, hash, 32);
+
+	crypto_blake2b_final(&ctx, digest);
+}
+
+int crypto_cpu_self_test(void)
+{
+	// Portable digest of the test inputs, to catch a broken reference.
+	static const u8 expected[64] = {
+		0xf5, 0x13, 0xbf, 0x28, 0xf4, 0x00, 0x63, 0x4c,
+		0x93, 0x37, 0x79, 0x7c, 0x05, 0x42, 0xde, 0x70,
+		0x56, 0xc2, 0xc5, 0xe0, 0x7c, 0x3c, 0x83, 0x71,
+		0x45, 0x3a, 0x42, 0xfa, 0xca, 0x1d, 0x8d, 0x7d,
+		0x8f, 0xb1, 0xb4, 0xb0, 0x09, 0x5c, 0x70, 0x71,
+		0x1d, 0x24, 0x42, 0x54, 0xc4, 0xfa, 0x8c, 0x76,
+		0x26, 0x9a, 0x57, 0x66, 0x04, 0xc5, 0xcd, 0xd8,
+		0x4c, 0x9f, 0x82, 0x47, 0xe1, 0x3b, 0x0c, 0x81,
+	};
+	blk work_area[CPU_TEST_BLOCKS];
+	u8 selected[64];
+	u8 portable[64];
+	int level = cpu_level;
+	cpu_test_digest(selected, work_area);
+	cpu_bind(0);
+	cpu_test_digest(portable, work_area);
+	cpu_bind(level);
+	return crypto_verify64(selected, portable)
+	    |  crypto_verify64(portable, expected);
+}
+
 #ifdef MONOCYPHER_CPP_NAMESPACE
 }
 #endif
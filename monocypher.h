@@ -77,6 +77,19 @@ int crypto_verify64(const uint8_t a[64], const uint8_t b[64]);
 void crypto_wipe(void *secret, size_t size);
 
 
+// CPU specific kernels
+// --------------------
+// The fastest kernels the CPU supports are selected at load time.
+// impl is "portable", "sse", "avx2", "avx512", or "auto" (the fastest).
+// Returns -1 if impl is unknown or not supported by this CPU.
+// Neither function is thread safe: call them before any other.
+int         crypto_cpu_select(const char *impl);
+const char *crypto_cpu_impl(void);
+// Compares the selected kernels with the portable code on fixed inputs.
+// Returns 0 if they agree, -1 otherwise.
+int crypto_cpu_self_test(void);
+
+
 // Authenticated encryption
 // ------------------------
 void crypto_aead_lock(uint8_t       *cipher_text,
@@ -159,7 +172,7 @@ typedef struct {
 	uint32_t algorithm;  // Argon2d, Argon2i, Argon2id
 	uint32_t nb_blocks;  // memory hardness, >= 8 * nb_lanes
 	uint32_t nb_passes;  // CPU hardness, >= 1 (>= 3 recommended for Argon2i)
-	uint32_t nb_lanes;   // parallelism level (single threaded anyway)
+	uint32_t nb_lanes;   // parallelism level (see crypto_argon2_parallel)
 } crypto_argon2_config;
 
 typedef struct {
@@ -183,6 +196,23 @@ void crypto_argon2(uint8_t *hash, uint32_t hash_size, void *work_area,
                    crypto_argon2_inputs inputs,
                    crypto_argon2_extras extras);
 
+// Calls fill(arg, lane) once for each lane in [0, nb_lanes), in any
+// order, possibly concurrently.  Must return only when all calls have
+// returned.
+typedef void crypto_argon2_executor(void *executor_ctx,
+                                    void (*fill)(void *arg, uint32_t lane),
+                                    void *arg, uint32_t nb_lanes);
+
+// Same as crypto_argon2(), with lanes filled by the executor.
+// A null executor fills them sequentially.
+void crypto_argon2_parallel(uint8_t *hash, uint32_t hash_size,
+                            void *work_area,
+                            crypto_argon2_config config,
+                            crypto_argon2_inputs inputs,
+                            crypto_argon2_extras extras,
+                            crypto_argon2_executor *executor,
+                            void *executor_ctx);
+
 
 // Key exchange (X-25519)
 // ----------------------
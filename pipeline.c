@@ -0,0 +1,1006 @@
+/********************************************************************************
+ * Program:    Viacvlaknove spracovanie prenosu pre zabezpeceny prenos suborov
+ * Subor:      pipeline.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia viacvlaknoveho odosielania a prijimania suboru:
+ *     - Zdroj (subor alebo siet) plni volne miesta kruhoveho zasobnika v poradi,
+ *       namapovany subor sa nekopiruje - pracovnici sifruju priamo z jeho stranok
+ *       a desifruju priamo do stranok vopred vyhradeneho vystupneho suboru
+ *     - Pracovnici sifruju alebo overuju a desifruju bloky nezavisle,
+ *       kazdy blok s vlastnym poradovym cislom v prude
+ *     - Ciel (siet alebo subor) spracuje bloky v povodnom poradi
+ *     - S io_uring sa davky blokov odosielaju na pozadi a subor sa cita
+ *       cez registrovane buffery blokov
+ *     Disk, procesor a siet tak pracuju sucasne.
+ *
+ * Zavislosti:
+ *     - pipeline.h (deklaracie funkcii)
+ *     - siete.h (odosielanie a prijimanie blokov)
+ *     - crypto_utils.h (sifrovanie blokov)
+ *     - platform.h (vlakna, ich synchronizacia a mapovanie suborov)
+ *     - io_ring.h (volitelny I/O engine io_uring)
+ *******************************************************************************/
+
+#include <stdio.h>  // Kniznica pre standardny vstup a vystup (citanie suboru, vypis chyb)
+#include <stdlib.h> // Kniznica pre spravu pamate
+#include <string.h> // Kniznica pre pracu s pamatou
+
+#include "pipeline.h"     // Deklaracie funkcii
+#include "siete.h"        // Pre odosielanie a prijimanie blokov
+#include "crypto_utils.h" // Pre sifrovanie blokov
+#include "platform.h"     // Pre vlakna, ich synchronizaciu a mapovanie suborov
+#include "io_ring.h"      // Pre volitelny I/O engine io_uring
+
+// Pocet pracovnikov: jeden na procesor, zdroj a ciel vacsinu casu cakaju na I/O
+unsigned pipeline_worker_count(void)
+{
+    unsigned cpus = platform_cpu_count();
+    return (cpus > PIPELINE_MAX_WORKERS) ? PIPELINE_MAX_WORKERS : cpus;
+}
+
+// Alokacia kruhoveho zasobnika pre danu velkost bloku a pocet pracovnikov
+// Navratova hodnota: 0 pri uspechu, -1 ak nie je dost pamate
+int pipeline_init(pipeline_t *pipeline, uint32_t frame_size, unsigned workers)
+{
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->net_ring.fd = -1;
+    pipeline->file_ring.fd = -1;
+    pipeline->nb_workers = (workers < 1) ? 1 : workers;
+    pipeline->nb_slots = pipeline->nb_workers * PIPELINE_SLOTS_PER_WORKER + 2; // +2 pre zdroj a ciel
+    pipeline->frame_size = frame_size;
+
+    pipeline->slots = calloc(pipeline->nb_slots, sizeof(pipeline_slot_t));
+    if (pipeline->slots == NULL)
+    {
+        return -1;
+    }
+    for (unsigned i = 0; i < pipeline->nb_slots; i++)
+    {
+        pipeline->slots[i].data = malloc(frame_size);
+        if (pipeline->slots[i].data == NULL)
+        {
+            pipeline_free(pipeline);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Prepnutie socketu aj suboru na io_uring - kazdy kruh pouziva iba jedno vlakno
+// (socket volajuce vlakno, subor vlakno zdroja alebo ciela), buffery blokov sa zaregistruju
+// v kruhu pre subor. Ak io_uring nie je dostupny, vrati -1 a retazec ostane pri blokujucich volaniach
+int pipeline_use_io_ring(pipeline_t *pipeline)
+{
+    uint8_t **buffers = calloc(pipeline->nb_slots, sizeof(uint8_t *));
+    if (buffers == NULL)
+    {
+        return -1;
+    }
+    for (unsigned i = 0; i < pipeline->nb_slots; i++)
+    {
+        buffers[i] = pipeline->slots[i].data;
+    }
+
+    int ok = io_ring_init(&pipeline->net_ring, IO_RING_ENTRIES) == 0 &&
+             io_ring_init(&pipeline->file_ring, IO_RING_ENTRIES) == 0 &&
+             io_ring_register_buffers(&pipeline->file_ring, buffers, pipeline->nb_slots, pipeline->frame_size) == 0;
+    free(buffers);
+    if (!ok)
+    {
+        io_ring_free(&pipeline->net_ring);
+        io_ring_free(&pipeline->file_ring);
+        return -1;
+    }
+    return 0;
+}
+
+// Bezpecne vymazanie a uvolnenie bufferov
+void pipeline_free(pipeline_t *pipeline)
+{
+    if (pipeline->net_ring.fd >= 0)
+    {
+        io_ring_free(&pipeline->net_ring);
+    }
+    if (pipeline->file_ring.fd >= 0)
+    {
+        io_ring_free(&pipeline->file_ring);
+    }
+    if (pipeline->slots != NULL)
+    {
+        for (unsigned i = 0; i < pipeline->nb_slots; i++)
+        {
+            if (pipeline->slots[i].data != NULL)
+            {
+                secure_wipe(pipeline->slots[i].data, pipeline->frame_size);
+                free(pipeline->slots[i].data);
+            }
+        }
+        secure_wipe(pipeline->slots, pipeline->nb_slots * sizeof(pipeline_slot_t));
+        free(pipeline->slots);
+    }
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+// Pomocne funkcie pre zdroj a ciel - vsetky sa volaju so zamknutym lock
+
+// Zastavenie vsetkych casti retazca po chybe
+static void pipeline_fail(pipeline_run_t *run)
+{
+    run->failed = 1;
+    platform_cond_broadcast(&run->slot_free);
+    platform_cond_broadcast(&run->frame_filled);
+    platform_cond_broadcast(&run->frame_ready);
+}
+
+// Zdroj: pocka na volne miesto pre dalsi blok, NULL ak retazec zlyhal
+// Miesto patri zdroju, kym ho neoznaci ako naplnene - moze ho plnit bez zamku
+static pipeline_slot_t *pipeline_wait_free_slot(pipeline_run_t *run)
+{
+    while (!run->failed && run->filled - run->drained == run->pipeline->nb_slots)
+    {
+        platform_cond_wait(&run->slot_free, &run->lock);
+    }
+    return run->failed ? NULL : &run->pipeline->slots[run->filled % run->pipeline->nb_slots];
+}
+
+// Zdroj: odovzda naplneny blok pracovnikom ako dalsi blok aktualnej epochy
+static void pipeline_fill_slot(pipeline_run_t *run, pipeline_slot_t *slot, size_t size)
+{
+    slot->size = size;
+    slot->epoch = run->epoch;
+    slot->sequence = run->sequence++;
+    run->epoch_bytes += size;
+    slot->ready = 0;
+    slot->auth_failed = 0;
+    run->filled++;
+    platform_cond_broadcast(&run->frame_filled);
+}
+
+// Zdroj: prechod na dalsiu epochu kluca (spravu o zmene kluca vypise volajuci)
+// Prud novej epochy nahradi prud predposlednej, preto sa najprv pocka, kym ciel spracuje
+// vsetky jej bloky (caka sa iba vtedy, ked je epocha kratsia nez zasobnik)
+// Navratova hodnota: 0 pri uspechu, -1 ak retazec zlyhal
+static int pipeline_next_epoch(pipeline_run_t *run)
+{
+    while (!run->failed && run->drained < run->epoch_start[run->epoch % 2])
+    {
+        platform_cond_wait(&run->slot_free, &run->lock);
+    }
+    if (run->failed)
+    {
+        return -1;
+    }
+
+    // Vsetky bloky v zasobniku patria aktualnej epoche, nahradeny prud uz nikto nepouziva
+    // Prud novej epochy uz pripravilo vlakno na pozadi, prevezme sa iba ukazovatel
+    uint32_t epoch;
+    platform_mutex_unlock(&run->lock);
+    const aead_ctx_t *aead = key_ratchet_next(run->keys, &epoch);
+    platform_mutex_lock(&run->lock);
+
+    run->epochs[epoch % 2] = aead;
+    run->epoch = epoch;
+    run->sequence = 0;
+    run->epoch_bytes = 0;
+    run->epoch_started_ms = platform_time_ms();
+    run->epoch_start[epoch % 2] = run->filled;
+    return 0;
+}
+
+// Zdroj: dalsie bloky uz nebudu
+static void pipeline_finish_filling(pipeline_run_t *run)
+{
+    run->filling_done = 1;
+    platform_cond_broadcast(&run->frame_filled);
+    platform_cond_broadcast(&run->frame_ready);
+}
+
+// Ciel: pocka, kym pracovnik spracuje dalsi blok v poradi
+// NULL ak su spracovane vsetky bloky alebo retazec zlyhal
+static pipeline_slot_t *pipeline_wait_ready_slot(pipeline_run_t *run)
+{
+    for (;;)
+    {
+        if (run->failed || (run->drained == run->filled && run->filling_done))
+        {
+            return NULL;
+        }
+        pipeline_slot_t *slot = &run->pipeline->slots[run->drained % run->pipeline->nb_slots];
+        if (run->drained < run->filled && slot->ready)
+        {
+            return slot;
+        }
+        platform_cond_wait(&run->frame_ready, &run->lock);
+    }
+}
+
+// Ciel: blok je spracovany, miesto sa uvolni pre zdroj
+static void pipeline_drain_slot(pipeline_run_t *run, pipeline_slot_t *slot)
+{
+    run->pipeline->frames++;
+    run->pipeline->bytes += slot->size;
+    slot->ready = 0;
+    run->drained++;
+    platform_cond_broadcast(&run->slot_free);
+}
+
+// Vlakno pracovnika - berie naplnene bloky a zasifruje ich prudom ich epochy a ich poradovym cislom
+// Bloky su nezavisle, preto moze naraz pracovat lubovolny pocet pracovnikov
+static void pipeline_worker(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_t *pipeline = run->pipeline;
+
+    platform_mutex_lock(&run->lock);
+    while (!run->failed)
+    {
+        if (run->claimed == run->filled)
+        {
+            if (run->filling_done)
+            {
+                break;
+            }
+            platform_cond_wait(&run->frame_filled, &run->lock);
+            continue;
+        }
+
+        uint64_t index = run->claimed++;
+        pipeline_slot_t *slot = &pipeline->slots[index % pipeline->nb_slots];
+        const aead_ctx_t *aead = run->epochs[slot->epoch % 2];
+        platform_mutex_unlock(&run->lock);
+        const uint8_t *plain_text = (slot->mapped != NULL) ? slot->mapped : slot->data;
+        aead_encrypt_at(aead, slot->sequence, slot->data, slot->tag, plain_text, slot->size);
+        platform_mutex_lock(&run->lock);
+
+        slot->ready = 1;
+        platform_cond_broadcast(&run->frame_ready);
+    }
+    platform_mutex_unlock(&run->lock);
+}
+
+// Odosielanie - zdroj, cast citania: naplni miesto dalsim blokom suboru
+// Z namapovaneho suboru iba nastavi ukazovatel na blok (pracovnik sifruje priamo zo stranok suboru)
+// a poziada system o nacitanie bloku, ktory pride na rad o jeden zasobnik neskor
+// Navratova hodnota: pocet bajtov bloku (menej nez frame_size na konci suboru), -1 pri chybe
+static int64_t pipeline_read_frame(pipeline_run_t *run, pipeline_slot_t *slot)
+{
+    uint32_t frame_size = run->pipeline->frame_size;
+    if (run->map != NULL)
+    {
+        uint64_t left = run->map->size - run->map_offset;
+        size_t size = (left < frame_size) ? (size_t)left : frame_size;
+        slot->mapped = run->map->data + run->map_offset;
+        run->map_offset += size;
+        platform_file_map_prefetch(run->map, run->map_offset + (uint64_t)(run->pipeline->nb_slots - 1) * frame_size,
+                                   frame_size);
+        return (int64_t)size;
+    }
+
+    slot->mapped = NULL;
+    if (run->pipeline->file_ring.fd < 0)
+    {
+        size_t size = fread(slot->data, 1, frame_size, run->file);
+        return ferror(run->file) ? -1 : (int64_t)size;
+    }
+
+    // io_uring: citanie do registrovaneho buffera bloku, kym nie je blok plny alebo subor neskonci
+    int index = (int)(slot - run->pipeline->slots);
+    size_t size = 0;
+    while (size < frame_size)
+    {
+        ssize_t result = io_ring_read(&run->pipeline->file_ring, fileno(run->file),
+                                      slot->data + size, frame_size - size, index);
+        if (result < 0)
+        {
+            return -1;
+        }
+        if (result == 0)
+        {
+            break; // Koniec suboru
+        }
+        size += (size_t)result;
+    }
+    return (int64_t)size;
+}
+
+// Odosielanie - zdroj: nacitava bloky suboru (samostatne vlakno)
+// Ked to vyzaduju pravidla rotacie, prejde pred dalsim blokom na dalsiu epochu kluca, prud sa nezastavi
+static void pipeline_file_reader(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    uint32_t frame_size = run->pipeline->frame_size;
+
+    platform_mutex_lock(&run->lock);
+    for (;;)
+    {
+        pipeline_slot_t *slot = pipeline_wait_free_slot(run);
+        if (slot == NULL)
+        {
+            break;
+        }
+
+        platform_mutex_unlock(&run->lock);
+        int64_t result = pipeline_read_frame(run, slot);
+        platform_mutex_lock(&run->lock);
+
+        if (result < 0)
+        {
+            fprintf(stderr, ERR_FILE_READ);
+            pipeline_fail(run);
+            break;
+        }
+        size_t size = (size_t)result;
+        if (size > 0)
+        {
+            if (rotation_policy_due(run->policy, run->sequence, run->epoch_bytes,
+                                    platform_time_ms() - run->epoch_started_ms))
+            {
+                if (pipeline_next_epoch(run) != 0)
+                {
+                    break;
+                }
+                printf(MSG_KEY_ROTATION, run->epoch, (unsigned long long)run->filled);
+            }
+            pipeline_fill_slot(run, slot, size);
+        }
+        if (size < frame_size)
+        {
+            break; // Koniec suboru
+        }
+    }
+    pipeline_finish_filling(run);
+    platform_mutex_unlock(&run->lock);
+}
+
+// Odosielanie - ciel: posiela zasifrovane bloky v poradi (volajuce vlakno)
+// Vsetky bloky, ktore su v poradi uz pripravene, sa poslu spolu jednym volanim systemu
+static void pipeline_socket_sender(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_t *pipeline = run->pipeline;
+
+    platform_mutex_lock(&run->lock);
+    while (pipeline_wait_ready_slot(run) != NULL)
+    {
+        frame_t frames[FRAME_SEND_BATCH];
+        unsigned count = 0;
+        size_t bytes = 0;
+        while (count < FRAME_SEND_BATCH && run->drained + count < run->filled)
+        {
+            pipeline_slot_t *slot = &pipeline->slots[(run->drained + count) % pipeline->nb_slots];
+            if (!slot->ready)
+            {
+                break;
+            }
+            frames[count].tag = slot->tag;
+            frames[count].data = slot->data;
+            frames[count].size = slot->size;
+            frames[count].epoch = slot->epoch;
+            bytes += slot->size;
+            count++;
+        }
+
+        platform_mutex_unlock(&run->lock);
+        int ok = send_frames(run->socket, frames, count, pipeline->frame_size) == 0;
+        if (ok && run->progress != NULL)
+        {
+            run->progress(run->progress_arg, bytes);
+        }
+        platform_mutex_lock(&run->lock);
+
+        if (!ok)
+        {
+            fprintf(stderr, ERR_SEND_ENCRYPTED_CHUNK);
+            pipeline_fail(run);
+            break;
+        }
+        for (unsigned i = 0; i < count; i++)
+        {
+            pipeline_drain_slot(run, &pipeline->slots[run->drained % pipeline->nb_slots]);
+        }
+    }
+    platform_mutex_unlock(&run->lock);
+}
+
+// Odosielanie - ciel s io_uring: davka blokov sa odosiela na pozadi, kym sa zbiera dalsia
+// Kazda davka zacne az po dokonceni predchadzajucej, takze bloky idu na socket v poradi
+// a medzi davkami nevznikne medzera. Bloky davky sa uvolnia az po jej dokonceni
+static void pipeline_socket_sender_ring(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_t *pipeline = run->pipeline;
+    io_ring_t *ring = &pipeline->net_ring;
+
+    frame_batch_t batches[IO_RING_SEND_DEPTH];
+    unsigned batch_frames[IO_RING_SEND_DEPTH];
+    size_t batch_plain[IO_RING_SEND_DEPTH]; // Bajty otvoreneho textu v davke (pre progres)
+    unsigned oldest = 0;                    // Najstarsia davka na pozadi
+    unsigned queued = 0;                    // Pocet davok na pozadi
+    uint64_t sending = 0;                   // Pocet blokov v davkach na pozadi
+
+    platform_mutex_lock(&run->lock);
+    while (!run->failed)
+    {
+        // Nova davka, ak je na nu miesto - bez davok na pozadi sa pocka na pripraveny blok
+        if (queued < IO_RING_SEND_DEPTH)
+        {
+            if (queued == 0 && pipeline_wait_ready_slot(run) == NULL)
+            {
+                break;
+            }
+            unsigned next = (oldest + queued) % IO_RING_SEND_DEPTH;
+            frame_t frames[FRAME_SEND_BATCH];
+            unsigned count = 0;
+            size_t bytes = 0;
+            uint64_t first = run->drained + sending;
+            while (count < FRAME_SEND_BATCH && first + count < run->filled)
+            {
+                pipeline_slot_t *slot = &pipeline->slots[(first + count) % pipeline->nb_slots];
+                if (!slot->ready)
+                {
+                    break;
+                }
+                frames[count].tag = slot->tag;
+                frames[count].data = slot->data;
+                frames[count].size = slot->size;
+                frames[count].epoch = slot->epoch;
+                bytes += slot->size;
+                count++;
+            }
+
+            if (count > 0)
+            {
+                platform_mutex_unlock(&run->lock);
+                int ok = frame_batch_prepare(&batches[next], frames, count, pipeline->frame_size) == 0 &&
+                         queue_frame_batch(ring, run->socket, &batches[next], next) == 0 &&
+                         io_ring_submit(ring) == 0;
+                platform_mutex_lock(&run->lock);
+
+                if (!ok)
+                {
+                    fprintf(stderr, ERR_SEND_ENCRYPTED_CHUNK);
+                    pipeline_fail(run);
+                    break;
+                }
+                batch_frames[next] = count;
+                batch_plain[next] = bytes;
+                sending += count;
+                queued++;
+                continue;
+            }
+        }
+
+        // Pocka na dokoncenie najstarsej davky a uvolni jej bloky
+        platform_mutex_unlock(&run->lock);
+        uint64_t done;
+        ssize_t result;
+        int ok = io_ring_wait(ring, &done, &result) == 0 && done == oldest &&
+                 result == (ssize_t)batches[oldest].bytes;
+        if (ok && run->progress != NULL)
+        {
+            run->progress(run->progress_arg, batch_plain[oldest]);
+        }
+        platform_mutex_lock(&run->lock);
+
+        queued--;
+        if (!ok)
+        {
+            fprintf(stderr, ERR_SEND_ENCRYPTED_CHUNK);
+            pipeline_fail(run);
+            break;
+        }
+        for (unsigned i = 0; i < batch_frames[oldest]; i++)
+        {
+            pipeline_drain_slot(run, &pipeline->slots[run->drained % pipeline->nb_slots]);
+        }
+        sending -= batch_frames[oldest];
+        oldest = (oldest + 1) % IO_RING_SEND_DEPTH;
+    }
+    platform_mutex_unlock(&run->lock);
+
+    // Po chybe jadro moze este citat davky na pozadi - buffery sa nesmu uvolnit skor
+    while (queued > 0)
+    {
+        uint64_t done;
+        ssize_t result;
+        if (io_ring_wait(ring, &done, &result) != 0)
+        {
+            break;
+        }
+        queued--;
+    }
+}
+
+// Prijimanie - zdroj: overi epochu z hlavicky bloku voci aktualnej epoche
+// Epocha moze ostat rovnaka alebo sa zvysit o jednu, nic ine odosielatel neposiela
+// Bloky a bajty epochy sa kontroluju voci dohodnutym pravidlam, cas nie (hodiny stran sa lisia)
+// Navratova hodnota: 1 ak blok zacina dalsiu epochu, 0 ak patri aktualnej, -1 pri chybe
+static int pipeline_check_epoch(const pipeline_run_t *run, uint32_t epoch)
+{
+    if (epoch == run->epoch + 1)
+    {
+        return 1;
+    }
+    if (epoch != run->epoch)
+    {
+        fprintf(stderr, ERR_FRAME_EPOCH, epoch, run->epoch);
+        return -1;
+    }
+    if (rotation_policy_due(run->policy, run->sequence, run->epoch_bytes, 0))
+    {
+        fprintf(stderr, ERR_ROTATION_POLICY, epoch);
+        return -1;
+    }
+    return 0;
+}
+
+// Prijimanie - zdroj: do namapovaneho suboru sa blok desifruje na svoje miesto,
+// za ohlaseny koniec suboru nesmie
+// Navratova hodnota: 0 pri uspechu, -1 ak blok presahuje ohlasenu velkost suboru
+static int pipeline_map_frame(pipeline_run_t *run, pipeline_slot_t *slot, uint32_t size)
+{
+    slot->mapped = NULL;
+    if (run->map != NULL)
+    {
+        if (size > run->map->size - run->map_offset)
+        {
+            fprintf(stderr, ERR_FILE_SIZE_MISMATCH, (unsigned long long)run->map->size);
+            return -1;
+        }
+        slot->mapped = run->map->data + run->map_offset;
+        run->map_offset += size;
+    }
+    return 0;
+}
+
+// Prijimanie - ciel, cast zapisu: zapise desifrovany blok na koniec suboru
+// Navratova hodnota: 0 pri uspechu, -1 pri chybe zapisu
+static int pipeline_write_frame(pipeline_run_t *run, pipeline_slot_t *slot)
+{
+    return (fwrite(slot->data, 1, slot->size, run->file) == slot->size) ? 0 : -1;
+}
+
+// Zaciatok behu retazca: prvy blok pouzije dalsiu pripravenu epochu z keys
+static void pipeline_run_begin(pipeline_run_t *run, key_ratchet_t *keys, const rotation_policy_t *policy)
+{
+    run->keys = keys;
+    run->policy = policy;
+    const aead_ctx_t *aead = key_ratchet_next(keys, &run->epoch);
+    run->epochs[run->epoch % 2] = aead;
+    run->epoch_started_ms = platform_time_ms();
+    platform_mutex_init(&run->lock);
+    platform_cond_init(&run->slot_free);
+    platform_cond_init(&run->frame_filled);
+    platform_cond_init(&run->frame_ready);
+
+    run->pipeline->frames = 0;
+    run->pipeline->bytes = 0;
+}
+
+// Koniec behu retazca, ziadne vlakno uz nepouziva jeho zamok
+static void pipeline_run_end(pipeline_run_t *run)
+{
+    platform_cond_destroy(&run->frame_ready);
+    platform_cond_destroy(&run->frame_filled);
+    platform_cond_destroy(&run->slot_free);
+    platform_mutex_destroy(&run->lock);
+}
+
+// Spolocny beh retazca
+// - thread_stage bezi v novom vlakne spolu s pracovnikmi, caller_stage vo volajucom vlakne
+// - prvy blok pouzije dalsiu pripravenu epochu z keys, po navrate su vsetky vlakna ukoncene
+// Navratova hodnota: 0 pri uspechu, -1 ak niektora cast zlyhala
+static int pipeline_run(pipeline_run_t *run, key_ratchet_t *keys, const rotation_policy_t *policy,
+                        void (*thread_stage)(void *arg), void (*caller_stage)(void *arg))
+{
+    pipeline_t *pipeline = run->pipeline;
+    pipeline_run_begin(run, keys, policy);
+
+    platform_thread_t stage;
+    platform_thread_t workers[PIPELINE_MAX_WORKERS];
+    unsigned nb_started = 0;
+    int stage_started = (platform_thread_create(&stage, thread_stage, run) == 0);
+    if (stage_started)
+    {
+        while (nb_started < pipeline->nb_workers && nb_started < PIPELINE_MAX_WORKERS &&
+               platform_thread_create(&workers[nb_started], pipeline_worker, run) == 0)
+        {
+            nb_started++;
+        }
+    }
+
+    if (!stage_started || nb_started == 0)
+    {
+        fprintf(stderr, ERR_PIPELINE_THREAD);
+        platform_mutex_lock(&run->lock);
+        pipeline_fail(run);
+        platform_mutex_unlock(&run->lock);
+    }
+    else
+    {
+        caller_stage(run);
+    }
+
+    if (stage_started)
+    {
+        platform_thread_join(&stage);
+    }
+    for (unsigned i = 0; i < nb_started; i++)
+    {
+        platform_thread_join(&workers[i]);
+    }
+    pipeline_run_end(run);
+    return run->failed ? -1 : 0;
+}
+
+// Zasifruje a odosle cely subor, kluc meni podla dohodnutych pravidiel rotacie
+// Kluc sa meni bez zastavenia prudu - epocha je v hlavicke kazdeho bloku
+// Obycajny subor sa namapuje do pamate a sifruje bez kopirovania, ostatne sa citaju cez fread
+// Po navrate pipeline->frames a pipeline->bytes popisuju, co sa odoslalo (koniec suboru neposiela)
+// Navratova hodnota: 0 pri uspechu, -1 pri chybe citania, vlakien alebo odosielania
+int pipeline_send(pipeline_t *pipeline, int socket, FILE *file,
+                  key_ratchet_t *keys, const rotation_policy_t *policy,
+                  pipeline_progress_fn progress, void *progress_arg)
+{
+    pipeline_run_t run;
+    memset(&run, 0, sizeof(run));
+    run.pipeline = pipeline;
+    run.socket = socket;
+    run.file = file;
+    run.progress = progress;
+    run.progress_arg = progress_arg;
+
+    // Subor sa cita od aktualnej polohy, mapovat sa preto da iba subor citany od zaciatku
+    platform_file_map_t map;
+    if (ftell(file) == 0 && platform_file_map(&map, file) == 0)
+    {
+        run.map = &map;
+        platform_file_map_prefetch(&map, 0, (uint64_t)pipeline->nb_slots * pipeline->frame_size);
+    }
+    int result = pipeline_run(&run, keys, policy, pipeline_file_reader,
+                              (pipeline->net_ring.fd >= 0) ? pipeline_socket_sender_ring : pipeline_socket_sender);
+    if (run.map != NULL)
+    {
+        platform_file_unmap(&map);
+    }
+    return result;
+}
+
+// Prijimanie: ak odosielatel ohlasil velkost suboru, miesto pre subor sa vyhradi naraz
+// a subor sa namapuje - pracovnici potom desifruju bloky priamo na ich miesto v nom
+static void pipeline_output_open(pipeline_run_t *run, FILE *file, uint64_t file_size)
+{
+    run->file = file;
+    run->file_size = file_size;
+    if (file_size != FILE_SIZE_UNKNOWN && platform_file_map_output(&run->file_map, file, file_size) == 0)
+    {
+        run->map = &run->file_map;
+    }
+}
+
+// Prijimanie: zrusi mapovanie vystupneho suboru a overi, ze prisla ohlasena velkost
+// Vyhradene miesto za poslednym zapisanym blokom (po chybe alebo kratsom subore) sa odstrani
+// Navratova hodnota: result, alebo -1 ak velkost nesedi alebo sa subor neda skratit
+static int pipeline_output_close(pipeline_run_t *run, int result)
+{
+    uint64_t bytes = run->pipeline->bytes;
+    int preallocated = run->map != NULL;
+    if (preallocated)
+    {
+        platform_file_unmap(&run->file_map);
+        run->map = NULL;
+    }
+
+    if (result == 0 && run->file_size != FILE_SIZE_UNKNOWN && bytes != run->file_size)
+    {
+        fprintf(stderr, ERR_FILE_SIZE_MISMATCH, (unsigned long long)run->file_size);
+        result = -1;
+    }
+    if (preallocated && bytes != run->file_size && platform_file_truncate(run->file, bytes) != 0)
+    {
+        fprintf(stderr, ERR_WRITE_TO_FILE);
+        result = -1;
+    }
+    return result;
+}
+
+// Prijimanie riadene udalostami - uloha v skupine vlakien: overi a desifruje jeden blok
+// Kazdy naplneny blok zaradi jednu ulohu, uloha si vsak (ako pracovnik) vezme dalsi blok v poradi
+// Reaktor moze beh ukoncit, hned ako uvidi in_flight == 0, notify sa preto vola este so zamknutym lock
+// a po odomknuti sa uz beh nepouziva
+static void pipeline_stream_task(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_t *pipeline = run->pipeline;
+
+    platform_mutex_lock(&run->lock);
+    pipeline_slot_t *slot = &pipeline->slots[run->claimed++ % pipeline->nb_slots];
+    const aead_ctx_t *aead = run->epochs[slot->epoch % 2];
+    platform_mutex_unlock(&run->lock);
+
+    uint8_t *plain_text = (slot->mapped != NULL) ? slot->mapped : slot->data;
+    int auth_failed = aead_decrypt_at(aead, slot->sequence, plain_text, slot->tag, slot->data, slot->size) != 0;
+
+    platform_mutex_lock(&run->lock);
+    slot->auth_failed = auth_failed;
+    slot->ready = 1;
+    run->in_flight--;
+    run->notify(run->notify_arg);
+    platform_mutex_unlock(&run->lock);
+}
+
+// Prijimanie riadene udalostami - uloha v skupine vlakien: zapise spracovane bloky v poradi cez fwrite
+// Pouziva sa iba pre subor, ktory sa nenamapoval (neznama velkost) - zapis na disk by inak
+// zdrzal reaktor a vsetky jeho spojenia. Naraz bezi najviac jedna, poradie blokov sa tak zachova
+static void pipeline_stream_write_task(void *arg)
+{
+    pipeline_run_t *run = (pipeline_run_t *)arg;
+    pipeline_t *pipeline = run->pipeline;
+
+    platform_mutex_lock(&run->lock);
+    while (run->drained < run->filled)
+    {
+        pipeline_slot_t *slot = &pipeline->slots[run->drained % pipeline->nb_slots];
+        if (!slot->ready || slot->auth_failed)
+        {
+            break; // Blok s chybnym tagom ohlasi reaktor v pipeline_stream_drain
+        }
+        platform_mutex_unlock(&run->lock);
+        int ok = pipeline_write_frame(run, slot) == 0;
+        platform_mutex_lock(&run->lock);
+        if (!ok)
+        {
+            run->write_failed = 1;
+            break;
+        }
+        pipeline_drain_slot(run, slot);
+    }
+    run->writing = 0;
+    run->in_flight--;
+    run->notify(run->notify_arg);
+    platform_mutex_unlock(&run->lock);
+}
+
+// Prijimanie riadene udalostami: zacne prijimat blok, ktoreho hlavicka uz prisla
+// Blok caka, kym je v zasobniku volne miesto, a blok dalsej epochy aj na spracovanie
+// vsetkych blokov predposlednej epochy (jej prud nahradi) - pokracuje pipeline_stream_drain
+// Navratova hodnota: 0 pri uspechu (aj ked blok caka), -1 pri chybe
+static int pipeline_stream_start_frame(pipeline_run_t *run)
+{
+    int result = 0;
+    platform_mutex_lock(&run->lock);
+    if (run->next_epoch && run->drained >= run->epoch_start[run->epoch % 2])
+    {
+        pipeline_next_epoch(run);
+        run->next_epoch = 0;
+    }
+    if (!run->next_epoch && run->filled - run->drained < run->pipeline->nb_slots)
+    {
+        pipeline_slot_t *slot = &run->pipeline->slots[run->filled % run->pipeline->nb_slots];
+        if (pipeline_map_frame(run, slot, run->frame_bytes) != 0)
+        {
+            result = -1;
+        }
+        else
+        {
+            run->part = PIPELINE_PART_TAG;
+            run->part_received = 0;
+        }
+    }
+    platform_mutex_unlock(&run->lock);
+    return result;
+}
+
+// Zaciatok prijimania riadeneho udalostami
+// Na rozdiel od pipeline_send nebezi ziadne vlakno retazca: reaktor prijima bloky
+// z neblokujuceho socketu po castiach, kazdy prijaty blok overi a desifruje uloha v skupine pool
+// a po nej sa zavola notify (so zamknutym run->lock, nesmie preto volat funkcie retazca)
+void pipeline_stream_begin(pipeline_run_t *run, pipeline_t *pipeline, task_pool_t *pool,
+                           FILE *file, uint64_t file_size, key_ratchet_t *keys,
+                           const rotation_policy_t *policy, void (*notify)(void *arg), void *notify_arg)
+{
+    memset(run, 0, sizeof(*run));
+    run->pipeline = pipeline;
+    run->pool = pool;
+    run->notify = notify;
+    run->notify_arg = notify_arg;
+    run->part = PIPELINE_PART_HEADER;
+    for (unsigned i = 0; i < pipeline->nb_slots; i++)
+    {
+        // Uloha sa nastavi raz, pri zaradeni sa meni iba jej next (pod zamkom skupiny)
+        pipeline->slots[i].task.fn = pipeline_stream_task;
+        pipeline->slots[i].task.arg = run;
+    }
+    run->write_task.fn = pipeline_stream_write_task;
+    run->write_task.arg = run;
+    pipeline_output_open(run, file, file_size);
+    pipeline_run_begin(run, keys, policy);
+}
+
+// Buffer pre dalsie bajty prudu zo socketu a ich najvacsi pocet
+// Navratova hodnota: NULL ak blok caka na miesto v zasobniku alebo uz prisiel koniec suboru
+uint8_t *pipeline_stream_buffer(pipeline_run_t *run, size_t *size)
+{
+    pipeline_slot_t *slot = &run->pipeline->slots[run->filled % run->pipeline->nb_slots];
+    if (run->part == PIPELINE_PART_HEADER)
+    {
+        *size = FRAME_HEADER_SIZE - run->part_received;
+        return run->header + run->part_received;
+    }
+    if (run->part == PIPELINE_PART_TAG)
+    {
+        *size = TAG_SIZE - run->part_received;
+        return slot->tag + run->part_received;
+    }
+    if (run->part == PIPELINE_PART_DATA)
+    {
+        *size = run->frame_bytes - run->part_received;
+        return slot->data + run->part_received;
+    }
+    return NULL;
+}
+
+// Spracovanie bajtov prijatych do buffera z pipeline_stream_buffer
+// Cely blok sa odovzda ako uloha skupine vlakien, hlavicka s velkostou 0 ukonci prud
+// Navratova hodnota: 0 pri uspechu, -1 pri chybnej velkosti alebo epoche bloku
+int pipeline_stream_received(pipeline_run_t *run, size_t size)
+{
+    run->part_received += size;
+    if (run->part == PIPELINE_PART_HEADER)
+    {
+        if (run->part_received < FRAME_HEADER_SIZE)
+        {
+            return 0;
+        }
+        uint32_t epoch;
+        frame_header_decode(run->header, &run->frame_bytes, &epoch);
+        run->part_received = 0;
+        if (run->frame_bytes == 0)
+        {
+            run->part = PIPELINE_PART_END; // Koniec suboru
+            return 0;
+        }
+        if (run->frame_bytes > run->pipeline->frame_size)
+        {
+            fprintf(stderr, ERR_FRAME_SIZE, run->frame_bytes, run->pipeline->frame_size);
+            return -1;
+        }
+        int next = pipeline_check_epoch(run, epoch);
+        if (next < 0)
+        {
+            return -1;
+        }
+        run->next_epoch = next;
+        run->part = PIPELINE_PART_WAIT;
+        return pipeline_stream_start_frame(run);
+    }
+
+    if (run->part == PIPELINE_PART_TAG)
+    {
+        if (run->part_received == TAG_SIZE)
+        {
+            run->part = PIPELINE_PART_DATA;
+            run->part_received = 0;
+        }
+        return 0;
+    }
+
+    if (run->part_received < run->frame_bytes)
+    {
+        return 0;
+    }
+    pipeline_slot_t *slot = &run->pipeline->slots[run->filled % run->pipeline->nb_slots];
+    platform_mutex_lock(&run->lock);
+    pipeline_fill_slot(run, slot, run->frame_bytes);
+    run->in_flight++;
+    platform_mutex_unlock(&run->lock);
+    task_pool_submit(run->pool, &slot->task);
+
+    run->part = PIPELINE_PART_HEADER;
+    run->part_received = 0;
+    return 0;
+}
+
+// Spracovanie bajtov prudu, ktore uz prisli do ineho buffera (jednym recv aj viac blokov)
+// Bajty sa rozdelia do hlavicky, tagu a dat blokov, kym ich prud prijima - zvysok (*used az size)
+// pocka, kym blok dostane miesto v zasobniku
+// Navratova hodnota: 0 pri uspechu, -1 pri chybnej velkosti alebo epoche bloku
+int pipeline_stream_feed(pipeline_run_t *run, const uint8_t *data, size_t size, size_t *used)
+{
+    *used = 0;
+    while (*used < size)
+    {
+        size_t wanted;
+        uint8_t *buffer = pipeline_stream_buffer(run, &wanted);
+        if (buffer == NULL)
+        {
+            break;
+        }
+        size_t n = (size - *used < wanted) ? size - *used : wanted;
+        memcpy(buffer, data + *used, n);
+        *used += n;
+        if (pipeline_stream_received(run, n) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Uvolnenie miest blokov, ktore su v poradi uz spracovane - blok, ktory caka na miesto, potom moze zacat
+// Bloky v namapovanom subore uz su na svojom mieste, ostatne zapise uloha zapisu v skupine vlakien
+// (po nej sa zavola notify a reaktor pokracuje dalsim volanim)
+// Navratova hodnota: 0 pri uspechu, -1 pri chybe overenia tagu, zapisu alebo mapovania
+int pipeline_stream_drain(pipeline_run_t *run)
+{
+    pipeline_t *pipeline = run->pipeline;
+    int write = 0;
+
+    platform_mutex_lock(&run->lock);
+    while (run->drained < run->filled && !run->writing)
+    {
+        pipeline_slot_t *slot = &pipeline->slots[run->drained % pipeline->nb_slots];
+        if (!slot->ready)
+        {
+            break;
+        }
+        if (slot->auth_failed)
+        {
+            fprintf(stderr, ERR_DECRYPT_CHUNK_AUTH);
+            platform_mutex_unlock(&run->lock);
+            return -1;
+        }
+        if (slot->mapped == NULL)
+        {
+            run->writing = 1;
+            run->in_flight++;
+            write = 1;
+            break;
+        }
+        pipeline_drain_slot(run, slot);
+    }
+    int write_failed = run->write_failed;
+    platform_mutex_unlock(&run->lock);
+
+    if (write_failed)
+    {
+        fprintf(stderr, ERR_WRITE_TO_FILE);
+        return -1;
+    }
+    if (write)
+    {
+        task_pool_submit(run->pool, &run->write_task);
+    }
+    return (run->part == PIPELINE_PART_WAIT) ? pipeline_stream_start_frame(run) : 0;
+}
+
+// 1 ak prisiel koniec suboru a vsetky bloky su zapisane (filled meni iba reaktor, drained aj uloha zapisu)
+int pipeline_stream_done(pipeline_run_t *run)
+{
+    platform_mutex_lock(&run->lock);
+    int done = run->part == PIPELINE_PART_END && run->drained == run->filled;
+    platform_mutex_unlock(&run->lock);
+    return done;
+}
+
+// 1 ak niektora uloha este spracuva blok - beh sa potom nesmie ukoncit
+int pipeline_stream_busy(pipeline_run_t *run)
+{
+    platform_mutex_lock(&run->lock);
+    int busy = run->in_flight > 0;
+    platform_mutex_unlock(&run->lock);
+    return busy;
+}
+
+// Koniec prijimania riadeneho udalostami (ziadna uloha uz nebezi)
+// Po navrate su vsetky zapisane bloky v subore a subor nie je dlhsi nez zapisane bloky
+// Navratova hodnota: result, alebo -1 ak prijate data nezodpovedaju ohlasenej velkosti
+int pipeline_stream_end(pipeline_run_t *run, int result)
+{
+    pipeline_run_end(run);
+    return pipeline_output_close(run, result);
+}
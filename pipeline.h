@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * Program:    Viacvlaknove spracovanie prenosu pre zabezpeceny prenos suborov
+ * Subor:      pipeline.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre viacvlaknove odosielanie a prijimanie suboru:
+ *     - Odosielanie: citanie suboru (namapovaneho do pamate, ak to ide), sifrovanie
+ *       vo vlaknach pracovnikov, odoslanie v poradi
+ *     - Obmedzeny kruhovy zasobnik blokov (spatny tlak na rychlejsiu stranu)
+ *     - Volitelne io_uring pre socket aj subor (odosielanie na pozadi, registrovane buffery)
+ *     - Prijimanie riadene udalostami pre reaktor servera: neblokujuci socket plni
+ *       zasobnik po castiach, bloky overi a desifruje spolocna skupina vlakien
+ *       priamo do vopred vyhradeneho namapovaneho suboru (alebo zapise v poradi)
+ *
+ * Zavislosti:
+ *     - crypto_utils.h (sifrovanie blokov)
+ *     - constants.h (konstanty programu)
+ *     - platform.h (vlakna a ich synchronizacia)
+ *     - siete.h (velkosti hlavicky a tagu bloku)
+ *     - io_ring.h (volitelny I/O engine io_uring)
+ *     - task_pool.h (spolocna skupina vlakien)
+ ******************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>  // Kniznica pre typ FILE
+#include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t)
+
+#include "crypto_utils.h" // Pre sifrovanie blokov
+#include "constants.h"    // Definicie konstant pre program
+#include "platform.h"     // Pre vlakna a ich synchronizaciu
+#include "siete.h"        // Pre velkosti hlavicky a tagu bloku
+#include "io_ring.h"      // Pre volitelny I/O engine io_uring
+#include "task_pool.h"    // Pre spolocnu skupinu vlakien
+
+// Jeden blok v kruhovom zasobniku (sifruje a desifruje sa na mieste)
+typedef struct
+{
+    uint8_t *data;         // Data bloku, otvoreny text alebo zasifrovane data
+    uint8_t *mapped;       // Otvoreny text v namapovanom subore - sifruje sa z neho, desifruje do neho (NULL = text je v data)
+    uint8_t tag[TAG_SIZE]; // Autentizacny tag bloku
+    size_t size;           // Pocet bajtov v bloku
+    uint32_t epoch;        // Epocha kluca bloku
+    uint64_t sequence;     // Poradove cislo bloku v epoche (urcuje nonce)
+    int ready;             // 1 ak pracovnik blok spracoval (zasifroval alebo overil a desifroval)
+    int auth_failed;       // 1 ak blok neprejde overenim tagu (iba pri prijimani)
+    task_t task;           // Uloha pre skupinu vlakien (iba pri prijimani riadenom udalostami)
+} pipeline_slot_t;
+
+// Retazec blokov: vstup -> spracovanie (N vlakien) -> vystup v poradi
+// Buffery sa alokuju raz a pouziju pre vsetky kluce relacie
+typedef struct
+{
+    pipeline_slot_t *slots; // Kruhovy zasobnik blokov
+    unsigned nb_slots;      // Pocet blokov v zasobniku
+    unsigned nb_workers;    // Pocet vlakien pre sifrovanie alebo desifrovanie
+    uint32_t frame_size;    // Dohodnuta velkost bloku
+    io_ring_t net_ring;     // io_uring pre socket (vlakno volajuceho), fd -1 = blokujuce volania
+    io_ring_t file_ring;    // io_uring pre subor s registrovanymi buffermi blokov, fd -1 = stdio
+
+    // Vysledok posledneho behu retazca
+    uint64_t frames; // Pocet odoslanych alebo zapisanych blokov
+    uint64_t bytes;  // Pocet odoslanych alebo zapisanych bajtov (otvoreny text)
+} pipeline_t;
+
+// Funkcia volana po odoslani alebo zapise kazdeho bloku (napr. pre zobrazenie progresu)
+typedef void (*pipeline_progress_fn)(void *arg, size_t bytes);
+
+// Casti prudu pri prijimani riadenom udalostami
+#define PIPELINE_PART_HEADER 0 // Hlavicka bloku
+#define PIPELINE_PART_WAIT 1   // Hlavicka prisla, blok caka na volne miesto alebo na koniec predposlednej epochy
+#define PIPELINE_PART_TAG 2    // Autentizacny tag bloku
+#define PIPELINE_PART_DATA 3   // Zasifrovane data bloku
+#define PIPELINE_PART_END 4    // Prisiel koniec suboru
+
+// Spolocny stav jedneho behu retazca
+// Vsetky pocitadla su chranene zamkom lock:
+//   drained <= claimed <= filled <= drained + nb_slots
+// Blok s poradim i je vzdy v mieste i % nb_slots
+typedef struct
+{
+    pipeline_t *pipeline;
+    int socket;                      // Odosielanie: socket pre zasifrovane bloky
+    FILE *file;
+    const platform_file_map_t *map;  // Namapovany subor (NULL = citanie cez fread alebo zapis cez fwrite)
+    platform_file_map_t file_map;    // Prijimanie: namapovany vystupny subor (map ukazuje nan)
+    uint64_t file_size;              // Prijimanie: ohlasena velkost suboru (FILE_SIZE_UNKNOWN = neznama)
+    uint64_t map_offset;             // Poloha dalsieho bloku v namapovanom subore (meni iba zdroj)
+    key_ratchet_t *keys;             // Kluce epoch relacie
+    const rotation_policy_t *policy; // Dohodnute pravidla rotacie kluca
+    pipeline_progress_fn progress;
+    void *progress_arg;
+
+    // Prudy dvoch poslednych epoch - na prelome epoch pracovnici naraz spracuvaju
+    // bloky konca jednej a zaciatku dalsej, prud epochy e je v epochs[e % 2]
+    const aead_ctx_t *epochs[2];
+    uint64_t epoch_start[2];   // Poradie prveho bloku epochy v epochs[i]
+    uint32_t epoch;            // Epocha, do ktorej zdroj prave plni bloky (meni iba zdroj)
+    uint64_t sequence;         // Poradove cislo dalsieho bloku v epoche (meni iba zdroj)
+    uint64_t epoch_bytes;      // Pocet bajtov v blokoch epochy (meni iba zdroj)
+    uint64_t epoch_started_ms; // Cas zaciatku epochy (meni iba zdroj)
+
+    platform_mutex_t lock;
+    platform_cond_t slot_free;    // Ciel uvolnil miesto (caka zdroj)
+    platform_cond_t frame_filled; // Zdroj pridal blok (cakaju pracovnici)
+    platform_cond_t frame_ready;  // Pracovnik spracoval blok (caka ciel)
+
+    uint64_t filled;  // Pocet blokov, ktore zdroj vlozil do zasobnika
+    uint64_t claimed; // Pocet blokov, ktore si vzali pracovnici
+    uint64_t drained; // Pocet blokov, ktore ciel spracoval a uvolnil
+    int filling_done; // Zdroj skoncil (koniec suboru alebo chyba)
+    int failed;       // Niektora cast zlyhala, vsetky vlakna koncia
+
+    // Prijimanie riadene udalostami (pipeline_stream_*): zdroj a ciel vola reaktor,
+    // bloky desifruju ulohy v spolocnej skupine vlakien
+    task_pool_t *pool;                 // Skupina vlakien pre desifrovanie
+    void (*notify)(void *arg);         // Volane so zamknutym lock po spracovani kazdeho bloku
+    void *notify_arg;                  // Argument funkcie notify
+    unsigned in_flight;                // Pocet zaradenych uloh, ktore este neskoncili
+    task_t write_task;                 // Uloha, ktora zapisuje spracovane bloky v poradi cez fwrite (bez mapovania)
+    int writing;                       // 1 kym je uloha zapisu zaradena alebo bezi
+    int write_failed;                  // 1 ak zapis bloku do suboru zlyhal
+    int part;                          // Cast prudu, ktora sa prave prijima (PIPELINE_PART_*)
+    size_t part_received;              // Pocet uz prijatych bajtov tejto casti
+    uint8_t header[FRAME_HEADER_SIZE]; // Prijimana hlavicka bloku
+    uint32_t frame_bytes;              // Velkost dat prijimaneho bloku
+    int next_epoch;                    // 1 ak prijimany blok zacina dalsiu epochu
+} pipeline_run_t;
+
+
+unsigned pipeline_worker_count(void); // Pocet vlakien pre sifrovanie podla poctu procesorov
+
+int pipeline_init(pipeline_t *pipeline, uint32_t frame_size, unsigned workers); // Alokuje buffery
+void pipeline_free(pipeline_t *pipeline);                                       // Vymaze a uvolni buffery
+int pipeline_use_io_ring(pipeline_t *pipeline);                                 // Prepne socket aj subor na io_uring, -1 ak nie je dostupny
+
+int pipeline_send(pipeline_t *pipeline, int socket, FILE *file, // Zasifruje a posle cely subor, kluc meni podla pravidiel rotacie
+                  key_ratchet_t *keys, const rotation_policy_t *policy,
+                  pipeline_progress_fn progress, void *progress_arg);
+
+// Prijimanie riadene udalostami - vsetky funkcie okrem notify vola jedno vlakno (reaktor)
+// pipeline_stream_begin moze bezat aj vo vlakne skupiny (vyhradenie miesta pre subor pise na disk),
+// reaktor vsak beh nepouzije skor, nez skonci
+void pipeline_stream_begin(pipeline_run_t *run, pipeline_t *pipeline, task_pool_t *pool, // Zacne prijimanie do suboru
+                           FILE *file, uint64_t file_size, key_ratchet_t *keys,
+                           const rotation_policy_t *policy, void (*notify)(void *arg), void *notify_arg);
+uint8_t *pipeline_stream_buffer(pipeline_run_t *run, size_t *size); // Kam prijat dalsie bajty, NULL ak sa ma cakat
+int pipeline_stream_received(pipeline_run_t *run, size_t size);     // Spracuje prijate bajty, -1 pri chybe
+int pipeline_stream_feed(pipeline_run_t *run, const uint8_t *data,  // Rozdeli bajty z ineho buffera do blokov
+                         size_t size, size_t *used);                // (used = kolko prud prijal), -1 pri chybe
+int pipeline_stream_drain(pipeline_run_t *run);                     // Zapise spracovane bloky v poradi, -1 pri chybe
+int pipeline_stream_done(pipeline_run_t *run);                      // 1 ak su zapisane vsetky bloky az po koniec suboru
+int pipeline_stream_busy(pipeline_run_t *run);                      // 1 ak ulohy este spracuvaju bloky
+int pipeline_stream_end(pipeline_run_t *run, int result);           // Ukonci prijimanie, vysledok po kontrole velkosti
+
+#endif // PIPELINE_H
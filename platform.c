@@ -9,6 +9,9 @@
  *     Implementacia platformovo-nezavislych operacii:
  *     - Generovanie kryptograficky bezpecnych nahodnych cisel
  *     - Bezpecne nacitanie hesla od uzivatela
+ *     - Vytvaranie a synchronizacia vlakien, zistenie poctu procesorov
+ *     - Mapovanie suborov do pamate s radou pre postupne citanie alebo zapis
+ *     - Cakanie na udalosti socketov (epoll, WSAPoll) a zobudzac tohto cakania
  *
  * Zavislosti:
  *     - platform.h (deklaracie funkcii)
@@ -23,6 +26,12 @@
 #include "platform.h"
 #include "constants.h"
 
+#ifdef _WIN32
+#include <io.h>       // Pre _get_osfhandle (handle suboru z FILE) a _open
+#include <fcntl.h>    // Pre priznaky _open
+#include <sys/stat.h> // Pre prava noveho suboru
+#endif
+
 // Bezpecnostne funkcie
 // Generovanie kryptograficky bezpecnych nahodnych cisel
 // Pouziva systemove generatory (BCrypt na Windows, getrandom na Linuxe)
@@ -146,3 +155,802 @@ char *platform_getpass(const char *prompt)
 
     return password; // Vratenie ukazovatela na heslo
 }
+
+// Spustacia funkcia vlakna
+// Vola funkciu ulozenu v strukture vlakna s jej argumentom
+#ifdef _WIN32
+static DWORD WINAPI platform_thread_start(LPVOID param)
+{
+    platform_thread_t *thread = (platform_thread_t *)param;
+    thread->fn(thread->arg);
+    return 0;
+}
+#else
+static void *platform_thread_start(void *param)
+{
+    platform_thread_t *thread = (platform_thread_t *)param;
+    thread->fn(thread->arg);
+    return NULL;
+}
+#endif
+
+// Spustenie funkcie v novom vlakne
+// Struktura vlakna musi existovat az do volania platform_thread_join
+// Navratova hodnota:
+//   - 0 pri uspechu, -1 ak sa vlakno nepodarilo vytvorit
+int platform_thread_create(platform_thread_t *thread, void (*fn)(void *arg), void *arg)
+{
+    thread->fn = fn;
+    thread->arg = arg;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, platform_thread_start, thread, 0, NULL);
+    return (thread->handle != NULL) ? 0 : -1;
+#else
+    return (pthread_create(&thread->handle, NULL, platform_thread_start, thread) == 0) ? 0 : -1;
+#endif
+}
+
+// Cakanie na ukoncenie vlakna a uvolnenie jeho prostriedkov
+void platform_thread_join(platform_thread_t *thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+// Zistenie poctu procesorov dostupnych pre program
+// Pri chybe vrati 1, aby volajuci mohol pokracovat bez paralelizmu
+unsigned platform_cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (unsigned)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (unsigned)count : 1;
+#endif
+}
+
+// Monotonny cas v milisekundach (nezavisly od zmeny systemoveho casu)
+// Pouziva sa iba na meranie intervalov, nie na urcenie aktualneho casu
+uint64_t platform_time_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+#endif
+}
+
+// Synchronizacia vlakien
+// Na Windows CRITICAL_SECTION a CONDITION_VARIABLE, na Linuxe pthreads
+void platform_mutex_init(platform_mutex_t *mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void platform_mutex_destroy(platform_mutex_t *mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void platform_mutex_lock(platform_mutex_t *mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void platform_mutex_unlock(platform_mutex_t *mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void platform_cond_init(platform_cond_t *cond)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+}
+
+// Podmienkova premenna na Windows nepotrebuje uvolnenie
+void platform_cond_destroy(platform_cond_t *cond)
+{
+#ifdef _WIN32
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+// Mutex musi byt zamknuty, po navrate je opat zamknuty
+// Zobudenie moze byt aj falosne, volajuci preto vzdy znova overi podmienku
+void platform_cond_wait(platform_cond_t *cond, platform_mutex_t *mutex)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+void platform_cond_signal(platform_cond_t *cond)
+{
+#ifdef _WIN32
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+void platform_cond_broadcast(platform_cond_t *cond)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+// Mapovanie suborov
+// Velkost obycajneho suboru - pre rury, zariadenia a pri chybe vrati -1
+int platform_file_size(FILE *file, uint64_t *size)
+{
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    LARGE_INTEGER info;
+    if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK ||
+        !GetFileSizeEx(handle, &info) || info.QuadPart < 0)
+    {
+        return -1;
+    }
+    *size = (uint64_t)info.QuadPart;
+#else
+    struct stat info;
+    if (fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode) || info.st_size < 0)
+    {
+        return -1;
+    }
+    *size = (uint64_t)info.st_size;
+#endif
+    return 0;
+}
+
+// Spolocna cast mapovania na citanie aj zapis - subor uz ma velkost size
+static int platform_file_map_region(platform_file_map_t *map, FILE *file, uint64_t size, int writable)
+{
+    memset(map, 0, sizeof(*map));
+    if (size == 0 || size > SIZE_MAX)
+    {
+        return -1;
+    }
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    map->mapping = CreateFileMappingA(handle, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    if (map->mapping == NULL)
+    {
+        return -1;
+    }
+    map->data = (uint8_t *)MapViewOfFile(map->mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (map->data == NULL)
+    {
+        CloseHandle(map->mapping);
+        map->mapping = NULL;
+        return -1;
+    }
+#else
+    int fd = fileno(file);
+    void *data = mmap(NULL, (size_t)size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        return -1;
+    }
+    // Subor sa spracuje od zaciatku po koniec: vacsie citanie vopred a spracovane stranky sa mozu hned uvolnit
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    madvise(data, (size_t)size, MADV_SEQUENTIAL);
+    map->data = (uint8_t *)data;
+#endif
+    map->size = size;
+    return 0;
+}
+
+// Namapuje cely otvoreny subor na citanie, aby sa dal sifrovat priamo zo stranok suboru
+// bez kopirovania cez buffer stdio. Ide iba o obycajne neprazdne subory - pre rury,
+// zariadenia a prazdne subory vrati -1 a volajuci pouzije fread
+// Subor sa pocas mapovania nesmie skratit (pristup za novy koniec by program ukoncil)
+int platform_file_map(platform_file_map_t *map, FILE *file)
+{
+    uint64_t size;
+    if (platform_file_size(file, &size) != 0)
+    {
+        memset(map, 0, sizeof(*map));
+        return -1;
+    }
+    return platform_file_map_region(map, file, size, 0);
+}
+
+// Vyhradi na disku miesto pre cely subor naraz (suvisly priestor namiesto postupneho
+// rastu po blokoch) a namapuje ho na zapis - desifrovane data sa zapisu priamo do stranok suboru
+// Subor musi byt otvoreny na citanie aj zapis, pri chybe vrati -1 a volajuci pouzije fwrite
+// Bez vyhradeneho miesta sa subor nemapuje - zapis do stranky, pre ktoru na disku nie je miesto,
+// by proces ukoncil (SIGBUS), fwrite chybu iba vrati
+int platform_file_map_output(platform_file_map_t *map, FILE *file, uint64_t size)
+{
+    memset(map, 0, sizeof(*map));
+    if (size == 0 || size > SIZE_MAX || size > INT64_MAX)
+    {
+        return -1;
+    }
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)size;
+    LARGE_INTEGER start;
+    start.QuadPart = 0;
+    if (handle == INVALID_HANDLE_VALUE || !SetFilePointerEx(handle, end, NULL, FILE_BEGIN) || !SetEndOfFile(handle) ||
+        !SetFilePointerEx(handle, start, NULL, FILE_BEGIN))
+    {
+        return -1;
+    }
+#else
+    // glibc vyhradenie napodobni aj na systemoch suborov bez fallocate, chyba je teda
+    // takmer vzdy nedostatok miesta (ENOSPC) alebo prilis velky subor (EFBIG)
+    if (posix_fallocate(fileno(file), 0, (off_t)size) != 0)
+    {
+        return -1;
+    }
+#endif
+    return platform_file_map_region(map, file, size, 1);
+}
+
+// Rada systemu, ze cast suboru bude coskoro potrebna (nacita ju na pozadi)
+// Iba rada - chyba sa ignoruje, pri citani sa stranky nacitaju aj bez nej
+void platform_file_map_prefetch(const platform_file_map_t *map, uint64_t offset, uint64_t size)
+{
+    if (offset >= map->size)
+    {
+        return;
+    }
+    if (size > map->size - offset)
+    {
+        size = map->size - offset;
+    }
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = (PVOID)(map->data + offset);
+    range.NumberOfBytes = (SIZE_T)size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    // madvise vyzaduje adresu zarovnanu na stranku
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)(map->data + offset) & ~(page - 1);
+    uintptr_t end = (uintptr_t)(map->data + offset + size);
+    madvise((void *)start, (size_t)(end - start), MADV_WILLNEED);
+#endif
+}
+
+// Zapisane stranky system ulozi do suboru sam, rovnako ako data po fclose
+void platform_file_unmap(platform_file_map_t *map)
+{
+    if (map->data != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(map->data);
+        CloseHandle(map->mapping);
+#else
+        munmap(map->data, (size_t)map->size);
+#endif
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+// Skrati subor na danu velkost (napr. po neuplnom prenose do vopred vyhradeneho suboru)
+// Subor nesmie byt namapovany
+int platform_file_truncate(FILE *file, uint64_t size)
+{
+    fflush(file);
+#ifdef _WIN32
+    return (_chsize_s(_fileno(file), (__int64)size) == 0) ? 0 : -1;
+#else
+    return (ftruncate(fileno(file), (off_t)size) == 0) ? 0 : -1;
+#endif
+}
+
+// Vytvorenie noveho suboru na zapis, ktory moze citat a zapisovat iba vlastnik
+// Existujuci subor (aj symbolicky odkaz) sa neotvori - volanie vtedy zlyha
+FILE *platform_file_create_private(const char *path)
+{
+#ifdef _WIN32
+    int fd = _open(path, _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    FILE *file = _fdopen(fd, "wb");
+    if (file == NULL)
+    {
+        _close(fd);
+    }
+#else
+    int fd = open(path, O_CREAT | O_EXCL | O_WRONLY, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    FILE *file = fdopen(fd, "wb");
+    if (file == NULL)
+    {
+        close(fd);
+    }
+#endif
+    return file;
+}
+
+// Premenovanie suboru - existujuci subor s novym nazvom sa nahradi (ak ho ma niekto otvoreny
+// alebo namapovany, na Linuxe mu ostanu povodne data, Windows nahradenie odmietne)
+int platform_file_replace(const char *from, const char *to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return (rename(from, to) == 0) ? 0 : -1;
+#endif
+}
+
+// Volne miesto na disku, na ktorom je subor (pre beznych pouzivatelov, bez rezervy pre root)
+// Na Windows disk aktualneho adresara - prijate subory sa vytvaraju v nom
+int platform_file_space(FILE *file, uint64_t *available)
+{
+#ifdef _WIN32
+    (void)file;
+    ULARGE_INTEGER free_bytes;
+    if (!GetDiskFreeSpaceExA(NULL, &free_bytes, NULL, NULL))
+    {
+        return -1;
+    }
+    *available = (uint64_t)free_bytes.QuadPart;
+#else
+    struct statvfs info;
+    if (fstatvfs(fileno(file), &info) != 0)
+    {
+        return -1;
+    }
+    *available = (uint64_t)info.f_bavail * info.f_frsize;
+#endif
+    return 0;
+}
+
+// Je subor pristupny iba vlastnikovi? (ziadne prava pre skupinu ani ostatnych)
+// Na Windows sa ACL nekontroluju - subor sa povazuje za sukromny
+int platform_file_private(FILE *file)
+{
+#ifdef _WIN32
+    (void)file;
+    return 1;
+#else
+    struct stat info;
+    return fstat(fileno(file), &info) == 0 && (info.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+#endif
+}
+
+// Velka pracovna pamat
+// Pamat sa namapuje so vsetkymi strankami naraz, aby ich volajuci nedostaval postupne pri prvom
+// zapise (vypadok stranky na kazde 4 KB). Velke stranky navyse setria zaznamy v TLB
+// Poradie pokusov: vyhradene velke stranky, transparentne velke stranky, bezne stranky
+
+// Na Linuxe: vyhradene velke stranky (hugetlbfs) alebo oblast zarovnana na velku stranku s radou pre THP
+// Na Windows: large pages (vyzaduju pravo SeLockMemoryPrivilege) alebo bezna pamat
+void *platform_large_alloc(size_t size, int *pages)
+{
+#ifdef _WIN32
+    SIZE_T large = GetLargePageMinimum();
+    if (large != 0 && size % large == 0)
+    {
+        void *data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (data != NULL)
+        {
+            *pages = PLATFORM_PAGES_HUGE;
+            return data;
+        }
+    }
+    void *data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    *pages = PLATFORM_PAGES_NORMAL;
+    memset(data, 0, size); // Pridelenie vsetkych stranok vopred
+    return data;
+#else
+#if defined(MAP_HUGETLB) && defined(MAP_POPULATE)
+    void *huge = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,
+                      -1, 0);
+    if (huge != MAP_FAILED)
+    {
+        *pages = PLATFORM_PAGES_HUGE;
+        return huge;
+    }
+#endif
+    // Oblast sa zarovna na velku stranku, aby ju jadro mohlo cele pokryt transparentnymi velkymi strankami
+    size_t align = PLATFORM_HUGE_PAGE_SIZE;
+    uint8_t *raw = mmap(NULL, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+    uint8_t *data = (uint8_t *)(((uintptr_t)raw + align - 1) & ~(uintptr_t)(align - 1));
+    if (data > raw)
+    {
+        munmap(raw, (size_t)(data - raw));
+    }
+    if (raw + size + align > data + size)
+    {
+        munmap(data + size, (size_t)(raw + size + align - (data + size)));
+    }
+
+    *pages = PLATFORM_PAGES_NORMAL;
+#ifdef MADV_HUGEPAGE
+    if (madvise(data, size, MADV_HUGEPAGE) == 0)
+    {
+        *pages = PLATFORM_PAGES_TRANSPARENT;
+    }
+#endif
+    // Pridelenie vsetkych stranok vopred (MADV_POPULATE_WRITE od Linuxu 5.14, inak zapisom)
+    int populated = 0;
+#ifdef MADV_POPULATE_WRITE
+    populated = (madvise(data, size, MADV_POPULATE_WRITE) == 0);
+#endif
+    if (!populated)
+    {
+        memset(data, 0, size);
+    }
+    return data;
+#endif
+}
+
+// Zrusenie pamate z platform_large_alloc (size musi byt rovnaka ako pri alokovani)
+void platform_large_free(void *data, size_t size)
+{
+    if (data == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, size);
+#endif
+}
+
+// Nazov druhu stranok pre vypisy
+const char *platform_pages_name(int pages)
+{
+    switch (pages)
+    {
+    case PLATFORM_PAGES_HUGE:
+        return "huge pages";
+    case PLATFORM_PAGES_TRANSPARENT:
+        return "transparent huge pages";
+    default:
+        return "regular pages";
+    }
+}
+
+// Cakanie na udalosti socketov
+// Na Linuxe epoll (cena cakania nezavisi od poctu spojeni), na Windows WSAPoll nad polom socketov
+
+// Prevod udalosti volajuceho na udalosti systemu
+#ifdef _WIN32
+static SHORT platform_poll_events(unsigned events)
+{
+    return (SHORT)(((events & PLATFORM_POLL_IN) ? POLLRDNORM : 0) | ((events & PLATFORM_POLL_OUT) ? POLLWRNORM : 0));
+}
+#else
+static uint32_t platform_poll_events(unsigned events)
+{
+    return ((events & PLATFORM_POLL_IN) ? EPOLLIN | EPOLLRDHUP : 0) | ((events & PLATFORM_POLL_OUT) ? EPOLLOUT : 0);
+}
+#endif
+
+// Vytvorenie prazdnej mnoziny sledovanych socketov
+int platform_poller_init(platform_poller_t *poller)
+{
+    memset(poller, 0, sizeof(*poller));
+#ifdef _WIN32
+    return 0;
+#else
+    poller->fd = epoll_create1(EPOLL_CLOEXEC);
+    return (poller->fd >= 0) ? 0 : -1;
+#endif
+}
+
+// Uvolnenie mnoziny - sockety v nej ostanu otvorene
+void platform_poller_free(platform_poller_t *poller)
+{
+#ifdef _WIN32
+    free(poller->fds);
+    free(poller->data);
+#else
+    if (poller->fd >= 0)
+    {
+        close(poller->fd);
+    }
+#endif
+    memset(poller, 0, sizeof(*poller));
+}
+
+#ifdef _WIN32
+// Poloha socketu v poli sledovanych socketov, -1 ak sa nesleduje
+static int platform_poller_find(const platform_poller_t *poller, int sock)
+{
+    for (unsigned i = 0; i < poller->count; i++)
+    {
+        if (poller->fds[i].fd == (SOCKET)sock)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+#endif
+
+// Pridanie socketu - data sa vratia s kazdou jeho udalostou
+int platform_poller_add(platform_poller_t *poller, int sock, unsigned events, void *data)
+{
+#ifdef _WIN32
+    if (poller->count == poller->capacity)
+    {
+        unsigned capacity = (poller->capacity == 0) ? 64 : poller->capacity * 2;
+        WSAPOLLFD *fds = realloc(poller->fds, capacity * sizeof(*fds));
+        if (fds == NULL)
+        {
+            return -1;
+        }
+        poller->fds = fds;
+        void **slots = realloc(poller->data, capacity * sizeof(*slots));
+        if (slots == NULL)
+        {
+            return -1;
+        }
+        poller->data = slots;
+        poller->capacity = capacity;
+    }
+    poller->fds[poller->count].fd = (SOCKET)sock;
+    poller->fds[poller->count].events = platform_poll_events(events);
+    poller->fds[poller->count].revents = 0;
+    poller->data[poller->count] = data;
+    poller->count++;
+    return 0;
+#else
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = platform_poll_events(events);
+    event.data.ptr = data;
+    return (epoll_ctl(poller->fd, EPOLL_CTL_ADD, sock, &event) == 0) ? 0 : -1;
+#endif
+}
+
+// Zmena sledovanych udalosti uz pridaneho socketu
+int platform_poller_modify(platform_poller_t *poller, int sock, unsigned events, void *data)
+{
+#ifdef _WIN32
+    int index = platform_poller_find(poller, sock);
+    if (index < 0)
+    {
+        return -1;
+    }
+    poller->fds[index].events = platform_poll_events(events);
+    poller->data[index] = data;
+    return 0;
+#else
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = platform_poll_events(events);
+    event.data.ptr = data;
+    return (epoll_ctl(poller->fd, EPOLL_CTL_MOD, sock, &event) == 0) ? 0 : -1;
+#endif
+}
+
+// Odobratie socketu - musi sa zavolat pred jeho zatvorenim
+void platform_poller_remove(platform_poller_t *poller, int sock)
+{
+#ifdef _WIN32
+    int index = platform_poller_find(poller, sock);
+    if (index >= 0)
+    {
+        poller->count--;
+        poller->fds[index] = poller->fds[poller->count];
+        poller->data[index] = poller->data[poller->count];
+    }
+#else
+    epoll_ctl(poller->fd, EPOLL_CTL_DEL, sock, NULL);
+#endif
+}
+
+// Cakanie na udalosti najviac timeout_ms milisekund
+// Navratova hodnota: pocet udalosti v events (0 po uplynuti casu alebo preruseni signalom), -1 pri chybe
+int platform_poller_wait(platform_poller_t *poller, platform_poll_event_t *events, int max_events, int timeout_ms)
+{
+#ifdef _WIN32
+    int ready = WSAPoll(poller->fds, poller->count, timeout_ms);
+    if (ready < 0)
+    {
+        return -1;
+    }
+    int count = 0;
+    for (unsigned i = 0; i < poller->count && count < max_events; i++)
+    {
+        SHORT revents = poller->fds[i].revents;
+        if (revents == 0)
+        {
+            continue;
+        }
+        events[count].data = poller->data[i];
+        events[count].events = 0;
+        if (revents & (POLLRDNORM | POLLERR | POLLHUP))
+        {
+            events[count].events |= PLATFORM_POLL_IN;
+        }
+        if (revents & (POLLWRNORM | POLLERR | POLLHUP))
+        {
+            events[count].events |= PLATFORM_POLL_OUT;
+        }
+        count++;
+    }
+    return count;
+#else
+    struct epoll_event ready[PLATFORM_POLL_MAX_EVENTS];
+    if (max_events > PLATFORM_POLL_MAX_EVENTS)
+    {
+        max_events = PLATFORM_POLL_MAX_EVENTS;
+    }
+    int count = epoll_wait(poller->fd, ready, max_events, timeout_ms);
+    if (count < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        events[i].data = ready[i].data.ptr;
+        events[i].events = 0;
+        if (ready[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP))
+        {
+            events[i].events |= PLATFORM_POLL_IN;
+        }
+        if (ready[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+        {
+            events[i].events |= PLATFORM_POLL_OUT;
+        }
+    }
+    return count;
+#endif
+}
+
+// Zobudzac pre cakanie na udalosti
+// Signal z ineho vlakna spravi socket citatelnym, kym ho vlakno s cakanim nezrusi
+
+// Vytvorenie zobudzaca
+// Windows nema eventfd - pouzije sa dvojica spojenych socketov na 127.0.0.1
+int platform_notifier_init(platform_notifier_t *notifier)
+{
+#ifdef _WIN32
+    notifier->read_end = INVALID_SOCKET;
+    notifier->write_end = INVALID_SOCKET;
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET)
+    {
+        return -1;
+    }
+    struct sockaddr_in address;
+    int address_len = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0; // Volny port pridelany systemom
+    int ok = bind(listener, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+             listen(listener, 1) == 0 &&
+             getsockname(listener, (struct sockaddr *)&address, &address_len) == 0 &&
+             (notifier->write_end = socket(AF_INET, SOCK_STREAM, 0)) != INVALID_SOCKET &&
+             connect(notifier->write_end, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+             (notifier->read_end = accept(listener, NULL, NULL)) != INVALID_SOCKET;
+    closesocket(listener);
+    u_long nonblocking = 1;
+    if (!ok || ioctlsocket(notifier->read_end, FIONBIO, &nonblocking) != 0 ||
+        ioctlsocket(notifier->write_end, FIONBIO, &nonblocking) != 0)
+    {
+        platform_notifier_free(notifier);
+        return -1;
+    }
+    return 0;
+#else
+    notifier->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return (notifier->fd >= 0) ? 0 : -1;
+#endif
+}
+
+// Zatvorenie zobudzaca
+void platform_notifier_free(platform_notifier_t *notifier)
+{
+#ifdef _WIN32
+    if (notifier->read_end != INVALID_SOCKET)
+    {
+        closesocket(notifier->read_end);
+    }
+    if (notifier->write_end != INVALID_SOCKET)
+    {
+        closesocket(notifier->write_end);
+    }
+    notifier->read_end = INVALID_SOCKET;
+    notifier->write_end = INVALID_SOCKET;
+#else
+    if (notifier->fd >= 0)
+    {
+        close(notifier->fd);
+    }
+    notifier->fd = -1;
+#endif
+}
+
+// Socket, ktory sa pri signale stane citatelnym
+int platform_notifier_socket(platform_notifier_t *notifier)
+{
+#ifdef _WIN32
+    return (int)notifier->read_end;
+#else
+    return notifier->fd;
+#endif
+}
+
+// Zobudenie cakania - viac signalov pred spracovanim sa zluci do jedneho
+void platform_notifier_signal(platform_notifier_t *notifier)
+{
+#ifdef _WIN32
+    char byte = 1;
+    send(notifier->write_end, &byte, 1, 0); // Plny buffer znamena, ze zobudenie uz caka
+#else
+    uint64_t one = 1;
+    ssize_t written = write(notifier->fd, &one, sizeof(one));
+    (void)written; // Preplnenie pocitadla znamena, ze zobudenie uz caka
+#endif
+}
+
+// Zrusenie zobudenia - volajuci potom spracuje vsetko, co sa medzitym stalo
+void platform_notifier_clear(platform_notifier_t *notifier)
+{
+#ifdef _WIN32
+    char buffer[64];
+    while (recv(notifier->read_end, buffer, sizeof(buffer), 0) > 0)
+    {
+    }
+#else
+    uint64_t count;
+    ssize_t result = read(notifier->fd, &count, sizeof(count));
+    (void)result; // EAGAIN znamena, ze zobudenie uz bolo zrusene
+#endif
+}
@@ -9,6 +9,10 @@
  *     Hlavickovy subor pre platformovo-nezavisle operacie:
  *     - Funkcie pre bezpecne generovanie nahodnych cisel
  *     - Platformovo nezavisle bezpecne nacitanie hesla
+ *     - Vlakna, ich synchronizacia (mutex, podmienkova premenna) a zistenie poctu procesorov
+ *     - Mapovanie suboru do pamate na citanie alebo zapis (bez kopirovania cez stdio)
+ *     - Cakanie na udalosti mnohych socketov naraz (epoll, na Windows WSAPoll)
+ *       a zobudenie tohto cakania z ineho vlakna
  *
  * Zavislosti:
  *     - Standardne C kniznice
@@ -20,9 +24,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 // Platformovo-specificke include subory
 #ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600 // WSAPoll je dostupny od Windows Vista
+#endif
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <windows.h>
@@ -39,22 +47,151 @@ typedef int socklen_t;
 #else
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/random.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 // Typy
 typedef int socket_t;
 #define INVALID_SOCKET_VALUE -1
 #endif
 
+// Vlakno s platformovo nezavislym rozhranim
+// Funkcia a jej argument su ulozene vo vlakne, aby ich mohla prevziat
+// spustacia funkcia (Win32 aj pthreads ocakavaju iny typ funkcie)
+typedef struct
+{
+#ifdef _WIN32
+    HANDLE handle; // Handle vlakna na Windows
+#else
+    pthread_t handle; // Identifikator vlakna na Linuxe
+#endif
+    void (*fn)(void *arg); // Funkcia vykonana vo vlakne
+    void *arg;             // Argument funkcie
+} platform_thread_t;
+
+// Mutex a podmienkova premenna pre synchronizaciu vlakien
+#ifdef _WIN32
+typedef CRITICAL_SECTION platform_mutex_t;  // Mutex na Windows
+typedef CONDITION_VARIABLE platform_cond_t; // Podmienkova premenna na Windows
+#else
+typedef pthread_mutex_t platform_mutex_t; // Mutex na Linuxe
+typedef pthread_cond_t platform_cond_t;   // Podmienkova premenna na Linuxe
+#endif
+
+// Subor namapovany do pamate na citanie alebo zapis
+typedef struct
+{
+    uint8_t *data; // Obsah suboru (pri mapovani na citanie sa nesmie menit)
+    uint64_t size; // Velkost suboru v bajtoch (pri mapovani)
+#ifdef _WIN32
+    HANDLE mapping; // Handle mapovania na Windows
+#endif
+} platform_file_map_t;
+
+// Druh stranok velkej pracovnej pamate (platform_large_alloc)
+#define PLATFORM_PAGES_NORMAL 0            // Bezne stranky (4 KB)
+#define PLATFORM_PAGES_TRANSPARENT 1       // Transparentne velke stranky (jadro ich prideli, ak moze)
+#define PLATFORM_PAGES_HUGE 2              // Vyhradene velke stranky (MAP_HUGETLB, na Windows large pages)
+#define PLATFORM_HUGE_PAGE_SIZE (2u << 20) // Velkost velkej stranky (zarovnanie pre THP)
+
+// Cakanie na udalosti socketov - jedno vlakno sleduje lubovolny pocet spojeni
+#define PLATFORM_POLL_IN 0x1        // Socket ma data na citanie (alebo spojenie skoncilo)
+#define PLATFORM_POLL_OUT 0x2       // Do socketu sa da zapisovat
+#define PLATFORM_POLL_MAX_EVENTS 64 // Najviac udalosti vratenych jednym cakanim
+
+typedef struct
+{
+#ifdef _WIN32
+    WSAPOLLFD *fds;    // Sledovane sockety a ich udalosti
+    void **data;       // Udaje volajuceho ku kazdemu socketu
+    unsigned count;    // Pocet sledovanych socketov
+    unsigned capacity; // Velkost poli fds a data
+#else
+    int fd; // Deskriptor epoll
+#endif
+} platform_poller_t;
+
+// Udalost socketu - chyba spojenia sa hlasi ako citanie aj zapis, zisti ju az recv alebo send
+typedef struct
+{
+    void *data;      // Udaje volajuceho zadane pri pridani socketu
+    unsigned events; // PLATFORM_POLL_IN a/alebo PLATFORM_POLL_OUT
+} platform_poll_event_t;
+
+// Zobudenie cakania na udalosti z ineho vlakna (eventfd, na Windows dvojica socketov)
+typedef struct
+{
+#ifdef _WIN32
+    SOCKET read_end;  // Koniec sledovany cakanim na udalosti
+    SOCKET write_end; // Koniec, do ktoreho pise zobudzajuce vlakno
+#else
+    int fd; // Deskriptor eventfd
+#endif
+} platform_notifier_t;
+
 // Bezpecnostne funkcie
 int platform_generate_random_bytes(uint8_t *buffer, size_t size);
 char *platform_getpass(const char *prompt);
 
+// Funkcie pre vlakna a meranie casu
+int platform_thread_create(platform_thread_t *thread, void (*fn)(void *arg), void *arg); // Spusti funkciu v novom vlakne
+void platform_thread_join(platform_thread_t *thread);                                   // Pocka na ukoncenie vlakna
+unsigned platform_cpu_count(void);                                                      // Pocet dostupnych procesorov
+uint64_t platform_time_ms(void);                                                        // Monotonny cas v milisekundach
+
+// Funkcie pre synchronizaciu vlakien
+void platform_mutex_init(platform_mutex_t *mutex);                       // Inicializuje mutex
+void platform_mutex_destroy(platform_mutex_t *mutex);                    // Uvolni mutex
+void platform_mutex_lock(platform_mutex_t *mutex);                       // Zamkne mutex
+void platform_mutex_unlock(platform_mutex_t *mutex);                     // Odomkne mutex
+void platform_cond_init(platform_cond_t *cond);                          // Inicializuje podmienkovu premennu
+void platform_cond_destroy(platform_cond_t *cond);                       // Uvolni podmienkovu premennu
+void platform_cond_wait(platform_cond_t *cond, platform_mutex_t *mutex); // Odomkne mutex a caka na signal
+void platform_cond_signal(platform_cond_t *cond);                        // Zobudi jedno cakajuce vlakno
+void platform_cond_broadcast(platform_cond_t *cond);                     // Zobudi vsetky cakajuce vlakna
+
+// Funkcie pre mapovanie suborov
+int platform_file_size(FILE *file, uint64_t *size);                                              // Velkost obycajneho suboru, -1 pre rury a zariadenia
+int platform_file_map(platform_file_map_t *map, FILE *file);                                     // Namapuje cely subor na postupne citanie, -1 ak to nejde
+int platform_file_map_output(platform_file_map_t *map, FILE *file, uint64_t size);               // Vyhradi miesto pre subor danej velkosti a namapuje ho na zapis
+void platform_file_map_prefetch(const platform_file_map_t *map, uint64_t offset, uint64_t size); // Poziada system o nacitanie casti suboru vopred
+void platform_file_unmap(platform_file_map_t *map);                                              // Zrusi mapovanie (zapisane data zostanu v subore)
+int platform_file_truncate(FILE *file, uint64_t size);                                           // Skrati subor na danu velkost
+FILE *platform_file_create_private(const char *path);                                            // Vytvori novy subor s pravami iba pre vlastnika, NULL ak uz existuje
+int platform_file_replace(const char *from, const char *to);                                     // Premenuje subor, existujuci subor to nahradi
+int platform_file_space(FILE *file, uint64_t *available);                                        // Volne miesto na disku so suborom, -1 ak sa neda zistit
+int platform_file_private(FILE *file);                                                           // 1 ak subor nemoze citat ani menit skupina a ostatni
+
+// Funkcie pre velku pracovnu pamat
+void *platform_large_alloc(size_t size, int *pages); // Namapuje pamat s vopred pridelenymi strankami (velkymi, ak sa da)
+void platform_large_free(void *data, size_t size);   // Zrusi mapovanie pamate
+const char *platform_pages_name(int pages);          // Citatelny nazov druhu stranok
+
+// Funkcie pre cakanie na udalosti socketov
+int platform_poller_init(platform_poller_t *poller);                                               // Vytvori prazdnu mnozinu sledovanych socketov
+void platform_poller_free(platform_poller_t *poller);                                              // Uvolni ju (sockety ostanu otvorene)
+int platform_poller_add(platform_poller_t *poller, int sock, unsigned events, void *data);         // Zacne sledovat socket
+int platform_poller_modify(platform_poller_t *poller, int sock, unsigned events, void *data);      // Zmeni sledovane udalosti socketu
+void platform_poller_remove(platform_poller_t *poller, int sock);                                  // Prestane sledovat socket
+int platform_poller_wait(platform_poller_t *poller, platform_poll_event_t *events, int max_events, // Pocka na udalosti, 0 po timeout_ms alebo signale
+                         int timeout_ms);
+int platform_notifier_init(platform_notifier_t *notifier);    // Vytvori zobudzac
+void platform_notifier_free(platform_notifier_t *notifier);   // Zatvori zobudzac
+int platform_notifier_socket(platform_notifier_t *notifier);  // Socket, ktory sa ma sledovat na citanie
+void platform_notifier_signal(platform_notifier_t *notifier); // Zobudi cakanie (z lubovolneho vlakna)
+void platform_notifier_clear(platform_notifier_t *notifier);  // Zrusi zobudenie po jeho spracovani
+
 #endif // PLATFORM_H
@@ -0,0 +1,959 @@
+/********************************************************************************
+ * Program:    Reaktor servera pre zabezpeceny prenos suborov
+ * Subor:      reactor.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia reaktora, ktory obsluhuje vela klientov jednym vlaknom:
+ *     - Kazde spojenie je stavovy automat nad neblokujucim socketom, spravy
+ *       protokolu sa skladaju z toho, co prave prislo (bez cakania na klienta)
+ *     - Argon2 bezi v spolocnom planovaci odvodeni, bloky suboru desifruje
+ *       skupina vlakien reaktora - vysledok ohlasia cez zobudzac reaktora
+ *     - Spojenie sa uvolni az ked ziadne vlakno nepracuje s jeho datami
+ *
+ * Zavislosti:
+ *     - reactor.h (deklaracie funkcii)
+ *     - siete.h (sockety a spravy protokolu)
+ *     - pipeline.h (prijimanie suboru riadene udalostami)
+ *     - sake.h (SAKE protokol)
+ *     - crypto_utils.h (kryptograficke operacie)
+ *     - credentials.h (uloziste prihlasovacich udajov)
+ *     - platform.h (sledovanie socketov a synchronizacia)
+ *******************************************************************************/
+
+#include <stdio.h>  // Kniznica pre standardny vstup a vystup (subory, vypisy)
+#include <stdlib.h> // Kniznica pre spravu pamate
+#include <string.h> // Kniznica pre pracu s pamatou a retazcami
+#include <stdarg.h> // Kniznica pre vypisy s predponou spojenia
+
+#include "reactor.h"      // Deklaracie funkcii
+#include "siete.h"        // Pre sockety a spravy protokolu
+#include "pipeline.h"     // Pre prijimanie suboru riadene udalostami
+#include "sake.h"         // Pre SAKE protokol
+#include "crypto_utils.h" // Pre kryptograficke operacie
+#include "credentials.h"  // Pre uloziste prihlasovacich udajov
+#include "platform.h"     // Pre sledovanie socketov a synchronizaciu
+
+// Stavy spojenia v poradi protokolu
+#define CONN_PARAMS 0    // Caka na navrh parametrov relacie
+#define CONN_SALT 1      // Caka na identifikator klienta a sol
+#define CONN_KDF 2       // Argon2 bezi vo vlakne skupiny
+#define CONN_NONCE 3     // Caka na nonce klienta
+#define CONN_RESPONSE 4  // Caka na odpoved na vyzvu
+#define CONN_FILE_NAME 5 // Caka na nazov a velkost suboru
+#define CONN_OPEN 6      // Vystupny subor sa pripravuje vo vlakne skupiny
+#define CONN_TRANSFER 7  // Prijima bloky, po konci suboru posle potvrdenie
+#define CONN_CLOSED 8    // Socket je zatvoreny, spojenie sa uvolni po skonceni uloh
+
+// Nazvy stavov pre chybove spravy
+static const char *const connection_state_names[] = {
+    "parameter negotiation", "client ID and salt exchange", "key derivation", "nonce exchange",
+    "authentication", "file name exchange", "file preparation", "file transfer", "shutdown"};
+
+// Stav jedneho spojenia
+struct connection
+{
+    reactor_t *reactor;
+    connection_t *prev; // Predchadzajuce spojenie v zozname reaktora
+    connection_t *next; // Dalsie spojenie v zozname reaktora
+    unsigned id;        // Cislo spojenia vo vypisoch
+    int socket;
+    int state;            // CONN_*
+    unsigned events;      // Sledovane udalosti socketu (0 = socket sa nesleduje)
+    uint64_t deadline_ms; // Dokedy musi klient nieco poslat alebo prijat
+
+    // Prijimany subor sa zapisuje do docasneho suboru, az po uspechu dostane svoj nazov
+    char file_path[NEW_FILE_NAME_BUFFER_SIZE];  // Vysledny nazov suboru
+    char part_path[PART_FILE_NAME_BUFFER_SIZE]; // Docasny subor (prazdny retazec = nie je)
+
+    // Spravy pri nadviazani spojenia
+    uint8_t input[REACTOR_HANDSHAKE_BUFFER_SIZE];  // Prijata sprava (po nazve suboru aj prve bajty blokov)
+    size_t input_size;                             // Velkost ocakavanej spravy
+    size_t input_len;                              // Pocet prijatych bajtov
+    size_t input_pos;                              // Pocet bajtov za nazvom suboru, ktore uz dostal prud blokov
+    uint8_t output[REACTOR_HANDSHAKE_BUFFER_SIZE]; // Sprava, ktora caka na odoslanie
+    size_t output_len;                             // Dlzka spravy
+    size_t output_sent;                            // Pocet uz odoslanych bajtov
+    int close_after_send;                          // 1 ak sa ma spojenie po odoslani spravy zatvorit
+
+    // Odvodenie kluca v planovaci (kdf_running a queued chrani reactor->lock)
+    kdf_job_t kdf_job;
+    char client_id[CLIENT_ID_SIZE + 1]; // Identifikator klienta
+    uint8_t psk[PSK_SIZE];              // PSK klienta, vymaze ho odvodenie kluca
+    int kdf_running;                    // 1 kym odvodenie caka alebo bezi
+    int queued;                         // 1 ak je spojenie v zozname ready
+    connection_t *next_ready;
+
+    // Kryptograficky stav relacie
+    session_params_t params;
+    uint8_t transcript[SESSION_TRANSCRIPT_SIZE]; // Navrh klienta a odpoved servera, ako isli po sieti
+    uint8_t salt[SALT_SIZE];
+    uint8_t key[KEY_SIZE];
+    sake_key_chain_t key_chain;
+    uint8_t client_nonce[SAKE_NONCE_CLIENT_SIZE];
+    uint8_t server_nonce[SAKE_NONCE_SERVER_SIZE];
+    uint8_t challenge[SAKE_CHALLENGE_SIZE];
+    key_ratchet_t keys; // Kluce epoch (bez vlakna na pozadi, epochy sa pripravia az pri prechode)
+    int has_keys;
+
+    // Priprava vystupneho suboru vo vlakne skupiny (open_running chrani reactor->lock)
+    task_t open_task;
+    uint64_t file_size; // Velkost ohlasena klientom (FILE_SIZE_UNKNOWN ak ju klient nepozna)
+    int open_running;   // 1 kym uloha caka alebo bezi
+
+    // Prijimanie suboru
+    // Hlavicky, tagy a male bloky sa prijimaju vo velkych kusoch do recv_buffer, jedno volanie recv
+    // tak prinesie viac blokov naraz - iba velky zvysok dat bloku ide priamo na miesto bloku
+    uint8_t *recv_buffer; // REACTOR_RECV_BUFFER_SIZE bajtov, alokuje sa so zasobnikom blokov
+    size_t recv_pos;      // Pocet bajtov v recv_buffer, ktore uz dostal prud blokov
+    size_t recv_len;      // Pocet prijatych bajtov v recv_buffer
+    FILE *file;
+    pipeline_t pipeline; // Zasobnik blokov tohto spojenia
+    int has_pipeline;
+    pipeline_run_t run; // Prud blokov (streaming = 1 kym nie je ukonceny)
+    int streaming;
+};
+
+// Vypis spravy s predponou spojenia
+static void connection_log(const connection_t *conn, FILE *stream, const char *format, ...)
+{
+    va_list args;
+    fprintf(stream, MSG_CLIENT_PREFIX, conn->id);
+    va_start(args, format);
+    vfprintf(stream, format, args);
+    va_end(args);
+}
+
+// Vypis o zlyhani spojenia v aktualnom stave, podrobnosti uz vypisala funkcia, ktora zlyhala
+static int connection_dropped(const connection_t *conn)
+{
+    connection_log(conn, stderr, ERR_CONNECTION_DROPPED, connection_state_names[conn->state]);
+    return -1;
+}
+
+// Zaradenie spojenia do zoznamu ready (so zamknutym reactor->lock)
+static void connection_queue(connection_t *conn)
+{
+    if (!conn->queued)
+    {
+        conn->queued = 1;
+        conn->next_ready = conn->reactor->ready;
+        conn->reactor->ready = conn;
+    }
+}
+
+// Zobudenie reaktora po desifrovani bloku - vola vlakno skupiny so zamknutym zamkom prudu
+// (poradie zamkov: prud, potom reaktor), reaktor preto spojenie neuvolni skor, nez sa zaradi
+static void connection_wake(void *arg)
+{
+    connection_t *conn = (connection_t *)arg;
+    reactor_t *reactor = conn->reactor;
+
+    platform_mutex_lock(&reactor->lock);
+    connection_queue(conn);
+    platform_mutex_unlock(&reactor->lock);
+    platform_notifier_signal(&reactor->notifier);
+}
+
+// Koniec odvodenia hlavneho kluca z PSK a prijatej soli - vola vlakno planovaca
+// Sol je v bufferi input, ten sa pocas odvodenia nemeni (spojenie necita socket)
+static void connection_kdf_done(kdf_job_t *job)
+{
+    connection_t *conn = (connection_t *)job->arg;
+
+    // Koniec ulohy a zaradenie naraz - po odomknuti moze reaktor spojenie uvolnit
+    reactor_t *reactor = conn->reactor;
+    platform_mutex_lock(&reactor->lock);
+    conn->kdf_running = 0;
+    connection_queue(conn);
+    platform_mutex_unlock(&reactor->lock);
+    platform_notifier_signal(&reactor->notifier);
+}
+
+// Pridanie spravy do vystupneho buffera, odosle ju connection_update
+static void connection_send(connection_t *conn, const void *data, size_t size)
+{
+    memcpy(conn->output + conn->output_len, data, size);
+    conn->output_len += size;
+}
+
+// Dalsi stav s ocakavanou spravou pevnej velkosti
+static void connection_expect(connection_t *conn, int state, size_t size)
+{
+    conn->state = state;
+    conn->input_size = size;
+    conn->input_len = 0;
+}
+
+// Nastavenie sledovanych udalosti socketu (0 = socket sa prestane sledovat)
+static int connection_watch(connection_t *conn, unsigned events)
+{
+    if (events == conn->events)
+    {
+        return 0;
+    }
+    int result = 0;
+    if (conn->events == 0)
+    {
+        result = platform_poller_add(&conn->reactor->poller, conn->socket, events, conn);
+    }
+    else if (events == 0)
+    {
+        platform_poller_remove(&conn->reactor->poller, conn->socket);
+    }
+    else
+    {
+        result = platform_poller_modify(&conn->reactor->poller, conn->socket, events, conn);
+    }
+    if (result == 0)
+    {
+        conn->events = events;
+    }
+    return result;
+}
+
+// Zatvorenie socketu - data spojenia sa uvolnia az v reactor_reap
+static void connection_close(connection_t *conn)
+{
+    if (conn->state == CONN_CLOSED)
+    {
+        return;
+    }
+    connection_watch(conn, 0);
+    SOCKET_CLOSE(conn->socket);
+    conn->socket = -1;
+    conn->state = CONN_CLOSED;
+    conn->reactor->closed++;
+}
+
+// Odoslanie cakajucej spravy, kolko socket prijme
+// Navratova hodnota: 0 pri uspechu (aj ked cast spravy caka), -1 pri chybe
+static int connection_flush(connection_t *conn)
+{
+    while (conn->output_sent < conn->output_len)
+    {
+        ssize_t sent = send(conn->socket, (const char *)conn->output + conn->output_sent,
+                            conn->output_len - conn->output_sent, SEND_FLAGS);
+        if (sent < 0)
+        {
+            if (SOCKET_WOULD_BLOCK())
+            {
+                return 0;
+            }
+            connection_log(conn, stderr, ERR_CONNECTION_IO, connection_state_names[conn->state], strerror(errno));
+            return -1;
+        }
+        conn->output_sent += (size_t)sent;
+    }
+    conn->output_len = 0;
+    conn->output_sent = 0;
+    return 0;
+}
+
+// Po kazdom kroku spojenia: odosle cakajucu spravu, nastavi sledovane udalosti a casovy limit
+// Socket sa cita, iba ked je kam prijimat - spojenie, ktore caka na vlakna, ho nesleduje a nema limit
+static void connection_update(connection_t *conn)
+{
+    if (conn->state == CONN_CLOSED)
+    {
+        return;
+    }
+    if (connection_flush(conn) != 0)
+    {
+        connection_close(conn);
+        return;
+    }
+    if (conn->close_after_send && conn->output_len == 0)
+    {
+        if (conn->state == CONN_TRANSFER)
+        {
+            connection_log(conn, stdout, LOG_SUCCESS_FORMAT, "received",
+                           (float)conn->pipeline.bytes / PROGRESS_UPDATE_INTERVAL);
+        }
+        connection_close(conn);
+        return;
+    }
+
+    unsigned events = (conn->output_len > 0) ? PLATFORM_POLL_OUT : 0;
+    size_t size;
+    if (conn->close_after_send || conn->state == CONN_KDF || conn->state == CONN_OPEN)
+    {
+        // Necita sa nic
+    }
+    else if (conn->state != CONN_TRANSFER || (conn->streaming && pipeline_stream_buffer(&conn->run, &size) != NULL))
+    {
+        events |= PLATFORM_POLL_IN;
+    }
+    if (connection_watch(conn, events) != 0)
+    {
+        connection_log(conn, stderr, ERR_CONNECTION_IO, connection_state_names[conn->state], strerror(errno));
+        connection_close(conn);
+        return;
+    }
+    conn->deadline_ms = platform_time_ms() + ((conn->state == CONN_FILE_NAME) ? WAIT_FILE_NAME : SOCKET_TIMEOUT_MS);
+}
+
+// Navrh parametrov relacie: server vyberie hodnoty podla svojich moznosti a odpovie nimi
+// Server ponukne tolko liniek Argon2, kolko ma procesorov, a vlastne pravidla rotacie
+static int connection_params(connection_t *conn)
+{
+    session_params_t proposed;
+    conn->params.argon2_lanes = argon2_preferred_lanes();
+    conn->params.cipher_suites = aead_supported_suites();
+    conn->params.frame_size = FRAME_SIZE_PREFERRED;
+    conn->params.rotation = conn->reactor->config.rotation;
+    if (session_params_decode(conn->input, &proposed) != 0 || session_params_choose(&proposed, &conn->params) != 0)
+    {
+        return connection_dropped(conn);
+    }
+
+    // Navrh aj odpoved si spojenie pamata - SAKE ich potvrdi, zmena po ceste zlyha pri overeni
+    uint8_t *reply = conn->transcript + SESSION_PARAMS_WIRE_SIZE;
+    memcpy(conn->transcript, conn->input, SESSION_PARAMS_WIRE_SIZE);
+    session_params_encode(&conn->params, reply);
+    connection_send(conn, reply, SESSION_PARAMS_WIRE_SIZE);
+    connection_send(conn, conn->reactor->config.psk_salt, SALT_SIZE);
+    connection_log(conn, stdout, MSG_ARGON2_LANES, conn->params.argon2_lanes);
+    connection_log(conn, stdout, MSG_CIPHER_SUITE, aead_suite_name(conn->params.cipher_suites));
+    connection_log(conn, stdout, MSG_FRAME_SIZE, conn->params.frame_size);
+    connection_log(conn, stdout, MSG_ROTATION_POLICY, conn->params.rotation.frames, conn->params.rotation.mib,
+                   conn->params.rotation.ms);
+    connection_expect(conn, CONN_SALT, CLIENT_ID_SIZE + SALT_SIZE);
+    return 0;
+}
+
+// Identifikator klienta a sol: PSK klienta z uloziska (alebo zo spolocneho hesla) a odvodenie
+// kluca sa odovzda planovacu, pri plnej fronte sa spojenie odmietne
+// Neznamy klient dostane nahodne PSK - odmietne ho az overenie SAKE, rovnako ako nespravne heslo
+static int connection_salt(connection_t *conn)
+{
+    reactor_t *reactor = conn->reactor;
+    if (client_id_decode(conn->input, conn->client_id) != 0)
+    {
+        connection_log(conn, stderr, ERR_CLIENT_ID_INVALID);
+        return connection_dropped(conn);
+    }
+    connection_log(conn, stdout, MSG_CLIENT_ID, conn->client_id);
+    if (reactor->config.credentials != NULL)
+    {
+        const uint8_t *psk = credentials_lookup(reactor->config.credentials, conn->input);
+        if (psk != NULL)
+        {
+            memcpy(conn->psk, psk, PSK_SIZE);
+        }
+        else
+        {
+            connection_log(conn, stderr, ERR_CLIENT_UNKNOWN, conn->client_id);
+            generate_random_bytes(conn->psk, PSK_SIZE);
+        }
+    }
+
+    // Bez uloziska sa PSK zo spolocneho hesla odvodi az vo vlakne planovaca (Argon2id)
+    conn->state = CONN_KDF;
+    conn->kdf_job.psk = conn->psk;
+    conn->kdf_job.password = (reactor->config.credentials == NULL) ? reactor->config.password : NULL;
+    conn->kdf_job.client_id = conn->input;
+    conn->kdf_job.psk_salt = reactor->config.psk_salt;
+    conn->kdf_job.salt = conn->input + CLIENT_ID_SIZE;
+    conn->kdf_job.key = conn->key;
+    conn->kdf_job.salt_out = conn->salt;
+    conn->kdf_job.lanes = conn->params.argon2_lanes;
+    conn->kdf_job.done = connection_kdf_done;
+    conn->kdf_job.arg = conn;
+    platform_mutex_lock(&reactor->lock);
+    conn->kdf_running = 1;
+    platform_mutex_unlock(&reactor->lock);
+
+    int position = kdf_scheduler_submit(reactor->config.kdf, &conn->kdf_job);
+    if (position < 0)
+    {
+        platform_mutex_lock(&reactor->lock);
+        conn->kdf_running = 0;
+        platform_mutex_unlock(&reactor->lock);
+        connection_log(conn, stderr, ERR_KDF_QUEUE_FULL);
+        return -1;
+    }
+    if (position > 0)
+    {
+        connection_log(conn, stdout, MSG_KDF_QUEUED, position);
+    }
+    return 0;
+}
+
+// Kluc je odvodeny: potvrdenie klientovi a inicializacia SAKE key chain (server = responder)
+static int connection_key_ready(connection_t *conn)
+{
+    if (conn->kdf_job.result != 0)
+    {
+        connection_log(conn, stderr, ERR_KEY_DERIVATION);
+        return -1;
+    }
+    if (conn->kdf_job.wait_ms > 0)
+    {
+        connection_log(conn, stdout, MSG_KDF_WAITED, (unsigned long long)conn->kdf_job.wait_ms);
+    }
+    connection_send(conn, MAGIC_KEYOK, SIGNAL_SIZE);
+    sake_init_key_chain(&conn->key_chain, conn->key, 0);
+    connection_expect(conn, CONN_NONCE, SAKE_NONCE_CLIENT_SIZE);
+    return 0;
+}
+
+// Nonce klienta: odpovie nonce servera a vyzvou z aktualneho autentizacneho kluca
+static int connection_nonce(connection_t *conn)
+{
+    memcpy(conn->client_nonce, conn->input, SAKE_NONCE_CLIENT_SIZE);
+    generate_challenge(conn->challenge, conn->server_nonce, conn->key_chain.auth_key_curr, conn->client_nonce,
+                       conn->transcript);
+    connection_send(conn, conn->server_nonce, SAKE_NONCE_SERVER_SIZE);
+    connection_send(conn, conn->challenge, SAKE_CHALLENGE_SIZE);
+    connection_expect(conn, CONN_RESPONSE, SAKE_RESPONSE_SIZE);
+    return 0;
+}
+
+// Odpoved na vyzvu: po overeni odvodi kluc relacie, inak klientovi oznami zlyhanie a zatvori spojenie
+static int connection_response(connection_t *conn)
+{
+    if (verify_response(conn->input, conn->key_chain.auth_key_curr, conn->challenge, conn->server_nonce,
+                        conn->transcript) != 0)
+    {
+        // Nespravne heslo alebo MitM utok - ostatne spojenia pokracuju
+        connection_log(conn, stderr, ERR_SAKE_MITM_SUSPECTED_SERVER);
+        uint8_t auth_result = AUTH_FAILED;
+        connection_send(conn, &auth_result, 1);
+        conn->close_after_send = 1;
+        return 0;
+    }
+    uint8_t auth_result = AUTH_SUCCESS;
+    connection_send(conn, &auth_result, 1);
+
+    // Kluc relacie je kluc epochy 0, dalej ho drzi uz iba retazec epoch
+    // Reaktor nema vlakno na pozadi pre kazde spojenie - kluc dalsej epochy sa odvodi pri prechode
+    uint8_t session_key[SESSION_KEY_SIZE];
+    derive_session_key(session_key, conn->key_chain.master_key, conn->client_nonce, conn->server_nonce,
+                       conn->transcript);
+    key_ratchet_init(&conn->keys, conn->params.cipher_suites, session_key, conn->key_chain.master_key,
+                     conn->client_nonce, conn->server_nonce, 0);
+    conn->has_keys = 1;
+    secure_wipe(session_key, SESSION_KEY_SIZE);
+    sake_update_key_chain(&conn->key_chain);
+
+    connection_log(conn, stdout, LOG_SESSION_COMPLETE);
+    connection_expect(conn, CONN_FILE_NAME, 0);
+    return 0;
+}
+
+// Koniec suboru prisiel a vsetky bloky su zapisane: kontrola velkosti, zatvorenie suboru a potvrdenie
+static int connection_finish_transfer(connection_t *conn)
+{
+    conn->streaming = 0;
+    int result = pipeline_stream_end(&conn->run, 0);
+    if (fclose(conn->file) != 0 && result == 0)
+    {
+        connection_log(conn, stderr, ERR_WRITE_TO_FILE);
+        result = -1;
+    }
+    conn->file = NULL;
+    if (result == 0 && platform_file_replace(conn->part_path, conn->file_path) != 0)
+    {
+        connection_log(conn, stderr, ERR_FILE_RENAME, conn->file_path, strerror(errno));
+        result = -1;
+    }
+    if (result != 0)
+    {
+        return connection_dropped(conn);
+    }
+    conn->part_path[0] = '\0';
+
+    connection_log(conn, stdout, LOG_TRANSFER_COMPLETE);
+    connection_send(conn, MAGIC_TACK, ACK_SIZE);
+    conn->close_after_send = 1;
+    return 0;
+}
+
+// Odovzdanie uz prijatych bajtov (data[*pos] az data[len]) prudu blokov
+static int connection_feed(connection_t *conn, const uint8_t *data, size_t *pos, size_t len)
+{
+    size_t used;
+    int result = pipeline_stream_feed(&conn->run, data + *pos, len - *pos, &used);
+    *pos += used;
+    return result;
+}
+
+// Prijatie blokov z bajtov za nazvom suboru a zo socketu, kym je v zasobniku miesto
+// Pocet miest v zasobniku obmedzuje, kolko jedno spojenie prijme naraz (ostatne nemusia cakat)
+static int connection_receive_frames(connection_t *conn)
+{
+    while (conn->streaming)
+    {
+        // Najprv bajty, ktore uz prisli: za nazvom suboru a zvysok posledneho recv
+        if (connection_feed(conn, conn->input, &conn->input_pos, conn->input_len) != 0 ||
+            connection_feed(conn, conn->recv_buffer, &conn->recv_pos, conn->recv_len) != 0)
+        {
+            return connection_dropped(conn);
+        }
+        size_t size;
+        uint8_t *buffer = pipeline_stream_buffer(&conn->run, &size);
+        if (buffer == NULL)
+        {
+            break; // Blok caka na miesto v zasobniku alebo prisiel koniec suboru
+        }
+
+        // Velky zvysok dat bloku sa prijme priamo na miesto bloku (bez kopirovania),
+        // inak sa naraz prijme cely buffer spojenia - hlavicka, tag a data aj viacerych blokov
+        int direct = size >= REACTOR_RECV_BUFFER_SIZE;
+        ssize_t received = RECV_DATA(conn->socket, direct ? buffer : conn->recv_buffer,
+                                     direct ? size : REACTOR_RECV_BUFFER_SIZE);
+        if (received < 0 && SOCKET_WOULD_BLOCK())
+        {
+            break;
+        }
+        if (received <= 0)
+        {
+            if (received == 0)
+            {
+                connection_log(conn, stderr, ERR_CONNECTION_CLOSED, connection_state_names[conn->state]);
+            }
+            else
+            {
+                connection_log(conn, stderr, ERR_CONNECTION_IO, connection_state_names[conn->state], strerror(errno));
+            }
+            return -1;
+        }
+        if (direct)
+        {
+            if (pipeline_stream_received(&conn->run, (size_t)received) != 0)
+            {
+                return connection_dropped(conn);
+            }
+        }
+        else
+        {
+            conn->recv_pos = 0;
+            conn->recv_len = (size_t)received;
+        }
+    }
+    return (conn->streaming && pipeline_stream_done(&conn->run)) ? connection_finish_transfer(conn) : 0;
+}
+
+// Priprava vystupneho suboru vo vlakne skupiny: zacne prud blokov, ktory pre subor znamej velkosti
+// vyhradi miesto a subor namapuje - vyhradenie moze zapisat cely subor (glibc ho napodobni zapisom
+// kazdeho bloku), v reaktore by tak zdrzalo vsetky jeho spojenia
+// Spojenie sa zaradi este so zamknutym reactor->lock - po odomknuti ho reaktor moze uvolnit
+static void connection_open_task(void *arg)
+{
+    connection_t *conn = (connection_t *)arg;
+    reactor_t *reactor = conn->reactor;
+    pipeline_stream_begin(&conn->run, &conn->pipeline, &reactor->crypto_pool, conn->file, conn->file_size,
+                          &conn->keys, &conn->params.rotation, connection_wake, conn);
+
+    platform_mutex_lock(&reactor->lock);
+    conn->streaming = 1;
+    conn->open_running = 0;
+    connection_queue(conn);
+    platform_mutex_unlock(&reactor->lock);
+    platform_notifier_signal(&reactor->notifier);
+}
+
+// Nazov suboru: vytvori vystupny subor, prud blokov zacne connection_open_task
+// Bajty za nazvom su uz prve bajty blokov - klient ich posiela hned za nazvom
+// Data idu do noveho docasneho suboru (s cislom spojenia), az uspesny prenos ho premenuje - subor,
+// ktory ma ine spojenie namapovany, sa tak nikdy neskrati (pristup za jeho koniec by ukoncil server)
+static int connection_file_name(connection_t *conn)
+{
+    char file_name[FILE_NAME_BUFFER_SIZE];
+    uint64_t file_size; // Velkost ohlasena klientom (FILE_SIZE_UNKNOWN ak ju klient nepozna)
+    int length = parse_file_name(conn->input, conn->input_len, file_name, sizeof(file_name), &file_size);
+    if (length <= 0)
+    {
+        return (length == 0) ? 0 : connection_dropped(conn);
+    }
+
+    // Vytvorenie noveho nazvu suboru pridanim predpony 'received_'
+    snprintf(conn->file_path, sizeof(conn->file_path), "%s%s", FILE_PREFIX, file_name);
+    snprintf(conn->part_path, sizeof(conn->part_path), "%s.%u%s", conn->file_path, conn->id, FILE_PART_SUFFIX);
+    conn->file = fopen(conn->part_path, FILE_MODE_CREATE);
+    if (conn->file == NULL)
+    {
+        connection_log(conn, stderr, ERR_FILE_CREATE, conn->part_path, strerror(errno));
+        conn->part_path[0] = '\0'; // Subor nevznikol (alebo patri inemu), nemaze sa
+        return -1;
+    }
+
+    // Subor, pre ktory na disku nie je miesto, sa odmietne hned (nie az ked zlyha zapis)
+    uint64_t available;
+    if (file_size != FILE_SIZE_UNKNOWN && platform_file_space(conn->file, &available) == 0 && file_size > available)
+    {
+        connection_log(conn, stderr, ERR_FILE_NO_SPACE, (unsigned long long)file_size,
+                       (unsigned long long)available);
+        return -1;
+    }
+    conn->recv_buffer = malloc(REACTOR_RECV_BUFFER_SIZE);
+    if (conn->recv_buffer == NULL || pipeline_init(&conn->pipeline, conn->params.frame_size, REACTOR_CONNECTION_WORKERS) != 0)
+    {
+        connection_log(conn, stderr, ERR_FRAME_ALLOC);
+        return -1;
+    }
+    conn->has_pipeline = 1;
+
+    connection_log(conn, stdout, LOG_TRANSFER_START);
+    conn->file_size = file_size;
+    conn->input_pos = (size_t)length;
+    conn->state = CONN_OPEN;
+    conn->open_task.fn = connection_open_task;
+    conn->open_task.arg = conn;
+    platform_mutex_lock(&conn->reactor->lock);
+    conn->open_running = 1;
+    platform_mutex_unlock(&conn->reactor->lock);
+    task_pool_submit(&conn->reactor->crypto_pool, &conn->open_task);
+    return 0;
+}
+
+// Prijatie spravy pri nadviazani spojenia - kazdy stav caka na spravu pevnej velkosti,
+// iba nazov suboru ma premenlivu dlzku (prijima sa, kolko sa zmesti do buffera)
+static int connection_receive_message(connection_t *conn)
+{
+    size_t wanted = (conn->state == CONN_FILE_NAME) ? sizeof(conn->input) - conn->input_len
+                                                    : conn->input_size - conn->input_len;
+    ssize_t received = RECV_DATA(conn->socket, conn->input + conn->input_len, wanted);
+    if (received <= 0)
+    {
+        if (received < 0 && SOCKET_WOULD_BLOCK())
+        {
+            return 0;
+        }
+        if (received == 0)
+        {
+            connection_log(conn, stderr, ERR_CONNECTION_CLOSED, connection_state_names[conn->state]);
+        }
+        else
+        {
+            connection_log(conn, stderr, ERR_CONNECTION_IO, connection_state_names[conn->state], strerror(errno));
+        }
+        return -1;
+    }
+    conn->input_len += (size_t)received;
+
+    if (conn->state == CONN_FILE_NAME)
+    {
+        return connection_file_name(conn);
+    }
+    if (conn->input_len < conn->input_size)
+    {
+        return 0;
+    }
+    if (conn->state == CONN_PARAMS)
+    {
+        return connection_params(conn);
+    }
+    if (conn->state == CONN_SALT)
+    {
+        return connection_salt(conn);
+    }
+    if (conn->state == CONN_NONCE)
+    {
+        return connection_nonce(conn);
+    }
+    return connection_response(conn);
+}
+
+// Udalost socketu spojenia
+static void connection_event(connection_t *conn, unsigned events)
+{
+    int result = 0;
+    if (conn->state == CONN_CLOSED)
+    {
+        return; // Udalost z toho isteho cakania, v ktorom sa spojenie zatvorilo
+    }
+    if ((events & PLATFORM_POLL_IN) && !conn->close_after_send)
+    {
+        if (conn->state == CONN_TRANSFER)
+        {
+            result = connection_receive_frames(conn);
+        }
+        else if (conn->state != CONN_KDF)
+        {
+            result = connection_receive_message(conn);
+        }
+    }
+    if (result != 0)
+    {
+        connection_close(conn);
+        return;
+    }
+    connection_update(conn); // Odosle cakajucu spravu aj pri PLATFORM_POLL_OUT
+}
+
+// Vlakno skupiny dokoncilo ulohu spojenia: odvodeny kluc, pripraveny subor, desifrovane alebo zapisane bloky
+static void connection_task_done(connection_t *conn)
+{
+    int result = 0;
+    if (conn->state == CONN_KDF)
+    {
+        result = connection_key_ready(conn);
+    }
+    else if (conn->state == CONN_OPEN)
+    {
+        conn->state = CONN_TRANSFER;
+        result = connection_receive_frames(conn);
+    }
+    else if (conn->state == CONN_TRANSFER && conn->streaming)
+    {
+        result = (pipeline_stream_drain(&conn->run) == 0) ? connection_receive_frames(conn) : connection_dropped(conn);
+    }
+    if (result != 0)
+    {
+        connection_close(conn);
+        return;
+    }
+    connection_update(conn);
+}
+
+// Uvolnenie spojenia - ziadne vlakno uz s nim nepracuje
+// Subor prijaty iba ciastocne sa skrati na zapisane bloky
+static void connection_free(connection_t *conn)
+{
+    reactor_t *reactor = conn->reactor;
+    if (conn->streaming)
+    {
+        pipeline_stream_end(&conn->run, -1);
+    }
+    if (conn->file != NULL)
+    {
+        fclose(conn->file);
+    }
+    if (conn->part_path[0] != '\0')
+    {
+        remove(conn->part_path); // Neuplny prenos - docasny subor sa zmaze
+    }
+    if (conn->has_pipeline)
+    {
+        pipeline_free(&conn->pipeline);
+    }
+    if (conn->recv_buffer != NULL)
+    {
+        secure_wipe(conn->recv_buffer, REACTOR_RECV_BUFFER_SIZE);
+        free(conn->recv_buffer);
+    }
+    if (conn->has_keys)
+    {
+        key_ratchet_wipe(&conn->keys);
+    }
+    if (conn->state != CONN_CLOSED)
+    {
+        SOCKET_CLOSE(conn->socket);
+    }
+
+    if (conn->prev != NULL)
+    {
+        conn->prev->next = conn->next;
+    }
+    else
+    {
+        reactor->connections = conn->next;
+    }
+    if (conn->next != NULL)
+    {
+        conn->next->prev = conn->prev;
+    }
+
+    // Vymazanie klucov, nonce a sprav spojenia
+    secure_wipe(conn, sizeof(*conn));
+    free(conn);
+}
+
+// Prijatie vsetkych cakajucich spojeni, kazde zacne signalom pripravenosti
+static void reactor_accept(reactor_t *reactor)
+{
+    for (;;)
+    {
+        struct sockaddr_in client_addr;
+        int client_socket = accept_client_connection(reactor->server_fd, &client_addr);
+        if (client_socket < 0)
+        {
+            return;
+        }
+        connection_t *conn = calloc(1, sizeof(connection_t));
+        if (conn == NULL || set_socket_nonblocking(client_socket) != 0)
+        {
+            fprintf(stderr, (conn == NULL) ? ERR_CONNECTION_ALLOC : ERR_SOCKET_NONBLOCKING);
+            free(conn);
+            SOCKET_CLOSE(client_socket);
+            continue;
+        }
+
+        conn->reactor = reactor;
+        conn->id = reactor->next_id;
+        reactor->next_id += reactor->config.shards;
+        conn->socket = client_socket;
+        conn->next = reactor->connections;
+        if (conn->next != NULL)
+        {
+            conn->next->prev = conn;
+        }
+        reactor->connections = conn;
+
+        connection_send(conn, MAGIC_READY, SIGNAL_SIZE);
+        connection_expect(conn, CONN_PARAMS, SESSION_PARAMS_WIRE_SIZE);
+        connection_update(conn);
+    }
+}
+
+// Spracovanie spojeni, ktore zobudili vlakna skupin
+// Spojenie sa vybera po jednom, aby ho vlakno mohlo hned znova zaradit
+static void reactor_process_ready(reactor_t *reactor)
+{
+    for (;;)
+    {
+        platform_mutex_lock(&reactor->lock);
+        connection_t *conn = reactor->ready;
+        if (conn != NULL)
+        {
+            reactor->ready = conn->next_ready;
+            conn->queued = 0;
+        }
+        platform_mutex_unlock(&reactor->lock);
+
+        if (conn == NULL)
+        {
+            return;
+        }
+        connection_task_done(conn);
+    }
+}
+
+// Zatvorenie spojeni, ktore cakaju na klienta dlhsie nez casovy limit
+static void reactor_check_deadlines(reactor_t *reactor, uint64_t now)
+{
+    for (connection_t *conn = reactor->connections; conn != NULL; conn = conn->next)
+    {
+        if (conn->state != CONN_CLOSED && conn->events != 0 && now > conn->deadline_ms)
+        {
+            connection_log(conn, stderr, ERR_CONNECTION_TIMEOUT, connection_state_names[conn->state]);
+            connection_close(conn);
+        }
+    }
+}
+
+// Uvolnenie zatvorenych spojeni, s ktorymi uz nepracuje ziadne vlakno
+static void reactor_reap(reactor_t *reactor)
+{
+    connection_t *conn = reactor->connections;
+    while (reactor->closed > 0 && conn != NULL)
+    {
+        connection_t *next = conn->next;
+        // Prud sa kontroluje skor nez zoznam ready: uloha zaradi spojenie este so zamknutym prudom
+        if (conn->state == CONN_CLOSED && !(conn->streaming && pipeline_stream_busy(&conn->run)))
+        {
+            platform_mutex_lock(&reactor->lock);
+            int busy = conn->queued || conn->kdf_running || conn->open_running;
+            platform_mutex_unlock(&reactor->lock);
+            if (!busy)
+            {
+                connection_free(conn);
+                reactor->closed--;
+            }
+        }
+        conn = next;
+    }
+}
+
+// Spustenie skupin vlakien a sledovania pocuvajuceho socketu (musi byt neblokujuci)
+// Viac reaktorov moze sledovat aj ten isty socket - spojenie prijme ten, ktory ho ziska prvy
+// Navratova hodnota: 0 pri uspechu, -1 pri chybe
+int reactor_init(reactor_t *reactor, int server_fd, const reactor_config_t *config)
+{
+    memset(reactor, 0, sizeof(*reactor));
+    reactor->server_fd = server_fd;
+    reactor->config = *config;
+    reactor->next_id = config->shard + 1;
+
+    platform_mutex_init(&reactor->lock);
+
+    if (platform_poller_init(&reactor->poller) != 0)
+    {
+        fprintf(stderr, ERR_REACTOR_INIT);
+        platform_mutex_destroy(&reactor->lock);
+        return -1;
+    }
+    if (platform_notifier_init(&reactor->notifier) != 0)
+    {
+        fprintf(stderr, ERR_REACTOR_INIT);
+        platform_poller_free(&reactor->poller);
+        platform_mutex_destroy(&reactor->lock);
+        return -1;
+    }
+    if (platform_poller_add(&reactor->poller, server_fd, PLATFORM_POLL_IN, &reactor->server_fd) != 0 ||
+        platform_poller_add(&reactor->poller, platform_notifier_socket(&reactor->notifier), PLATFORM_POLL_IN,
+                            &reactor->notifier) != 0 ||
+        task_pool_init(&reactor->crypto_pool, config->crypto_threads) != 0)
+    {
+        fprintf(stderr, ERR_REACTOR_INIT);
+        platform_notifier_free(&reactor->notifier);
+        platform_poller_free(&reactor->poller);
+        platform_mutex_destroy(&reactor->lock);
+        return -1;
+    }
+    return 0;
+}
+
+// Hlavny cyklus reaktora: udalosti socketov, dokoncene ulohy vlakien a casove limity
+// Konci, ked obsluha signalu nastavi *stop (caka sa najviac REACTOR_TICK_MS)
+// Navratova hodnota: 0 po zastaveni, -1 ak zlyha cakanie na udalosti
+int reactor_run(reactor_t *reactor, const volatile sig_atomic_t *stop)
+{
+    platform_poll_event_t events[PLATFORM_POLL_MAX_EVENTS];
+    uint64_t next_tick = platform_time_ms() + REACTOR_TICK_MS;
+
+    while (!*stop)
+    {
+        int count = platform_poller_wait(&reactor->poller, events, PLATFORM_POLL_MAX_EVENTS, REACTOR_TICK_MS);
+        if (count < 0)
+        {
+            fprintf(stderr, ERR_REACTOR_WAIT, strerror(errno));
+            return -1;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data == &reactor->server_fd)
+            {
+                reactor_accept(reactor);
+            }
+            else if (events[i].data == &reactor->notifier)
+            {
+                platform_notifier_clear(&reactor->notifier); // Zoznam ready sa spracuje nizsie
+            }
+            else
+            {
+                connection_event((connection_t *)events[i].data, events[i].events);
+            }
+        }
+        reactor_process_ready(reactor);
+
+        uint64_t now = platform_time_ms();
+        if (now >= next_tick)
+        {
+            reactor_check_deadlines(reactor, now);
+            next_tick = now + REACTOR_TICK_MS;
+        }
+        reactor_reap(reactor);
+    }
+    return 0;
+}
+
+// Ukoncenie reaktora: vlakna dokoncia zaradene ulohy, potom sa zatvoria vsetky spojenia
+// Planovac odvodeni musi byt uz ukonceny (ziadne odvodenie nepouziva spojenia reaktora)
+// Nedokoncene prijate subory sa skratia na zapisane bloky, pocuvajuci socket zatvara volajuci
+void reactor_free(reactor_t *reactor)
+{
+    task_pool_free(&reactor->crypto_pool);
+    while (reactor->connections != NULL)
+    {
+        connection_free(reactor->connections);
+    }
+    platform_poller_free(&reactor->poller);
+    platform_notifier_free(&reactor->notifier);
+    platform_mutex_destroy(&reactor->lock);
+    memset(reactor, 0, sizeof(*reactor));
+}
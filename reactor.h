@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Program:    Reaktor servera pre zabezpeceny prenos suborov
+ * Subor:      reactor.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre reaktor, ktory obsluhuje vela klientov naraz:
+ *     - Jedno vlakno caka na udalosti vsetkych neblokujucich socketov (epoll, WSAPoll)
+ *       a posuva stav kazdeho spojenia (parametre, sol, SAKE, nazov suboru, bloky)
+ *     - Argon2 robi spolocny planovac odvodeni (pevny rozpocet pamate), desifrovanie
+ *       blokov skupina vlakien reaktora - reaktor nikdy nepocita
+ *     - Spojenie, ktore necaka na klienta, ale na vlakna, nema casovy limit
+ *     - Server moze spustit viac nezavislych reaktorov (kazdy s vlastnym socketom
+ *       a vlaknami), nic nezdielaju
+ *
+ * Zavislosti:
+ *     - platform.h (sledovanie socketov, zobudzac, synchronizacia)
+ *     - task_pool.h (spolocne skupiny vlakien)
+ *     - kdf_scheduler.h (planovac odvodenia klucov)
+ *     - credentials.h (uloziste prihlasovacich udajov)
+ *     - crypto_utils.h (pravidla rotacie kluca)
+ *     - constants.h (konstanty programu)
+ ******************************************************************************/
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <signal.h> // Kniznica pre typ sig_atomic_t
+
+#include "platform.h"     // Pre sledovanie socketov a synchronizaciu
+#include "task_pool.h"     // Pre spolocne skupiny vlakien
+#include "kdf_scheduler.h" // Pre planovac odvodenia klucov
+#include "credentials.h"   // Pre uloziste prihlasovacich udajov
+#include "crypto_utils.h"  // Pre pravidla rotacie kluca
+#include "constants.h"     // Definicie konstant pre program
+
+typedef struct connection connection_t; // Stav jedneho spojenia (iba v reactor.c)
+
+// Nastavenie reaktora - server moze spustit viac reaktorov (jeden na procesor), kazdy s vlastnymi vlaknami
+typedef struct
+{
+    const credential_store_t *credentials; // Uloziste PSK klientov (NULL = vsetci klienti maju spolocne heslo)
+    const char *password;                  // Spolocne heslo, ak server nema uloziste
+    const uint8_t *psk_salt;               // Sol pre PSK z hesiel (z uloziska alebo nahodna pri spusteni)
+    rotation_policy_t rotation;            // Pravidla rotacie kluca, ktore server navrhne
+    unsigned crypto_threads;               // Pocet vlakien pre desifrovanie blokov
+    kdf_scheduler_t *kdf;                  // Planovac odvodenia klucov (spolocny pre vsetky reaktory)
+    unsigned shard;                        // Poradie reaktora (0 az shards - 1)
+    unsigned shards;                       // Pocet reaktorov servera (cisla spojeni sa tak neopakuju)
+} reactor_config_t;
+
+// Reaktor - vsetky polozky okrem zamknutych lock pouziva iba vlakno reaktora
+typedef struct
+{
+    int server_fd;                 // Neblokujuci pocuvajuci socket
+    reactor_config_t config;       // Nastavenie reaktora
+    platform_poller_t poller;      // Sledovane sockety
+    platform_notifier_t notifier;  // Zobudenie reaktora z vlakien skupin
+    task_pool_t crypto_pool;       // Vlakna pre desifrovanie blokov vsetkych spojeni
+    connection_t *connections;     // Vsetky otvorene spojenia
+    unsigned next_id;              // Cislo dalsieho spojenia (pre vypisy, krok je pocet reaktorov)
+    unsigned closed;               // Pocet zatvorenych spojeni, ktore este treba uvolnit
+    platform_mutex_t lock;         // Chrani zoznam ready a priznaky spojeni pre vlakna skupin
+    connection_t *ready;           // Spojenia, ktorych ulohu vlakna dokoncili
+} reactor_t;
+
+int reactor_init(reactor_t *reactor, int server_fd, const reactor_config_t *config); // Spusti vlakna a zacne sledovat server_fd
+int reactor_run(reactor_t *reactor, const volatile sig_atomic_t *stop);             // Obsluhuje spojenia, kym *stop nie je 1
+void reactor_free(reactor_t *reactor);                                              // Ukonci vlakna a zatvori vsetky spojenia (po kdf_scheduler_free)
+
+#endif // REACTOR_H
@@ -44,7 +44,8 @@ void derive_authentication_key(uint8_t *auth_key, const uint8_t *master_key)
 // Generovanie vyzvy pre autentizaciu
 // Vytvara challenge hodnotu pre overenie identity komunikujucej strany
 void generate_challenge(uint8_t *challenge, uint8_t *server_nonce,
-                        const uint8_t *auth_key, const uint8_t *client_nonce)
+                        const uint8_t *auth_key, const uint8_t *client_nonce,
+                        const uint8_t *transcript)
 {
     // Vygenerovanie nahodneho nonce servera pre jedinecnost kazdeho spojenia
     generate_random_bytes(server_nonce, SAKE_NONCE_SERVER_SIZE);
@@ -55,6 +56,7 @@ void generate_challenge(uint8_t *challenge, uint8_t *server_nonce,
     crypto_blake2b_update(&ctx, auth_key, KEY_SIZE);                   // Pridanie tajneho kluca
     crypto_blake2b_update(&ctx, client_nonce, SAKE_NONCE_CLIENT_SIZE); // Pridanie klientskej nonce
     crypto_blake2b_update(&ctx, server_nonce, SAKE_NONCE_SERVER_SIZE); // Pridanie serverovej nonce
+    crypto_blake2b_update(&ctx, transcript, SESSION_TRANSCRIPT_SIZE);  // Parametre relacie podla servera
     crypto_blake2b_final(&ctx, challenge);                             // Finalizacia a ziskanie vyzvy
     crypto_wipe(&ctx, sizeof(ctx));                                    // Bezpecne vymazanie citliveho kontextu
 
@@ -63,14 +65,17 @@ void generate_challenge(uint8_t *challenge, uint8_t *server_nonce,
 
 // Vypocet odpovede na vyzvu
 // Klient pocita svoju odpoved na zaklade prijatej vyzvy
+// Odpoved zahrna parametre relacie, ako ich videl klient - server ju prijme iba pri zhode
 int compute_response(uint8_t *response, const uint8_t *auth_key,
-                     const uint8_t *challenge, const uint8_t *server_nonce)
+                     const uint8_t *challenge, const uint8_t *server_nonce,
+                     const uint8_t *transcript)
 {
     crypto_blake2b_ctx ctx;
     crypto_blake2b_init(&ctx, SAKE_RESPONSE_SIZE);
     crypto_blake2b_update(&ctx, auth_key, KEY_SIZE);                   // Tajny kluc, ktory maju obe strany
     crypto_blake2b_update(&ctx, challenge, SAKE_CHALLENGE_SIZE);       // Prijata vyzva
     crypto_blake2b_update(&ctx, server_nonce, SAKE_NONCE_SERVER_SIZE); // Server nonce pre jedinecnost
+    crypto_blake2b_update(&ctx, transcript, SESSION_TRANSCRIPT_SIZE);  // Dohodnute parametre relacie
     crypto_blake2b_final(&ctx, response);                              // Vytvorenie odpovede na vyzvu
     crypto_wipe(&ctx, sizeof(ctx));                                    // Bezpecne vymazanie pamate
 
@@ -81,12 +86,13 @@ int compute_response(uint8_t *response, const uint8_t *auth_key,
 // Overenie odpovede na vyzvu
 // Server overi ci klient pozna spravny kluc porovnanim odpovede
 int verify_response(const uint8_t *response, const uint8_t *auth_key,
-                    const uint8_t *challenge, const uint8_t *server_nonce)
+                    const uint8_t *challenge, const uint8_t *server_nonce,
+                    const uint8_t *transcript)
 {
     uint8_t expected_response[SAKE_RESPONSE_SIZE]; // Miesto pre ocakavanu odpoved
 
     // Vypocet ocakavanej odpovede rovnakym algoritmom
-    compute_response(expected_response, auth_key, challenge, server_nonce);
+    compute_response(expected_response, auth_key, challenge, server_nonce, transcript);
 
     // Porovnanie prijatej a vypocitanej odpovede pomocou konstantneho casu
     if (crypto_verify32(expected_response, response) != 0)
@@ -102,13 +108,15 @@ int verify_response(const uint8_t *response, const uint8_t *auth_key,
 // Odvodenie kluca relacie z hlavneho kluca a nonce hodnot
 // Vytvara unikatny relacny kluc pre kazdu komunikaciu
 void derive_session_key(uint8_t *session_key, const uint8_t *master_key,
-                        const uint8_t *client_nonce, const uint8_t *server_nonce)
+                        const uint8_t *client_nonce, const uint8_t *server_nonce,
+                        const uint8_t *transcript)
 {
     crypto_blake2b_ctx ctx;
     crypto_blake2b_init(&ctx, SESSION_KEY_SIZE);
     crypto_blake2b_update(&ctx, master_key, KEY_SIZE);                                                    // Hlavny kluc ako zaklad
     crypto_blake2b_update(&ctx, client_nonce, SAKE_NONCE_CLIENT_SIZE);                                    // Klientske nonce
     crypto_blake2b_update(&ctx, server_nonce, SAKE_NONCE_SERVER_SIZE);                                    // Serverove nonce
+    crypto_blake2b_update(&ctx, transcript, SESSION_TRANSCRIPT_SIZE);                                     // Dohodnute parametre relacie
     crypto_blake2b_update(&ctx, (const uint8_t *)SAKE_DERIV_SESSION_TAG, strlen(SAKE_DERIV_SESSION_TAG)); // Tag pre separaciu
     crypto_blake2b_final(&ctx, session_key);                                                              // Vytvorenie relacneho kluca
     crypto_wipe(&ctx, sizeof(ctx));                                                                       // Bezpecne vymazanie kontextu
@@ -36,28 +36,34 @@ typedef struct
 } sake_key_chain_t;
 
 // SAKE protokol - funkcie pre autentizaciu a vymenu klucov
+// transcript: parametre relacie oboch stran (SESSION_TRANSCRIPT_SIZE bajtov), ako isli po sieti
+// Su sucastou vyzvy, odpovede aj kluca relacie, takze ich zmena po ceste zlyha pri overeni
 void derive_authentication_key(uint8_t *auth_key, // Odvodenie autentizacneho kluca K' z hlavneho kluca K
                                const uint8_t *master_key);
 
 void generate_challenge(uint8_t *challenge, // Generovanie vyzvy pre autentizaciu
                         uint8_t *server_nonce,
                         const uint8_t *auth_key,
-                        const uint8_t *client_nonce);
+                        const uint8_t *client_nonce,
+                        const uint8_t *transcript);
 
 int compute_response(uint8_t *response, // Vypocet odpovede na vyzvu
                      const uint8_t *auth_key,
                      const uint8_t *challenge,
-                     const uint8_t *server_nonce);
+                     const uint8_t *server_nonce,
+                     const uint8_t *transcript);
 
 int verify_response(const uint8_t *response, // Overenie odpovede na vyzvu
                     const uint8_t *auth_key,
                     const uint8_t *challenge,
-                    const uint8_t *server_nonce);
+                    const uint8_t *server_nonce,
+                    const uint8_t *transcript);
 
 void derive_session_key(uint8_t *session_key, // Odvodenie kluca relacie z hlavneho kluca a nonce
                         const uint8_t *master_key,
                         const uint8_t *client_nonce,
-                        const uint8_t *server_nonce);
+                        const uint8_t *server_nonce,
+                        const uint8_t *transcript);
 
 void sake_init_key_chain(sake_key_chain_t *chain, const uint8_t *master_key, int is_initiator); // Inicializacia retazca klucov pre SAKE
 
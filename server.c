@@ -7,10 +7,15 @@
  *
  * Popis:
  *     Implementacia servera pre zabezpeceny prenos suborov. Program zabezpecuje:
- *     - Vytvorenie TCP servera a prijimanie spojeni
+ *     - Vytvorenie TCP servera a prijimanie spojeni od mnohych klientov naraz
+ *       (reaktor nad neblokujucimi socketmi, spolocne vlakna pre vypocty)
+ *     - Volitelne viac reaktorov (jeden na procesor), kazdy s vlastnym socketom
+ *       na rovnakom porte (SO_REUSEPORT) - jadro medzi ne rozdeluje spojenia
  *     - Autentizaciu pomocou SAKE protokolu (Symmetric Authenticated Key Exchange)
+ *     - Volitelne uloziste prihlasovacich udajov (PSK kazdeho klienta podla jeho
+ *       identifikatora), inak spolocne heslo zadane pri spusteni
  *     - Bezpecnu vymenu klucov s klientom zalozenu na zdielanom tajomstve
- *     - Prijimanie a desifrovanie suborov pomocou ChaCha20-Poly1305
+ *     - Prijimanie a desifrovanie suborov dohodnutou sadou (AES-256-GCM alebo XChaCha20-Poly1305)
  *     - Overovanie integrity prijatych dat cez Poly1305 MAC
  *     - Podporu pravidelnej rotacie klucov pocas prenosu
  *     - Dopredna ochrana pomocou jednosmernych hashovacich funkcii
@@ -20,8 +25,10 @@
  *     - siete.h (sietova komunikacia)
  *     - crypto_utils.h (kryptograficke operacie)
  *     - constants.h (konstanty programu)
- *     - sake.h (pre SAKE protokol)
  *     - platform.h (platform-specificke funkcie)
+ *     - reactor.h (obsluha spojeni, SAKE protokol a prijimanie suborov)
+ *     - kdf_scheduler.h (planovac odvodenia klucov)
+ *     - credentials.h (uloziste prihlasovacich udajov)
  *******************************************************************************/
 
 // Systemove kniznice
@@ -29,414 +36,372 @@
 #include <stdlib.h> // Kniznica pre vseobecne funkcie (sprava pamate, konverzie, nahodne cisla)
 #include <string.h> // Kniznica pre pracu s retazcami (kopirovanie, porovnavanie, spajanie)
 #include <unistd.h> // Kniznica pre systemove volania UNIX (procesy, subory, sokety)
-
-#include "monocypher.h"   // Pre Monocypher kryptograficke funkcie
-#include "siete.h"        // Pre sietove funkcie
-#include "constants.h"    // Definicie konstant pre program
-#include "crypto_utils.h" // Pre kryptograficke funkcie
-#include "sake.h"         // Pre SAKE protokol
-#include "platform.h"     // Pre funkcie specificke pre operacny system
-
-// Globalne premenne pre kryptograficke operacie
-// Tieto premenne sa pouzivaju v celom programe pre desifrovacie operacie
-uint8_t key[KEY_SIZE];      // Hlavny sifrovaci kluc
-uint8_t nonce[NONCE_SIZE];  // Jednorazova hodnota pre kazdy blok
-uint8_t salt[SALT_SIZE];    // Sol pre derivaciu kluca
-sake_key_chain_t key_chain; // Struktura retazca klucov pre SAKE
-
-int main()
+#include <signal.h> // Kniznica pre signaly (zastavenie servera)
+
+#include "siete.h"         // Pre sietove funkcie
+#include "constants.h"     // Definicie konstant pre program
+#include "crypto_utils.h"  // Pre kryptograficke funkcie
+#include "platform.h"      // Pre funkcie specificke pre operacny system
+#include "reactor.h"       // Pre obsluhu vsetkych spojeni
+#include "kdf_scheduler.h" // Pre planovac odvodenia klucov
+#include "credentials.h"   // Pre uloziste prihlasovacich udajov
+
+// Jeden reaktor servera s vlastnym vlaknom, socketom a skupinami vlakien
+typedef struct
 {
-    // Inicializacia sietovych prvkov
-    int server_fd, client_socket;
-    struct sockaddr_in client_addr;
-    int port;
-    char port_str[6]; // Max 5 cislic + null terminator
+    reactor_t reactor;        // Reaktor a jeho spojenia
+    int server_fd;            // Pocuvajuci socket (bez SO_REUSEPORT spolocny pre vsetky reaktory)
+    int owns_socket;          // 1 ak socket patri tomuto reaktoru a treba ho zatvorit
+    int initialized;          // 1 ak bol reaktor spusteny
+    platform_thread_t thread; // Vlakno reaktora (prvy reaktor bezi v hlavnom vlakne)
+    int has_thread;           // 1 ak bolo vlakno spustene
+    int result;               // Vysledok reactor_run
+} server_shard_t;
+
+// Poziadavka na zastavenie servera (nastavi ju obsluha SIGINT alebo SIGTERM)
+static volatile sig_atomic_t stop_requested = 0;
+
+// Obsluha signalu iba nastavi priznak, reaktor ho zisti najneskor po REACTOR_TICK_MS
+static void request_stop(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
 
-    // Inicializacia Winsock pre Windows platformu
-    initialize_network();
+// Kladne cislo z prepinaca option (1 az max), bez prepinaca ostane predvolena hodnota v *value
+// Ak auto_value nie je 0, hodnota auto znamena auto_value (napriklad jeden reaktor na procesor)
+// Navratova hodnota: 0 pri uspechu, -1 pri neplatnej hodnote
+static int server_count_from_args(unsigned *value, const char *option, unsigned max, unsigned auto_value,
+                                  int argc, char *argv[])
+{
+    size_t option_len = strlen(option);
 
-    // Ziadanie cisla portu od uzivatela
-    printf(PORT_PROMPT);
-    if (fgets(port_str, sizeof(port_str), stdin) == NULL)
+    for (int i = 1; i < argc; i++)
     {
-        fprintf(stderr, ERR_PORT_READ);
-        cleanup_network();
-        return -1;
+        if (strncmp(argv[i], option, option_len) != 0)
+        {
+            continue;
+        }
+        const char *text = argv[i] + option_len;
+        if (auto_value != 0 && strcmp(text, SERVER_SHARDS_AUTO) == 0)
+        {
+            *value = auto_value;
+            continue;
+        }
+        char *end;
+        unsigned long count = strtoul(text, &end, 10);
+        if (end == text || *end != '\0' || count < 1 || count > max)
+        {
+            fprintf(stderr, ERR_COUNT_OPTION, text, option, max, (auto_value != 0) ? " or auto" : "");
+            return -1;
+        }
+        *value = (unsigned)count;
     }
+    return 0;
+}
 
-    // Konverzia portu na integer a validacia
-    char *endptr;
-    long port_long = strtol(port_str, &endptr, 10);
-    if (endptr == port_str || *endptr != '\n' || port_long < 1 || port_long > 65535)
+// Hodnota textoveho prepinaca option (pri opakovani plati posledny)
+// Navratova hodnota: text za prepinacom alebo NULL, ak prepinac chyba
+static const char *server_string_from_args(const char *option, int argc, char *argv[])
+{
+    size_t option_len = strlen(option);
+    const char *value = NULL;
+
+    for (int i = 1; i < argc; i++)
     {
-        fprintf(stderr, ERR_PORT_INVALID);
-        cleanup_network();
-        return -1;
+        if (strncmp(argv[i], option, option_len) == 0 && argv[i][option_len] != '\0')
+        {
+            value = argv[i] + option_len;
+        }
     }
-    port = (int)port_long;
+    return value;
+}
 
-    // Vytvorenie a konfiguracia servera
-    if ((server_fd = setup_server(port)) < 0)
+// Vymazanie spolocneho hesla (ak bolo zadane) a zatvorenie uloziska prihlasovacich udajov
+static void server_secrets_free(char *password, credential_store_t *credentials)
+{
+    if (password != NULL)
     {
-        // Vypis chyby, ak sa nepodari nastavit serverovy socket
-        fprintf(stderr, ERR_SOCKET_SETUP, port, strerror(errno));
-        cleanup_network();
-        return -1;
+        secure_wipe(password, strlen(password));
     }
+    credentials_close(credentials);
+}
 
-    printf(LOG_SERVER_START, port);
-
-    // Cakanie na pripojenie klienta
-    if ((client_socket = accept_client_connection(server_fd, &client_addr)) < 0)
+// Vlakno dalsieho reaktora - chyba jedneho reaktora zastavi cely server
+static void shard_thread(void *arg)
+{
+    server_shard_t *shard = (server_shard_t *)arg;
+    shard->result = reactor_run(&shard->reactor, &stop_requested);
+    if (shard->result != 0)
     {
-        // Vypis chyby, ak sa nepodari prijat klientske spojenie
-        fprintf(stderr, ERR_CLIENT_ACCEPT, strerror(errno));
-        cleanup_sockets(-1, server_fd); // Upratanie serveroveho socketu
-        cleanup_network();
-        return -1;
+        stop_requested = 1;
     }
-    
-    // Inicializacia bezpecneho spojenia
-    if (send_ready_signal(client_socket) < 0)
+}
+
+// Ukoncenie reaktorov (po zastaveni ich vlakien) a zatvorenie ich socketov
+static void shards_free(server_shard_t *shards, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
     {
-        // Vypis chyby, ak zlyha odoslanie signalu pripravenosti
-        fprintf(stderr, ERR_HANDSHAKE);
-        cleanup_sockets(client_socket, server_fd);
-        cleanup_network();
-        return -1;
+        if (shards[i].has_thread)
+        {
+            platform_thread_join(&shards[i].thread);
+        }
+        if (shards[i].initialized)
+        {
+            reactor_free(&shards[i].reactor);
+        }
+        if (shards[i].owns_socket)
+        {
+            SOCKET_CLOSE(shards[i].server_fd);
+        }
     }
+    free(shards);
+}
+
+int main(int argc, char *argv[])
+{
+    // Inicializacia sietovych prvkov
+    int port;
+    char port_str[6]; // Max 5 cislic + null terminator
 
-    // Prijatie soli od klienta
-    uint8_t salt[SALT_SIZE];
-    if (receive_salt(client_socket, salt) < 0)
+    // Vypisy spojeni po riadkoch aj ked je vystup presmerovany do suboru (inak by cakali v bufferi)
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Vyber a overenie kryptografickych jadier este pred spustenim servera
+    if (select_crypto_impl(argc, argv) != 0)
     {
-        fprintf(stderr, ERR_SALT_RECEIVE);
-        cleanup_sockets(client_socket, server_fd);
         return -1;
     }
 
-    // Nacitanie hesla od uzivatela a odvodenie hlavneho kluca pomocou Argon2
-    // Heslo sa pouzije na generovanie kluca, ktory sa pouzije na sifrovanie dat
-    char *password = platform_getpass(PASSWORD_PROMPT);
-    if (derive_key_server(password, salt, key, salt) != 0)
+    // Pravidla rotacie kluca (predvolene alebo z prepinacov --rotate-*), prisnejsie z navrhov sa pouziju
+    rotation_policy_t rotation;
+    if (rotation_policy_from_args(&rotation, argc, argv) != 0)
     {
-        fprintf(stderr, ERR_KEY_DERIVATION);
-        cleanup_sockets(client_socket, server_fd);
         return -1;
     }
 
-    // Odoslanie potvrdenia kluca klientovi
-    if (send_key_acknowledgment(client_socket) < 0)
+    // Pocet reaktorov (--shards=N alebo --shards=auto = jeden na procesor), predvolene jeden
+    // Rozpocet pamate a pocet sucasnych odvodeni kluca su spolocne pre vsetky reaktory
+    unsigned cpus = platform_cpu_count();
+    unsigned nb_shards = 1;
+    unsigned kdf_memory_mib = KDF_MEMORY_MIB;
+    unsigned kdf_concurrency = KDF_CONCURRENCY;
+    if (server_count_from_args(&nb_shards, SERVER_SHARDS_OPTION, SERVER_MAX_SHARDS,
+                               (cpus > SERVER_MAX_SHARDS) ? SERVER_MAX_SHARDS : cpus, argc, argv) != 0 ||
+        server_count_from_args(&kdf_memory_mib, KDF_MEMORY_OPTION, KDF_MAX_MEMORY_MIB, 0, argc, argv) != 0 ||
+        server_count_from_args(&kdf_concurrency, KDF_CONCURRENCY_OPTION, TASK_POOL_MAX_THREADS, 0, argc, argv) != 0)
     {
-        fprintf(stderr, ERR_KEY_ACK);
-        cleanup_sockets(client_socket, server_fd);
         return -1;
     }
 
-    // SAKE protokol - implementacia
-    uint8_t client_nonce[SAKE_NONCE_CLIENT_SIZE]; // Nonce vygenerované klientom
-    uint8_t server_nonce[SAKE_NONCE_SERVER_SIZE]; // Nonce prijate od servera
-    uint8_t challenge[SAKE_CHALLENGE_SIZE];       // VYzva prijata od servera
-    uint8_t response[SAKE_RESPONSE_SIZE];         // Odpoved vypocitana na vyzvu
-    uint8_t session_key[SESSION_KEY_SIZE];        // Kluc relacie
-
-    // Inicializacia SAKE key chain pre server (responder)
-    // Odvodi authentication key z master key
-    sake_init_key_chain(&key_chain, key, 0); // 0 = responder
-
-    // Prijatie nonce od klienta
-    if (recv_all(client_socket, client_nonce, SAKE_NONCE_CLIENT_SIZE) != SAKE_NONCE_CLIENT_SIZE)
+    // Uloziste prihlasovacich udajov (--credentials=subor), s --build-credentials=zoznam ho
+    // server iba vytvori zo zoznamu riadkov id:heslo a skonci
+    const char *credentials_path = server_string_from_args(CREDENTIALS_OPTION, argc, argv);
+    const char *build_path = server_string_from_args(CREDENTIALS_BUILD_OPTION, argc, argv);
+    if (build_path != NULL)
     {
-        fprintf(stderr, ERR_RECEIVE_CLIENT_NONCE);
-        cleanup_sockets(client_socket, server_fd);
-        return -1;
+        uint32_t built;
+        if (credentials_path == NULL)
+        {
+            fprintf(stderr, ERR_CREDENTIALS_OPTION);
+            return -1;
+        }
+        if (credentials_build(build_path, credentials_path, &built) != 0)
+        {
+            return -1;
+        }
+        printf(MSG_CREDENTIALS_BUILT, built, credentials_path);
+        return 0;
     }
 
-    // Generovanie vyzvy a nonce servera - pouzivame aktualny authentication key
-    generate_challenge(challenge, server_nonce, key_chain.auth_key_curr, client_nonce);
+    // Inicializacia Winsock pre Windows platformu
+    initialize_network();
 
-    // Odoslanie nonce servera a vyzvy klientovi
-    if (send_all(client_socket, server_nonce, SAKE_NONCE_SERVER_SIZE) != SAKE_NONCE_SERVER_SIZE ||
-        send_all(client_socket, challenge, SAKE_CHALLENGE_SIZE) != SAKE_CHALLENGE_SIZE)
+    // Ziadanie cisla portu od uzivatela
+    printf(PORT_PROMPT);
+    if (fgets(port_str, sizeof(port_str), stdin) == NULL)
     {
-        fprintf(stderr, ERR_SEND_CHALLENGE);
-        cleanup_sockets(client_socket, server_fd);
+        fprintf(stderr, ERR_PORT_READ);
+        cleanup_network();
         return -1;
     }
 
-    // Prijatie odpovede od klienta
-    if (recv_all(client_socket, response, SAKE_RESPONSE_SIZE) != SAKE_RESPONSE_SIZE)
+    // Konverzia portu na integer a validacia
+    char *endptr;
+    long port_long = strtol(port_str, &endptr, 10);
+    if (endptr == port_str || *endptr != '\n' || port_long < 1 || port_long > 65535)
     {
-        fprintf(stderr, ERR_RECEIVE_RESPONSE);
-        cleanup_sockets(client_socket, server_fd);
+        fprintf(stderr, ERR_PORT_INVALID);
+        cleanup_network();
         return -1;
     }
+    port = (int)port_long;
 
-    // Overenie odpovede - pouzivame aktualny authentication key
-    if (verify_response(response, key_chain.auth_key_curr, challenge, server_nonce) != 0)
+    // S ulozistom ma kazdy klient vlastne PSK a server sa na heslo nepyta
+    // Bez neho sa spolocne heslo nacita raz pri spusteni - PSK sa z neho odvodi pre identifikator klienta
+    // V oboch pripadoch kazde spojenie odvodi vlastny kluc so solou klienta
+    // Sol pre PSK z hesiel je v hlavicke uloziska, pre spolocne heslo sa vytvori nova pri kazdom spusteni
+    credential_store_t credentials;
+    char *password = NULL;
+    uint8_t psk_salt[SALT_SIZE];
+    memset(&credentials, 0, sizeof(credentials));
+    if (credentials_path != NULL)
     {
-        // Vypis specifickejsej chybovej hlasky pri zlyhani overenia
-        // Naznacuje mozne nespravne heslo alebo MitM utok
-        fprintf(stderr, ERR_SAKE_MITM_SUSPECTED_SERVER);
-
-        // Odoslanie klientovi informacie o zlyhani autentizacie
-        uint8_t auth_result = AUTH_FAILED;
-        send_all(client_socket, &auth_result, 1); // Ignorujeme navratovu hodnotu, spojenie sa aj tak ukonci
-
-        cleanup_sockets(client_socket, server_fd);
-        return -1;
+        if (credentials_open(&credentials, credentials_path) != 0)
+        {
+            cleanup_network();
+            return -1;
+        }
+        printf(MSG_CREDENTIALS_LOADED, credentials.count, credentials_path);
+        memcpy(psk_salt, credentials.psk_salt, SALT_SIZE);
+    }
+    else
+    {
+        password = platform_getpass(PASSWORD_PROMPT);
+        generate_random_bytes(psk_salt, SALT_SIZE);
     }
 
-    // Odoslanie klientovi potvrdenia o uspesnej autentizacii
-    uint8_t auth_result = AUTH_SUCCESS;
-    if (send_all(client_socket, &auth_result, 1) != 1)
+    // Planovac odvodenia klucov - pracovne pamate Argon2 sa alokuju raz, nalet klientov caka vo fronte
+    kdf_scheduler_t kdf;
+    if (kdf_scheduler_init(&kdf, kdf_memory_mib, kdf_concurrency) != 0)
     {
-        fprintf(stderr, ERR_AUTH_CONFIRMATION);
-        cleanup_sockets(client_socket, server_fd);
+        server_secrets_free(password, &credentials);
+        cleanup_network();
         return -1;
     }
 
-    // Odvodenie kluca relacie z hlavneho kluca
-    derive_session_key(session_key, key_chain.master_key, client_nonce, server_nonce);
-
-    // Evolucia klucov po uspesnej autentizacii
-    sake_update_key_chain(&key_chain);
-
-    printf(LOG_SESSION_COMPLETE);
-
-    // Nastavenie casovaceho limitu pre prijem nazvu suboru
-    set_socket_timeout(client_socket, WAIT_FILE_NAME);
-
-    char file_name[FILE_NAME_BUFFER_SIZE];
-    if (receive_file_name(client_socket, file_name, sizeof(file_name)) < 0)
+    server_shard_t *shards = calloc(nb_shards, sizeof(server_shard_t));
+    if (shards == NULL)
     {
-        fprintf(stderr, ERR_FILENAME_RECEIVE, strerror(errno));
-        cleanup_sockets(client_socket, server_fd);
+        fprintf(stderr, ERR_REACTOR_INIT);
+        kdf_scheduler_free(&kdf);
+        server_secrets_free(password, &credentials);
+        cleanup_network();
         return -1;
     }
 
-    // Resetovanie casovaceho limitu na mensiu hodnotu pre prenos dat
-    set_socket_timeout(client_socket, SOCKET_TIMEOUT_MS);
-
-    // Spracovanie novo prijateho suboru
-    // Vytvorenie noveho nazvu suboru pridanim predpony 'received_'
-    char new_file_name[NEW_FILE_NAME_BUFFER_SIZE];
-    snprintf(new_file_name, sizeof(new_file_name), "%s%s", FILE_PREFIX, file_name);
-
-    // Otvorenie noveho suboru pre binarny zapis
-    // Kontrola uspesnosti vytvorenia suboru
-    FILE *file = fopen(new_file_name, FILE_MODE_WRITE);
-    if (!file)
+    // Vytvorenie a konfiguracia servera
+    // Pri viacerych reaktoroch ma kazdy vlastny socket na tom istom porte (SO_REUSEPORT),
+    // bez tejto moznosti (Windows) vsetky sleduju jeden spolocny socket
+    int reuse_port = (nb_shards > 1);
+    int first_fd = setup_server(port, reuse_port);
+    if (first_fd < 0 && reuse_port)
     {
-        fprintf(stderr, ERR_FILE_CREATE, new_file_name, strerror(errno));
-        cleanup_sockets(client_socket, server_fd);
+        reuse_port = 0;
+        first_fd = setup_server(port, 0);
+    }
+    if (first_fd < 0)
+    {
+        // Vypis chyby, ak sa nepodari nastavit serverovy socket
+        fprintf(stderr, ERR_SOCKET_SETUP, port, strerror(errno));
+        free(shards);
+        kdf_scheduler_free(&kdf);
+        server_secrets_free(password, &credentials);
+        cleanup_network();
         return -1;
     }
 
-    // Inicializacia premennych pre sledovanie prenosu
-    uint64_t total_bytes = 0;  // Celkovy pocet prijatych bajtov
-    int transfer_complete = 0; // Stav prenosu (0 = prebieha, 1 = uspesne dokonceny, -1 = chyba)
-
-    printf(LOG_TRANSFER_START);
-
-    // Buffery pre prenos dat
-    // ciphertext: Zasifrovane data z klienta
-    // plaintext: Desifrovane data pre zapis
-    // tag: Autentizacny tag pre overenie integrity
-    uint8_t ciphertext[TRANSFER_BUFFER_SIZE]; // Buffer pre zasifrovane data
-    uint8_t plaintext[TRANSFER_BUFFER_SIZE];  // Buffer pre desifrovane data
-    uint8_t tag[TAG_SIZE];                    // Buffer pre autentizacny tag
-
-    // Prenos suboru s rotaciou klucov
-    uint64_t block_count = 0;
-    uint8_t buffer[TRANSFER_BUFFER_SIZE];
-
-    // Premenna pre sledovanie postupu
-    uint64_t last_progress_update = 0;
+    // Vlakna pre vypocty sa delia medzi reaktory, spolu ich je priblizne tolko ako procesorov
+    reactor_config_t config;
+    config.credentials = (credentials_path != NULL) ? &credentials : NULL;
+    config.password = password;
+    config.psk_salt = psk_salt;
+    config.rotation = rotation;
+    config.crypto_threads = (cpus / nb_shards > 0) ? cpus / nb_shards : 1;
+    if (config.crypto_threads > PIPELINE_MAX_WORKERS)
+    {
+        config.crypto_threads = PIPELINE_MAX_WORKERS;
+    }
+    config.kdf = &kdf;
+    config.shards = nb_shards;
 
-    // Hlavny cyklus prenosu dat
-    while (!transfer_complete)
+    // Reaktory - kazdy v jednom vlakne obsluhuje svoje spojenia, desifrovanie blokov robi jeho
+    // skupina vlakien; pocuvajuce sockety su neblokujuce, spojenia prijima reaktor
+    int failed = 0;
+    for (unsigned i = 0; i < nb_shards && !failed; i++)
     {
-        uint32_t chunk_size;
-        if (receive_chunk_size_reliable(client_socket, &chunk_size) < 0)
+        server_shard_t *shard = &shards[i];
+        shard->server_fd = (i == 0) ? first_fd : (reuse_port ? setup_server(port, 1) : first_fd);
+        shard->owns_socket = (i == 0 || reuse_port);
+        if (shard->server_fd < 0)
         {
-            fprintf(stderr, ERR_CHUNK_SIZE);
-            transfer_complete = -1;
-            break;
+            fprintf(stderr, ERR_SOCKET_SETUP, port, strerror(errno));
+            shard->owns_socket = 0;
+            failed = 1;
         }
-
-        // Overeenie, ci je prijaty blok velkosti 0, co znamena koniec suboru (EOF)
-        if (chunk_size == 0)
+        else if (shard->owns_socket && set_socket_nonblocking(shard->server_fd) != 0)
         {
-            printf("\n");
-            printf(LOG_TRANSFER_COMPLETE);
-            if (send_transfer_ack(client_socket) == 0)
-            {
-                transfer_complete = 1;
-            }
-            break;
+            fprintf(stderr, ERR_SOCKET_NONBLOCKING);
+            failed = 1;
         }
-
-        // Spracovanie markera rotacie kluca
-        if (chunk_size == KEY_ROTATION_MARKER)
+        else
         {
-            printf(MSG_KEY_ROTATION, (unsigned long long)block_count);
-
-            if (send_chunk_size_reliable(client_socket, KEY_ROTATION_ACK) < 0)
-            {
-                fprintf(stderr, ERR_KEY_ROTATION_ACK);
-                transfer_complete = -1;
-                break;
-            }
-
-            // Prijatie noveho client nonce
-            uint8_t new_client_nonce[SAKE_NONCE_CLIENT_SIZE];
-            if (recv_all(client_socket, new_client_nonce, SAKE_NONCE_CLIENT_SIZE) != SAKE_NONCE_CLIENT_SIZE)
-            {
-                fprintf(stderr, "Error: Failed to receive new client nonce\n");
-                transfer_complete = -1;
-                break;
-            }
-
-            // Generovanie noveho server nonce
-            uint8_t new_server_nonce[SAKE_NONCE_SERVER_SIZE];
-            generate_random_bytes(new_server_nonce, SAKE_NONCE_SERVER_SIZE);
-
-            // Odosielanie noveho server nonce
-            if (send_all(client_socket, new_server_nonce, SAKE_NONCE_SERVER_SIZE) != SAKE_NONCE_SERVER_SIZE)
-            {
-                fprintf(stderr, "Error: Failed to send new server nonce\n");
-                transfer_complete = -1;
-                break;
-            }
-
-            // Validacia rotacie kluca
-            uint32_t signal;
-            // Prijatie signalu pre validaciu rotacie kluca od klienta
-            if (receive_chunk_size_reliable(client_socket, &signal) < 0 ||
-                signal != KEY_ROTATION_VALIDATE)
-            {
-                fprintf(stderr, ERR_KEY_VALIDATE_SIGNAL);
-                transfer_complete = -1;
-                break;
-            }
-
-            uint8_t previous_session_key[KEY_SIZE];
-            // Zalohovanie aktualneho kluca pred rotaciou
-            memcpy(previous_session_key, session_key, KEY_SIZE);
-
-            // Pre session key pouzivame aktualizovany master key a nove nonce hodnoty
-            derive_session_key(session_key, key_chain.master_key, new_client_nonce, new_server_nonce);
-
-            // Aktualizacia client_nonce a server_nonce pre ďalšie pouzitie
-            memcpy(client_nonce, new_client_nonce, SAKE_NONCE_CLIENT_SIZE);
-            memcpy(server_nonce, new_server_nonce, SAKE_NONCE_SERVER_SIZE);
-
-            // Kontrola validacie kluca
-            uint8_t client_validation[VALIDATION_SIZE];
-            uint8_t our_validation[VALIDATION_SIZE];
-
-            // Prijatie validacneho kodu od klienta, ktory bol vytvoreny pomocou noveho kluca
-            if (recv_all(client_socket, client_validation, VALIDATION_SIZE) != VALIDATION_SIZE)
-            {
-                fprintf(stderr, ERR_KEY_VALIDATE_RECEIVE);
-                transfer_complete = -1;
-                break;
-            }
-
-            // Vytvorenie vlastneho validacneho kodu pouzitim rovnakeho algoritmu ako klient
-            generate_key_validation(our_validation, session_key);
-            // Porovnanie validacnych kodov - ak sa nezhoduju, kluce nie su synchronizovane
-            if (memcmp(client_validation, our_validation, VALIDATION_SIZE) != 0)
-            {
-                fprintf(stderr, ERR_KEY_VALIDATE_MISMATCH);
-                transfer_complete = -1;
-                break;
-            }
-
-            // Bezpecne vymazanie stareho kluca z pamate
-            secure_wipe(previous_session_key, KEY_SIZE);
-
-            // Odoslanie potvrdenia klientovi, ze server je pripraveny pokracovat s novym klucom
-            if (send_chunk_size_reliable(client_socket, KEY_ROTATION_READY) < 0)
-            {
-                fprintf(stderr, ERR_KEY_ROTATION_READY);
-                transfer_complete = -1;
-                break;
-            }
-            // Kratka pauza pre stabilizaciu komunikacie
-            wait();
-            continue;
+            config.shard = i;
+            shard->initialized = (reactor_init(&shard->reactor, shard->server_fd, &config) == 0);
+            failed = !shard->initialized;
         }
+    }
+    if (failed)
+    {
+        shards_free(shards, nb_shards);
+        kdf_scheduler_free(&kdf);
+        server_secrets_free(password, &credentials);
+        cleanup_network();
+        return -1;
+    }
 
-        // Spracovanie bloku dat a aktualizacia postupu
-        // Prijatie zasifrovaneho bloku dat od klienta
-        // - nonce: jednorazova hodnota pouzita pre tento blok
-        // - tag: autentizacny tag na overenie integrity
-        // - ciphertext: zasifrovane data
-        if (receive_encrypted_chunk(client_socket, nonce, tag, ciphertext, chunk_size) < 0)
-        {
-            fprintf(stderr, ERR_RECEIVE_ENCRYPTED_CHUNK);
-            break;
-        }
+    // Server bezi, kym ho nezastavi SIGINT (Ctrl+C) alebo SIGTERM
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
 
-        // Desifrovanie a autentizacia prijatych dat pomocou aktualneho kluca relacie
-        if (crypto_aead_unlock(plaintext, tag, session_key, nonce, NULL, 0, ciphertext, chunk_size) != 0)
-        {
-            fprintf(stderr, ERR_DECRYPT_CHUNK_AUTH);
-            break;
-        }
-
-        // Zapis desifrovanych dat do vystupneho suboru
-        if (fwrite(plaintext, 1, chunk_size, file) != chunk_size)
+    printf(LOG_SERVER_START, port);
+    printf(MSG_SERVER_SHARDS, nb_shards, config.crypto_threads);
+    printf(MSG_KDF_SCHEDULER, kdf.nb_areas, (unsigned)((kdf.nb_areas * ARGON2_WORK_AREA_SIZE) >> 20),
+           platform_pages_name(kdf.pages), kdf.queue_limit);
+    fflush(stdout);
+
+    // Hlavny cyklus servera
+    // Kazde spojenie prechadza nadviazanim spojenia (parametre, sol, Argon2, SAKE) a prijimanim blokov
+    // Bloky vsetkych spojeni overuju a desifruju spolocne vlakna, kazde spojenie zapisuje svoj subor
+    // Chyba alebo nespravne heslo ukonci iba dane spojenie, server bezi dalej
+    // Dalsie reaktory bezia vo vlastnych vlaknach, prvy v hlavnom vlakne
+    for (unsigned i = 1; i < nb_shards; i++)
+    {
+        shards[i].has_thread = (platform_thread_create(&shards[i].thread, shard_thread, &shards[i]) == 0);
+        if (!shards[i].has_thread)
         {
-            fprintf(stderr, ERR_WRITE_TO_FILE);
+            fprintf(stderr, ERR_REACTOR_THREAD);
+            stop_requested = 1;
             break;
         }
-
-        // Aktualizacia pocitadiel pre sledovanie prenosu
-        total_bytes += chunk_size;
-        block_count++;
-
-        // Aktualizacia postupu prenosu do konzoly
-        if (total_bytes - last_progress_update >= PROGRESS_UPDATE_INTERVAL)
-        {
-            printf(LOG_PROGRESS_FORMAT, "Received", (float)total_bytes / PROGRESS_UPDATE_INTERVAL);
-            fflush(stdout);
-            last_progress_update = total_bytes;
-        }
-    }
-
-    // Finalna sprava o stave prenosu s celkovym poctom prijatych dat
-    if (transfer_complete == 1)
-    {
-        printf(LOG_SUCCESS_FORMAT, "received", (float)total_bytes / PROGRESS_UPDATE_INTERVAL);
     }
-    else
+    int result = reactor_run(&shards[0].reactor, &stop_requested);
+    stop_requested = 1;
+    for (unsigned i = 1; i < nb_shards; i++)
     {
-        fprintf(stderr, ERR_TRANSFER_INTERRUPTED);
+        if (shards[i].has_thread)
+        {
+            platform_thread_join(&shards[i].thread);
+            shards[i].has_thread = 0;
+            result = (shards[i].result != 0) ? shards[i].result : result;
+        }
     }
 
     // Ukoncenie a cistenie
-    // - Zatvorenie vystupneho suboru
-    // - Uvolnenie sietovych prostriedkov
-    // - Navrat s kodom podla uspesnosti prenosu
-    if (file != NULL)
-    {
-        fclose(file);
-    }
-    cleanup_sockets(client_socket, server_fd);
+    // - Bezijuce odvodenia sa dokoncia, cakajuce sa zrusia (reaktory musia este existovat)
+    // - Vlakna dokoncia rozpracovane ulohy, nedokoncene prenosy sa zatvoria
+    // - Uvolnenie sietovych prostriedkov, vymazanie hesla a zatvorenie uloziska
+    kdf_stats_t stats;
+    kdf_scheduler_stats(&kdf, &stats);
+    kdf_scheduler_free(&kdf);
+    shards_free(shards, nb_shards);
     cleanup_network();
+    server_secrets_free(password, &credentials);
+    printf(MSG_KDF_STATS, (unsigned long long)stats.completed, (unsigned long long)stats.rejected,
+           (unsigned long long)(stats.completed > 0 ? stats.total_wait_ms / stats.completed : 0),
+           (unsigned long long)stats.max_wait_ms, stats.max_queued);
+    printf(MSG_SERVER_STOP);
 
-    // Bezpecne vymazanie citlivych dat z pamate
-    secure_wipe(key, KEY_SIZE);
-    secure_wipe(session_key, KEY_SIZE);
-    secure_wipe(buffer, TRANSFER_BUFFER_SIZE);
-    secure_wipe(plaintext, TRANSFER_BUFFER_SIZE);
-    secure_wipe(tag, TAG_SIZE);
-
-    // Vymazanie key chain
-    secure_wipe(&key_chain, sizeof(key_chain));
-
-    return (transfer_complete == 1) ? 0 : -1;
+    return result;
 }
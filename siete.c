@@ -13,6 +13,8 @@
  *     - Platformovo-nezavisle sietove operacie (Windows/Linux)
  *     - Obsluha timeoutov a chybovych stavov
  *     - Implementacia potvrdzovacieho protokolu pre spolahlivy prenos
+ *     - Dohodnutie parametrov relacie (pocet liniek Argon2)
+ *     - Ramcovanie blokov: vektorove odosielanie a rozklad prijatych hlaviciek
  *
  * Zavislosti:
  *     - siete.h (deklaracie sietovych funkcii)
@@ -86,7 +88,7 @@ void set_timeout_options(int sock)
 // - Vytvori socket
 // - Nastavi adresu a port
 // - Zacne pocuvat na porte
-int setup_server(int port)
+int setup_server(int port, int reuse_port)
 {
     // Server socket, ktory pocuva na urcitej adrese
     int server_fd;
@@ -110,6 +112,15 @@ int setup_server(int port)
     address.sin_addr.s_addr = INADDR_ANY; // 0.0.0.0 - vsetky dostupne adresy
     address.sin_port = htons(port);       // Prevedieme cislo portu do sietoveho formatu
 
+    // S reuse_port moze na porte pocuvat viac socketov (jeden na reaktor),
+    // jadro medzi ne rozdeluje nove spojenia
+    if (reuse_port && SET_REUSEPORT(server_fd) != 0)
+    {
+        fprintf(stderr, ERR_SOCKET_REUSEPORT);
+        SOCKET_CLOSE(server_fd);
+        return -1;
+    }
+
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
     {
         fprintf(stderr, ERR_SOCKET_BIND, strerror(errno));
@@ -135,7 +146,11 @@ int accept_client_connection(int server_fd, struct sockaddr_in *client_addr)
 
     if (new_socket < 0)
     {
-        fprintf(stderr, ERR_SOCKET_ACCEPT);
+        // Neblokujuci server socket bez cakajuceho spojenia nie je chyba
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            fprintf(stderr, ERR_SOCKET_ACCEPT);
+        }
         return -1;
     }
 
@@ -150,17 +165,6 @@ int accept_client_connection(int server_fd, struct sockaddr_in *client_addr)
 
 // Funkcie pre prenos dat
 
-// Odoslanie signalu pripravenosti klientovi
-int send_ready_signal(int socket)
-{
-    if (send(socket, MAGIC_READY, SIGNAL_SIZE, 0) != SIGNAL_SIZE)
-    {
-        fprintf(stderr, ERR_READY_SIGNAL);
-        return -1;
-    }
-    return 0;
-}
-
 // Vytvorenie spojenia so serverom
 // - Vytvori socket
 // - Pripoji sa na zadanu adresu
@@ -195,16 +199,78 @@ int connect_to_server(const char *address, int port)
 
 // Funkcie pre prenos kryptografickych materialov
 
-// Prijatie kryptografickej soli od klienta
-int receive_salt(int socket, uint8_t *salt)
+// Odoslanie identifikatora klienta (CLIENT_ID_SIZE bajtov z client_id_encode) a kryptografickej soli serveru
+// Server podla identifikatora vyberie PSK klienta, zo soli odvodi rovnaky kluc
+int send_salt_to_server(int socket, const uint8_t *client_id, const uint8_t *salt)
+{
+    uint8_t message[CLIENT_ID_SIZE + SALT_SIZE];
+    memcpy(message, client_id, CLIENT_ID_SIZE);
+    memcpy(message + CLIENT_ID_SIZE, salt, SALT_SIZE);
+    return (send_all(socket, message, sizeof(message)) == sizeof(message)) ? 0 : -1;
+}
+
+// Prijatie soli pre PSK z hesla (SALT_SIZE bajtov), server ju posiela hned po parametroch relacie
+// Zmenena sol po ceste da ine PSK a handshake zlyha pri overeni SAKE
+int receive_psk_salt(int socket, uint8_t *psk_salt)
+{
+    if (recv_all(socket, psk_salt, SALT_SIZE) != SALT_SIZE)
+    {
+        fprintf(stderr, ERR_PSK_SALT_RECEIVE);
+        return -1;
+    }
+    return 0;
+}
+
+// Povoleny znak identifikatora klienta: tlacitelny, bez medzery a ':' (oddeluje heslo v zozname)
+static int client_id_char_valid(uint8_t c)
 {
-    return (RECV_DATA(socket, salt, SALT_SIZE) == SALT_SIZE) ? 0 : -1;
+    return c > ' ' && c <= '~' && c != ':';
 }
 
-// Odoslanie kryptografickej soli serveru
-int send_salt_to_server(int socket, const uint8_t *salt)
+// Zakoduje identifikator klienta do CLIENT_ID_SIZE bajtov (doplni nulami)
+// Navratova hodnota: 0 pri uspechu, -1 ak je identifikator prazdny, dlhy alebo ma nepovolene znaky
+int client_id_encode(const char *id, uint8_t *data)
 {
-    return (send(socket, (const char *)salt, SALT_SIZE, 0) == SALT_SIZE) ? 0 : -1;
+    size_t len = strlen(id);
+    if (len == 0 || len > CLIENT_ID_SIZE)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!client_id_char_valid((uint8_t)id[i]))
+        {
+            return -1;
+        }
+    }
+    memset(data, 0, CLIENT_ID_SIZE);
+    memcpy(data, id, len);
+    return 0;
+}
+
+// Dekoduje identifikator klienta z CLIENT_ID_SIZE bajtov do retazca (id ma CLIENT_ID_SIZE + 1 znakov)
+// Navratova hodnota: 0 pri uspechu, -1 ak sprava nie je platny identifikator
+int client_id_decode(const uint8_t *data, char *id)
+{
+    size_t len = 0;
+    while (len < CLIENT_ID_SIZE && data[len] != 0)
+    {
+        if (!client_id_char_valid(data[len]))
+        {
+            return -1;
+        }
+        len++;
+    }
+    for (size_t i = len; i < CLIENT_ID_SIZE; i++)
+    {
+        if (data[i] != 0)
+        {
+            return -1;
+        }
+    }
+    memcpy(id, data, len);
+    id[len] = '\0';
+    return (len > 0) ? 0 : -1;
 }
 
 // Funkcie pre synchronizaciu
@@ -241,15 +307,136 @@ int wait_for_key_acknowledgment(int socket)
     return 0;
 }
 
-// Funkcia posle potvrdenie uspesneho prijatia kluca
-int send_key_acknowledgment(int socket)
+// Funkcie pre dohodnutie parametrov relacie
+
+// Zakoduje parametre relacie do SESSION_PARAMS_WIRE_SIZE bajtov v sietovom poradi
+void session_params_encode(const session_params_t *params, uint8_t *data)
+{
+    uint32_t wire[SESSION_PARAMS_WIRE_SIZE / 4];
+    wire[0] = htonl(params->argon2_lanes);
+    wire[1] = htonl(params->cipher_suites);
+    wire[2] = htonl(params->frame_size);
+    wire[3] = htonl(params->rotation.frames);
+    wire[4] = htonl(params->rotation.mib);
+    wire[5] = htonl(params->rotation.ms);
+    memcpy(data, wire, SESSION_PARAMS_WIRE_SIZE);
+}
+
+// Dekoduje parametre relacie a overi, ze su v povolenom rozsahu
+int session_params_decode(const uint8_t *data, session_params_t *params)
+{
+    uint32_t wire[SESSION_PARAMS_WIRE_SIZE / 4];
+    memcpy(wire, data, SESSION_PARAMS_WIRE_SIZE);
+    params->argon2_lanes = ntohl(wire[0]);
+    params->cipher_suites = ntohl(wire[1]);
+    params->frame_size = ntohl(wire[2]);
+    params->rotation.frames = ntohl(wire[3]);
+    params->rotation.mib = ntohl(wire[4]);
+    params->rotation.ms = ntohl(wire[5]);
+
+    if (params->argon2_lanes < ARGON2_MIN_LANES || params->argon2_lanes > ARGON2_MAX_LANES ||
+        params->cipher_suites == 0 || (params->cipher_suites & ~CIPHER_SUITES_KNOWN) != 0 ||
+        params->frame_size < FRAME_SIZE_MIN || params->frame_size > FRAME_SIZE_MAX ||
+        (params->rotation.frames == 0 && params->rotation.mib == 0 && params->rotation.ms == 0))
+    {
+        fprintf(stderr, ERR_PARAMS_INVALID);
+        return -1;
+    }
+    return 0;
+}
+
+// Posle parametre relacie v sietovom poradi bytov (zakodovane ostanu vo wire)
+static int send_session_params(int socket, const session_params_t *params, uint8_t *wire)
+{
+    session_params_encode(params, wire);
+    return (send_all(socket, wire, SESSION_PARAMS_WIRE_SIZE) == SESSION_PARAMS_WIRE_SIZE) ? 0 : -1;
+}
+
+// Prijme parametre relacie do wire a overi, ze su v povolenom rozsahu
+static int receive_session_params(int socket, session_params_t *params, uint8_t *wire)
+{
+    if (recv_all(socket, wire, SESSION_PARAMS_WIRE_SIZE) != SESSION_PARAMS_WIRE_SIZE)
+    {
+        fprintf(stderr, ERR_PARAMS_RECEIVE);
+        return -1;
+    }
+    return session_params_decode(wire, params);
+}
+
+// Limit rotacie kluca: prisnejsi z dvoch (mensi nenulovy), 0 znamena, ze sa limit nepouziva
+static uint32_t stricter_rotation_limit(uint32_t a, uint32_t b)
+{
+    if (a == 0)
+    {
+        return b;
+    }
+    return (b != 0 && b < a) ? b : a;
+}
+
+// Klient: posle navrh parametrov (params) a prepise ho hodnotami od servera
+// Server moze hodnoty iba znizit, nikdy nie zvysit nad navrh klienta,
+// musi vybrat prave jednu sifrovaciu sadu z tych, ktore klient ponukol
+// a nesmie zmiernit ziadny limit rotacie, ktory klient navrhol
+// Do transcript ulozi navrh aj odpoved tak, ako isli po sieti - SAKE ich potom potvrdi
+int negotiate_session_params_client(int socket, session_params_t *params, uint8_t *transcript)
+{
+    session_params_t agreed;
+    if (send_session_params(socket, params, transcript) < 0)
+    {
+        fprintf(stderr, ERR_PARAMS_SEND);
+        return -1;
+    }
+    if (receive_session_params(socket, &agreed, transcript + SESSION_PARAMS_WIRE_SIZE) < 0)
+    {
+        return -1;
+    }
+    if (agreed.argon2_lanes > params->argon2_lanes ||
+        agreed.frame_size > params->frame_size ||
+        (agreed.cipher_suites & (agreed.cipher_suites - 1)) != 0 ||
+        (agreed.cipher_suites & ~params->cipher_suites) != 0 ||
+        stricter_rotation_limit(agreed.rotation.frames, params->rotation.frames) != agreed.rotation.frames ||
+        stricter_rotation_limit(agreed.rotation.mib, params->rotation.mib) != agreed.rotation.mib ||
+        stricter_rotation_limit(agreed.rotation.ms, params->rotation.ms) != agreed.rotation.ms)
+    {
+        fprintf(stderr, ERR_PARAMS_INVALID);
+        return -1;
+    }
+    *params = agreed;
+    return 0;
+}
+
+// Server: porovna navrh klienta s vlastnymi moznostami (params) a prepise ich
+// hodnotami, ktore pouziju obe strany. Nic neposiela, preto ho moze pouzit aj reaktor
+int session_params_choose(const session_params_t *proposed_params, session_params_t *params)
 {
-    int result = send(socket, MAGIC_KEYOK, SIGNAL_SIZE, 0);
-    if (result != SIGNAL_SIZE)
+    const session_params_t proposed = *proposed_params;
+
+    // Pouzije sa mensi z oboch poctov liniek, aby ziadna strana nepocitala viac liniek nez ma jadier
+    if (proposed.argon2_lanes < params->argon2_lanes)
+    {
+        params->argon2_lanes = proposed.argon2_lanes;
+    }
+
+    // Velkost bloku: mensia z oboch navrhov, aby ziadna strana nedostala vacsi blok, nez ocakava
+    if (proposed.frame_size < params->frame_size)
+    {
+        params->frame_size = proposed.frame_size;
+    }
+
+    // Rotacia kluca: kazdy limit prisnejsi z oboch navrhov, aby ziadna strana nepouzila kluc dlhsie, nez chce
+    params->rotation.frames = stricter_rotation_limit(proposed.rotation.frames, params->rotation.frames);
+    params->rotation.mib = stricter_rotation_limit(proposed.rotation.mib, params->rotation.mib);
+    params->rotation.ms = stricter_rotation_limit(proposed.rotation.ms, params->rotation.ms);
+
+    // Zo spolocnych sifrovacich sad ma prednost AES-256-GCM (s AES-NI je rychlejsia)
+    uint32_t common = proposed.cipher_suites & params->cipher_suites;
+    if (common == 0)
     {
-        fprintf(stderr, ERR_KEY_ACK_SEND, result);
+        fprintf(stderr, ERR_CIPHER_SUITE);
         return -1;
     }
+    params->cipher_suites = (common & CIPHER_SUITE_AES256_GCM) ? CIPHER_SUITE_AES256_GCM
+                                                                : CIPHER_SUITE_XCHACHA20_POLY1305;
     return 0;
 }
 
@@ -260,6 +447,12 @@ void set_socket_timeout(int socket, int timeout_ms)
     SET_SOCKET_TIMEOUT(socket, timeout_ms);
 }
 
+// Prepne socket do neblokujuceho rezimu - recv a send vratia chybu EAGAIN namiesto cakania
+int set_socket_nonblocking(int socket)
+{
+    return SET_NONBLOCKING(socket);
+}
+
 // Vypne TCP bufferovanie pre okamzite odosielanie dat
 static void disable_tcp_buffering(int socket)
 {
@@ -315,50 +508,42 @@ int wait_for_session_sync(int socket)
 }
 
 // Posle nazov suboru prijemcovi
-int send_file_name(int socket, const char *file_name)
+// Za nazvom (s ukoncovacou nulou) nasleduje velkost suboru v 8 bajtoch v sietovom poradi,
+// aby si prijemca mohol vyhradit miesto pre cely subor este pred prvym blokom
+int send_file_name(int socket, const char *file_name, uint64_t file_size)
 {
-    return (send(socket, file_name, strlen(file_name) + 1, 0) > 0) ? 0 : -1;
-}
-
-// Prijme nazov suboru od odosielatela
-// - max_len: maximalna velkost buffera pre nazov suboru
-int receive_file_name(int socket, char *file_name, size_t max_len)
-{
-    memset(file_name, 0, max_len);
-    size_t total_received = 0;
-    while (total_received < max_len)
+    uint8_t message[FILE_NAME_BUFFER_SIZE + 8];
+    size_t name_len = strlen(file_name) + 1;
+    if (name_len > FILE_NAME_BUFFER_SIZE)
     {
-        ssize_t received = recv(socket, file_name + total_received, max_len - total_received, 0);
-        if (received <= 0)
-        {
-            return -1;
-        }
-        total_received += received;
-        if (file_name[total_received - 1] == '\0')
-        {
-            break;
-        }
+        return -1;
     }
-    return 0;
+    memcpy(message, file_name, name_len);
+    uint32_t size_be[2] = {htonl((uint32_t)(file_size >> 32)), htonl((uint32_t)file_size)};
+    memcpy(message + name_len, size_be, sizeof(size_be));
+    size_t total = name_len + sizeof(size_be);
+    return (send_all(socket, message, total) == (ssize_t)total) ? 0 : -1;
 }
 
-// Posle velkost datoveho bloku v sietovom poradi bytov
-int send_chunk_size_reliable(int socket, uint32_t size)
+// Rozlozi spravu s nazvom a velkostou suboru z uz prijatych bajtov (pre neblokujuci prijem)
+// Navratova hodnota: dlzka spravy v bajtoch, 0 ak sprava este nie je cela, -1 ak je neplatna
+int parse_file_name(const uint8_t *data, size_t size, char *file_name, size_t max_len, uint64_t *file_size)
 {
-    uint32_t net_size = htonl(size);
-    return (send_all(socket, &net_size, sizeof(net_size)) == sizeof(net_size)) ? 0 : -1;
-}
-
-// Prijme velkost datoveho bloku a prevedie ju do lokalneho poradia bytov
-int receive_chunk_size_reliable(int socket, uint32_t *size)
-{
-    uint32_t net_size;
-    if (recv_all(socket, &net_size, sizeof(net_size)) != sizeof(net_size))
+    const uint8_t *end = memchr(data, '\0', (size < max_len) ? size : max_len);
+    if (end == NULL)
     {
-        return -1;
+        return (size < max_len) ? 0 : -1; // Nazov bez ukoncovacej nuly
     }
-    *size = ntohl(net_size);
-    return 0;
+    size_t name_len = (size_t)(end - data) + 1;
+    uint32_t size_be[2];
+    if (size - name_len < sizeof(size_be))
+    {
+        return 0;
+    }
+    memcpy(file_name, data, name_len);
+    memcpy(size_be, end + 1, sizeof(size_be));
+    *file_size = ((uint64_t)ntohl(size_be[0]) << 32) | ntohl(size_be[1]);
+    return (int)(name_len + sizeof(size_be));
 }
 
 // Pomocna funkcia na spolahlivy prenos vsetkych dat
@@ -405,71 +590,121 @@ ssize_t recv_all(int sock, void *buf, size_t size)
     return size;
 }
 
-// Posle zasifrovany blok dat spolu s noncom a tagom
-int send_encrypted_chunk(int socket, const uint8_t *nonce, const uint8_t *tag,
-                         const uint8_t *data, size_t data_len)
+// Odosle vsetky casti vektora, jednym volanim systemu ak to socket dovoli
+// Pri ciastocnom odoslani pokracuje od prveho neodoslaneho bajtu (vektor sa pritom meni)
+static int send_vector(int socket, net_iovec_t *iov, int count)
 {
-    if (send_all(socket, nonce, NONCE_SIZE) != NONCE_SIZE ||
-        send_all(socket, tag, TAG_SIZE) != TAG_SIZE ||
-        send_all(socket, data, data_len) != (ssize_t)data_len)
+    while (count > 0)
     {
-        return -1;
+#ifdef _WIN32
+        DWORD sent_bytes = 0;
+        ssize_t sent = (WSASend(socket, iov, (DWORD)count, &sent_bytes, 0, NULL, NULL) == 0) ? (ssize_t)sent_bytes : -1;
+#else
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t sent = sendmsg(socket, &msg, SEND_FLAGS);
+#endif
+        if (sent <= 0)
+        {
+            if (errno == EINTR)
+                continue; // Prerusenie, skusi znova
+            return -1;    // Chyba
+        }
+
+        // Preskocenie uplne odoslanych casti
+        size_t done = (size_t)sent;
+        while (count > 0 && done >= IOV_LEN(*iov))
+        {
+            done -= IOV_LEN(*iov);
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            IOV_ADVANCE(*iov, done);
+        }
     }
     return 0;
 }
 
-// Prijme zasifrovany blok dat spolu s noncom a tagom
-int receive_encrypted_chunk(int sockfd, uint8_t *nonce, uint8_t *tag,
-                            uint8_t *ciphertext, uint32_t chunk_size)
+// Pripravi davku blokov - hlavicku, tag a data kazdeho bloku ako casti jedneho vektora
+// Blok vacsi nez dohodnuta velkost by druha strana odmietla, preto sa ani neposle
+int frame_batch_prepare(frame_batch_t *batch, const frame_t *frames, unsigned count, uint32_t max_size)
 {
-    // Odstrani debug vystup pre zjednodusenie konzoly
-
-    if (recv_all(sockfd, nonce, NONCE_SIZE) != NONCE_SIZE)
+    if (count > FRAME_SEND_BATCH)
     {
-        fprintf(stderr, ERR_RECEIVE_ENCRYPTED_CHUNK);
         return -1;
     }
-
-    if (recv_all(sockfd, tag, TAG_SIZE) != TAG_SIZE)
+    batch->bytes = 0;
+    for (unsigned i = 0; i < count; i++)
     {
-        fprintf(stderr, "Error: Failed to receive tag\n");
-        return -1;
+        if (frames[i].size > max_size)
+        {
+            fprintf(stderr, ERR_FRAME_SIZE, (unsigned)frames[i].size, max_size);
+            return -1;
+        }
+        // Nonce sa neposiela, obe strany ho odvodia z poradia bloku v prude
+        batch->headers[i][0] = htonl((uint32_t)frames[i].size);
+        batch->headers[i][1] = htonl(frames[i].epoch);
+        IOV_SET(batch->iov[3 * i], batch->headers[i], FRAME_HEADER_SIZE);
+        IOV_SET(batch->iov[3 * i + 1], frames[i].tag, TAG_SIZE);
+        IOV_SET(batch->iov[3 * i + 2], frames[i].data, frames[i].size);
+        batch->bytes += FRAME_HEADER_SIZE + TAG_SIZE + frames[i].size;
     }
+    batch->count = (int)(count * 3);
+    return 0;
+}
 
-    if (chunk_size > 0 && recv_all(sockfd, ciphertext, chunk_size) != (ssize_t)chunk_size)
+// Posle zasifrovane bloky - hlavicku, tag a data vsetkych blokov jednym volanim systemu
+int send_frames(int socket, const frame_t *frames, unsigned count, uint32_t max_size)
+{
+    frame_batch_t batch;
+    while (count > 0)
     {
-        fprintf(stderr, "Error: Failed to receive ciphertext (expected %u bytes)\n", chunk_size);
-        return -1;
+        unsigned size = (count > FRAME_SEND_BATCH) ? FRAME_SEND_BATCH : count;
+        if (frame_batch_prepare(&batch, frames, size, max_size) != 0 ||
+            send_vector(socket, batch.iov, batch.count) < 0)
+        {
+            return -1;
+        }
+        frames += size;
+        count -= size;
     }
-
     return 0;
 }
 
-// Posle potvrdenie uspesneho prenosu s opakovaniami
-int send_transfer_ack(int socket)
+// Zaradi pripravenu davku na odoslanie cez io_uring, odovzda ju jadru az io_ring_submit
+// Davka zacne az po dokonceni skor zaradenych davok, takze bloky idu na socket v poradi
+// Dokoncenie s poctom bajtov mensim nez batch->bytes znamena chybu spojenia
+int queue_frame_batch(io_ring_t *ring, int socket, frame_batch_t *batch, uint64_t user_data)
 {
-    int retries = MAX_RETRIES;
-
-    while (retries > 0)
-    {
-        printf(MSG_ACK_SENDING, MAX_RETRIES - retries + 1, MAX_RETRIES);
-
-        int result = send(socket, MAGIC_TACK, ACK_SIZE, SEND_FLAGS);
+#ifdef _WIN32
+    (void)ring, (void)socket, (void)batch, (void)user_data;
+    return -1; // io_uring je iba na Linuxe
+#else
+    memset(&batch->msg, 0, sizeof(batch->msg));
+    batch->msg.msg_iov = batch->iov;
+    batch->msg.msg_iovlen = batch->count;
+    return io_ring_queue_sendmsg(ring, socket, &batch->msg, user_data, SOCKET_TIMEOUT_MS);
+#endif
+}
 
-        if (result == ACK_SIZE)
-        {
-            wait();
-            return 0;
-        }
+// Posle hlavicku s velkostou 0 - za poslednym blokom suboru
+int send_end_of_frames(int socket)
+{
+    uint32_t header[2] = {0, 0};
+    return (send_all(socket, header, FRAME_HEADER_SIZE) == FRAME_HEADER_SIZE) ? 0 : -1;
+}
 
-        retries--;
-        if (retries > 0)
-        {
-            printf(MSG_ACK_RETRY, WAIT_DELAY_MS);
-            wait();
-        }
-    }
-    return -1;
+// Rozlozi hlavicku bloku (FRAME_HEADER_SIZE bajtov): velkost dat (0 = koniec suboru) a epochu kluca
+void frame_header_decode(const uint8_t *data, uint32_t *size, uint32_t *epoch)
+{
+    uint32_t header[2];
+    memcpy(header, data, FRAME_HEADER_SIZE);
+    *size = ntohl(header[0]);
+    *epoch = ntohl(header[1]);
 }
 
 // Caka na potvrdenie uspesneho prenosu s opakovaniami
@@ -13,11 +13,14 @@
  *     - Platformovo-nezavisle sietove operacie
  *     - Obsluha timeoutov a chybovych stavov
  *     - Implementacia potvrdzovacieho protokolu
+ *     - Dohodnutie parametrov relacie pri nadviazani spojenia
  *
  * Zavislosti:
  *     - Standardne C kniznice pre sietovu komunikaciu
  *     - constants.h (konstanty programu)
  *     - platform.h (platform-specificke funkcie)
+ *     - crypto_utils.h (pravidla rotacie kluca)
+ *     - io_ring.h (volitelny I/O engine io_uring)
  *******************************************************************************/
 
 #ifndef SIETE_H
@@ -25,8 +28,10 @@
 
 #include <stdint.h> // Kniznica pre datove typy (uint8_t, uint32_t)
 
-#include "constants.h" // Definicie konstant pre program
-#include "platform.h"  // Pre funkcie specificke pre operacny system
+#include "constants.h"    // Definicie konstant pre program
+#include "platform.h"     // Pre funkcie specificke pre operacny system
+#include "crypto_utils.h" // Pre pravidla rotacie kluca
+#include "io_ring.h"      // Pre volitelny I/O engine io_uring
 
 // Platformovo-specificke makra
 #ifdef _WIN32
@@ -81,6 +86,17 @@
 // Prenos dat - Windows
 #define SEND_FLAGS 0                                                        // Ziadne specialne flagy pre Windows
 #define RECV_DATA(sock, data, size) recv((sock), (char *)(data), (size), 0) // Prijatie dat na Windows
+
+// Neblokujuci rezim socketu - Windows
+#define SET_NONBLOCKING(sock) ((ioctlsocket((sock), FIONBIO, &(u_long){1}) == 0) ? 0 : -1) // Prepne socket do neblokujuceho rezimu
+#define SOCKET_WOULD_BLOCK() (WSAGetLastError() == WSAEWOULDBLOCK)                         // Neblokujuca operacia by musela cakat
+#define SET_REUSEPORT(sock) (-1)                                                           // SO_REUSEPORT Windows nema
+
+// Vektorove odosielanie - Windows
+typedef WSABUF net_iovec_t;                                                            // Jedna cast vektora
+#define IOV_SET(iov, ptr, size) ((iov).buf = (CHAR *)(ptr), (iov).len = (ULONG)(size)) // Nastavi adresu a dlzku casti
+#define IOV_LEN(iov) ((size_t)(iov).len)                                               // Dlzka casti
+#define IOV_ADVANCE(iov, n) ((iov).buf += (n), (iov).len -= (ULONG)(n))                // Preskoci n odoslanych bajtov
 #else
 // Funkcie pre uvolnenie socketov - UNIX/Linux verzie
 #define SOCKET_CLOSE(sock) close(sock) // Uzatvori socket na UNIX systemoch
@@ -126,8 +142,52 @@
 // Prenos dat - UNIX/Linux
 #define SEND_FLAGS MSG_NOSIGNAL                                  // Zabrani vzniku SIGPIPE signalu pri zavreti spojenia
 #define RECV_DATA(sock, data, size) read((sock), (data), (size)) // Prijatie dat na UNIX systemoch
+
+// Neblokujuci rezim socketu - UNIX/Linux
+#define SET_NONBLOCKING(sock) ((fcntl((sock), F_SETFL, fcntl((sock), F_GETFL, 0) | O_NONBLOCK) == 0) ? 0 : -1) // Prepne socket do neblokujuceho rezimu
+#define SOCKET_WOULD_BLOCK() (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)                        // Neblokujuca operacia by musela cakat (alebo ju prerusil signal)
+#define SET_REUSEPORT(sock) ((setsockopt((sock), SOL_SOCKET, SO_REUSEPORT, &(int){1}, sizeof(int)) == 0) ? 0 : -1)    // Viac socketov moze pocuvat na tom istom porte
+
+// Vektorove odosielanie - UNIX/Linux
+typedef struct iovec net_iovec_t;                                                                    // Jedna cast vektora
+#define IOV_SET(iov, ptr, size) ((iov).iov_base = (void *)(ptr), (iov).iov_len = (size))             // Nastavi adresu a dlzku casti
+#define IOV_LEN(iov) ((iov).iov_len)                                                                 // Dlzka casti
+#define IOV_ADVANCE(iov, n) ((iov).iov_base = (uint8_t *)(iov).iov_base + (n), (iov).iov_len -= (n)) // Preskoci n odoslanych bajtov
 #endif
 
+// Parametre relacie dohodnute pri nadviazani spojenia
+// Klient posle svoj navrh, server odpovie hodnotami, ktore obe strany pouziju
+typedef struct
+{
+    uint32_t argon2_lanes;      // Pocet liniek Argon2 pre odvodenie kluca
+    uint32_t cipher_suites;     // Navrh: maska podporovanych sad, odpoved: jedna vybrana sada
+    uint32_t frame_size;        // Najvacsia velkost bloku dat v bajtoch (FRAME_SIZE_MIN az FRAME_SIZE_MAX)
+    rotation_policy_t rotation; // Kedy odosielatel zmeni kluc (0 = limit sa nepouziva)
+} session_params_t;
+
+// Zasifrovany blok pripraveny na odoslanie
+// Na sieti: velkost dat a epocha kluca (po 4 bajty, sietove poradie), tag, zasifrovane data
+typedef struct
+{
+    const uint8_t *tag;  // Autentizacny tag bloku
+    const uint8_t *data; // Zasifrovane data
+    size_t size;         // Pocet bajtov dat
+    uint32_t epoch;      // Epocha kluca, ktorym je blok zasifrovany
+} frame_t;
+
+// Davka blokov pripravena na odoslanie jednym volanim systemu
+// Pri odosielani na pozadi musi davka (aj bloky, na ktore odkazuje) platit az do dokoncenia
+typedef struct
+{
+    uint32_t headers[FRAME_SEND_BATCH][2]; // Hlavicky blokov v sietovom poradi
+    net_iovec_t iov[FRAME_SEND_BATCH * 3]; // Hlavicka, tag a data kazdeho bloku
+    int count;                             // Pocet casti vektora
+    size_t bytes;                          // Pocet bajtov celej davky na sieti
+#ifndef _WIN32
+    struct msghdr msg; // Sprava pre sendmsg (odkazuje na iov)
+#endif
+} frame_batch_t;
+
 // Zakladne sietove funkcie
 // Funkcie pre spravu socketov a inicializaciu siete
 void cleanup_socket(int sock);                       // Uvolni jeden socket
@@ -138,41 +198,52 @@ void wait(void);                                     // Cakacia funkcia pre sync
 void set_timeout_options(int sock);                  // Nastavenie timeoutu pre socket
 void cleanup_network(void);                          // Ukoncenie Winsock pre Windows
 void set_socket_timeout(int sock, int timeout_ms);   // Nastavenie timeoutu pre socket
+int set_socket_nonblocking(int sock);                // Prepnutie socketu do neblokujuceho rezimu
 
 // Pomocne funkcie pre prenos dat
 ssize_t send_all(int sock, const void *buf, size_t size);
 ssize_t recv_all(int sock, void *buf, size_t size);
 
-// Pomocne funkcie pre spravu chunkov
-int send_chunk_size_reliable(int socket, uint32_t size);
-int receive_chunk_size_reliable(int socket, uint32_t *size);
-
 // Serverove funkcie
 // Funkcie potrebne pre vytvorenie a spravu serverovej casti
-int setup_server(int port);                                                   // Vytvori a nakonfiguruje server socket na danom porte
+int setup_server(int port, int reuse_port);                                   // Vytvori a nakonfiguruje server socket na danom porte
 int accept_client_connection(int server_fd, struct sockaddr_in *client_addr); // Prijme spojenie od klienta
-int send_ready_signal(int socket);                                            // Posle signal pripravenosti klientovi
-int receive_salt(int socket, uint8_t *salt);                                  // Prijme kryptograficku sol
-int send_key_acknowledgment(int socket);                                      // Posle potvrdenie o prijati kluca
+int session_params_choose(const session_params_t *proposed,                   // Z navrhu klienta vyberie dohodnute parametre (bez posielania)
+                          session_params_t *params);
 
 // Klientske funkcie
 // Funkcie potrebne pre vytvorenie a spravu klientskej casti
 int connect_to_server(const char *address, int port);     // Pripoji sa k serveru na danom porte
 int wait_for_ready(int socket);                           // Caka na signal pripravenosti
-int send_salt_to_server(int socket, const uint8_t *salt); // Posle sol serveru
-int wait_for_key_acknowledgment(int socket);              // Caka na potvrdenie kluca
+int send_salt_to_server(int socket, const uint8_t *client_id, // Posle identifikator klienta a sol serveru
+                        const uint8_t *salt);
+int receive_psk_salt(int socket, uint8_t *psk_salt);          // Prijme sol servera pre PSK z hesla
+int wait_for_key_acknowledgment(int socket);                  // Caka na potvrdenie kluca
+int negotiate_session_params_client(int socket,               // Posle navrh parametrov a prijme dohodnute hodnoty
+                                    session_params_t *params, // (transcript dostane SESSION_TRANSCRIPT_SIZE bajtov pre SAKE)
+                                    uint8_t *transcript);
+
+// Identifikator klienta na sieti (CLIENT_ID_SIZE bajtov doplnenych nulami)
+int client_id_encode(const char *id, uint8_t *data); // Zakoduje identifikator, -1 ak je neplatny
+int client_id_decode(const uint8_t *data, char *id); // Dekoduje a overi identifikator (id ma CLIENT_ID_SIZE + 1 znakov)
+
+// Parametre relacie na sieti (SESSION_PARAMS_WIRE_SIZE bajtov)
+void session_params_encode(const session_params_t *params, uint8_t *data); // Zakoduje parametre v sietovom poradi
+int session_params_decode(const uint8_t *data, session_params_t *params);  // Dekoduje parametre a overi ich rozsah
 
 // Funkcie pre prenos suborov
 // Zdielane funkcie pre prenos zasifrovanych dat
-int send_file_name(int socket, const char *file_name);                         // Posle nazov suboru
-int receive_file_name(int socket, char *file_name, size_t max_len);            // Prijme nazov suboru
-int send_encrypted_chunk(int socket, const uint8_t *nonce, const uint8_t *tag, // Posle zasifrovany blok
-                         const uint8_t *data, size_t data_len);
-
-int receive_encrypted_chunk(int sockfd, uint8_t *nonce, uint8_t *tag,
-                            uint8_t *ciphertext, uint32_t chunk_size); // Prijme zasifrovany blok
-int send_transfer_ack(int socket);                                     // Posle potvrdenie o prenose
-int wait_for_transfer_ack(int socket);                                 // Caka na potvrdenie o prenose
+int send_file_name(int socket, const char *file_name, uint64_t file_size);             // Posle nazov a velkost suboru (FILE_SIZE_UNKNOWN ak ju nepozna)
+int parse_file_name(const uint8_t *data, size_t size, char *file_name,                 // Rozlozi spravu s nazvom z prijatych bajtov (0 = este nie je cela)
+                    size_t max_len, uint64_t *file_size);
+int send_frames(int socket, const frame_t *frames, unsigned count, uint32_t max_size); // Posle bloky jednym volanim systemu (nonce sa neposiela)
+int frame_batch_prepare(frame_batch_t *batch, const frame_t *frames,                   // Pripravi davku najviac FRAME_SEND_BATCH blokov
+                        unsigned count, uint32_t max_size);
+int queue_frame_batch(io_ring_t *ring, int socket, frame_batch_t *batch,               // Zaradi davku na odoslanie na pozadi (po predchadzajucich)
+                      uint64_t user_data);
+int send_end_of_frames(int socket);                                                    // Posle hlavicku s velkostou 0 (koniec suboru)
+void frame_header_decode(const uint8_t *data, uint32_t *size, uint32_t *epoch);        // Rozlozi uz prijatu hlavicku bloku
+int wait_for_transfer_ack(int socket);                                                 // Caka na potvrdenie o prenose
 
 // Funkcie pre synchronizaciu
 int send_session_sync(int socket);     // Posle synchronizacnu spravu
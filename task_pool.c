@@ -0,0 +1,114 @@
+/********************************************************************************
+ * Program:    Spolocna skupina vlakien pre zabezpeceny prenos suborov
+ * Subor:      task_pool.c
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Implementacia skupiny vlakien so spolocnou frontou uloh:
+ *     - Kazde vlakno berie ulohy z fronty, kym skupina nekonci
+ *     - Pri ukonceni sa najprv vykonaju vsetky zaradene ulohy
+ *
+ * Zavislosti:
+ *     - task_pool.h (deklaracie funkcii)
+ *     - platform.h (vlakna a ich synchronizacia)
+ *******************************************************************************/
+
+#include <string.h> // Kniznica pre pracu s pamatou
+
+#include "task_pool.h" // Deklaracie funkcii
+#include "platform.h"  // Pre vlakna a ich synchronizaciu
+
+// Vlakno skupiny - vykonava ulohy z fronty, kym nie je prazdna a skupina nekonci
+static void task_pool_worker(void *arg)
+{
+    task_pool_t *pool = (task_pool_t *)arg;
+
+    platform_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        task_t *task = pool->head;
+        if (task == NULL)
+        {
+            if (pool->stop)
+            {
+                break;
+            }
+            platform_cond_wait(&pool->changed, &pool->lock);
+            continue;
+        }
+        pool->head = task->next;
+        if (pool->head == NULL)
+        {
+            pool->tail = NULL;
+        }
+
+        // Po zavolani fn moze volajuci ulohu hned pouzit znova, preto sa uz nepouziva
+        platform_mutex_unlock(&pool->lock);
+        task->fn(task->arg);
+        platform_mutex_lock(&pool->lock);
+    }
+    platform_mutex_unlock(&pool->lock);
+}
+
+// Spustenie skupiny s danym poctom vlakien (najviac TASK_POOL_MAX_THREADS)
+// Navratova hodnota: 0 ak bezi aspon jedno vlakno, -1 inak
+int task_pool_init(task_pool_t *pool, unsigned threads)
+{
+    memset(pool, 0, sizeof(*pool));
+    platform_mutex_init(&pool->lock);
+    platform_cond_init(&pool->changed);
+
+    if (threads > TASK_POOL_MAX_THREADS)
+    {
+        threads = TASK_POOL_MAX_THREADS;
+    }
+    while (pool->nb_threads < threads &&
+           platform_thread_create(&pool->threads[pool->nb_threads], task_pool_worker, pool) == 0)
+    {
+        pool->nb_threads++;
+    }
+    if (pool->nb_threads == 0)
+    {
+        platform_cond_destroy(&pool->changed);
+        platform_mutex_destroy(&pool->lock);
+        return -1;
+    }
+    return 0;
+}
+
+// Zaradenie ulohy na koniec fronty, vykona ju prve volne vlakno
+void task_pool_submit(task_pool_t *pool, task_t *task)
+{
+    task->next = NULL;
+    platform_mutex_lock(&pool->lock);
+    if (pool->tail != NULL)
+    {
+        pool->tail->next = task;
+    }
+    else
+    {
+        pool->head = task;
+    }
+    pool->tail = task;
+    platform_cond_signal(&pool->changed); // Jednu ulohu staci zobudit jednemu vlaknu
+    platform_mutex_unlock(&pool->lock);
+}
+
+// Ukoncenie skupiny - vlakna dokoncia zaradene ulohy a skoncia
+void task_pool_free(task_pool_t *pool)
+{
+    platform_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    platform_cond_broadcast(&pool->changed);
+    platform_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->nb_threads; i++)
+    {
+        platform_thread_join(&pool->threads[i]);
+    }
+    platform_cond_destroy(&pool->changed);
+    platform_mutex_destroy(&pool->lock);
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************
+ * Program:    Spolocna skupina vlakien pre zabezpeceny prenos suborov
+ * Subor:      task_pool.h
+ * Autor:      Jozef Kovalcin
+ * Verzia:     1.0.0
+ * Datum:      05-03-2025
+ *
+ * Popis:
+ *     Hlavickovy subor pre skupinu vlakien, ktora vykonava ulohy z jednej fronty:
+ *     - Pevny pocet vlakien spusteny raz pre cely beh programu
+ *     - Ulohy v poradi, v akom prisli (bez alokacie - uloha je sucastou volajuceho)
+ *     - Reaktor servera tak odovzda narocne vypocty (Argon2, desifrovanie blokov)
+ *       a sam nikdy nepocita ani neblokuje
+ *
+ * Zavislosti:
+ *     - platform.h (vlakna a ich synchronizacia)
+ *     - constants.h (konstanty programu)
+ ******************************************************************************/
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include "platform.h"  // Pre vlakna a ich synchronizaciu
+#include "constants.h" // Definicie konstant pre program
+
+// Jedna uloha vo fronte - patri volajucemu a musi platit, kym sa nevykona
+typedef struct task
+{
+    void (*fn)(void *arg); // Funkcia vykonana vo vlakne skupiny
+    void *arg;             // Argument funkcie
+    struct task *next;     // Dalsia uloha vo fronte
+} task_t;
+
+// Skupina vlakien so spolocnou frontou uloh
+typedef struct
+{
+    platform_thread_t threads[TASK_POOL_MAX_THREADS]; // Vlakna skupiny
+    unsigned nb_threads;                              // Pocet spustenych vlakien
+    task_t *head;                                     // Prva uloha vo fronte
+    task_t *tail;                                     // Posledna uloha vo fronte
+    int stop;                                         // 1 ak maju vlakna po vyprazdneni fronty skoncit
+    platform_mutex_t lock;                            // Chrani frontu a stop
+    platform_cond_t changed;                          // Nova uloha alebo stop
+} task_pool_t;
+
+int task_pool_init(task_pool_t *pool, unsigned threads); // Spusti vlakna, -1 ak sa nespusti ziadne
+void task_pool_submit(task_pool_t *pool, task_t *task);  // Zaradi ulohu na koniec fronty
+void task_pool_free(task_pool_t *pool);                  // Vykona zvysne ulohy a ukonci vlakna
+
+#endif // TASK_POOL_H